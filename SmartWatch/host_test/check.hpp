@@ -0,0 +1,30 @@
+/**
+ * @file check.hpp
+ * @author 李威延
+ * @brief 主机测试用的最小断言，失败时打印位置并让测试返回非0
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#include <stdio.h>
+#include <chrono>
+
+inline int check_failed = 0;
+
+#define CHECK(cond) do{ \
+        if(!(cond)){ \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            check_failed++; \
+        } \
+    }while(0)
+
+#define CHECK_RESULT() ((check_failed == 0) ? (printf("passed\n"), 0) : (printf("%d checks failed\n", check_failed), 1))
+
+/*基准测试计时*/
+inline double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,137 @@
+/**
+ * @file decoded_cache_test.cpp
+ * @author 李威延
+ * @brief 解码结果缓存：按JpegDecoder的note_played/acquire_decoded/admit_decoded回放循环动画，
+ *        对比按离下一次使用最远淘汰和LRU淘汰的命中率
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include "check.hpp"
+#include "JpegCachePolicy.hpp"
+
+using namespace fml;
+
+/*与JpegDecoder.hpp和bll.hpp一致*/
+#define DECODED_CACHE_MAX       (16)
+#define DECODED_CACHE_BYTES     (1024*1024)
+#define FRAME_BYTES             (240*280*2)
+
+struct entry_t{
+    int jpeg_index;                 /*0表示空闲*/
+    bool valid;
+    int busy;
+};
+
+/*只有一个素材段[1,len]的解码结果缓存*/
+struct decoded_cache_t{
+    int len;
+    int last = 0;
+    entry_t entries[DECODED_CACHE_MAX] = {};
+    size_t bytes = 0;
+    int hit = 0;
+    int miss = 0;
+
+    explicit decoded_cache_t(int n) : len(n) {}
+
+    int distance(int jpeg_index){ return jpeg_cache_policy::loop_distance(jpeg_index, 1, len, last); }
+    bool find(int jpeg_index)
+    {
+        for(auto& e : entries)if(e.jpeg_index == jpeg_index && e.valid)return true;
+        return false;
+    }
+    void admit(int jpeg_index)
+    {
+        int d = distance(jpeg_index);
+        while(1){
+            entry_t* slot = NULL;
+            for(auto& e : entries){
+                if(e.jpeg_index == 0){ if(slot == NULL)slot = &e; continue; }
+                if(e.jpeg_index == jpeg_index)return;
+            }
+            if(slot != NULL && bytes + FRAME_BYTES <= DECODED_CACHE_BYTES){
+                *slot = {jpeg_index, true, 0};
+                bytes += FRAME_BYTES;
+                return;
+            }
+            entry_t* victim = jpeg_cache_policy::farthest_victim(entries, DECODED_CACHE_MAX, d,
+                                    [this](int i){ return distance(i); });
+            if(victim == NULL)return;
+            memset(victim, 0, sizeof(entry_t));
+            bytes -= FRAME_BYTES;
+        }
+    }
+    void play(int jpeg_index)
+    {
+        last = jpeg_index;
+        if(find(jpeg_index)){
+            hit++;
+        }else{
+            miss++;
+            admit(jpeg_index);
+        }
+    }
+};
+
+/*对比用：同样预算下的LRU*/
+static int lru_hits(int len, int loops)
+{
+    std::vector<int> lru;
+    int capacity = DECODED_CACHE_BYTES / FRAME_BYTES, hit = 0;
+    for(int l = 0; l < loops; l++){
+        for(int j = 1; j <= len; j++){
+            auto it = std::find(lru.begin(), lru.end(), j);
+            if(it != lru.end()){
+                hit++;
+                lru.erase(it);
+            }else if((int)lru.size() >= capacity){
+                lru.erase(lru.begin());
+            }
+            lru.push_back(j);
+        }
+    }
+    return hit;
+}
+
+int main()
+{
+    /*循环距离*/
+    CHECK(jpeg_cache_policy::loop_distance(5, 1, 10, 0) == 10);         /*没有播放记录*/
+    CHECK(jpeg_cache_policy::loop_distance(5, 1, 10, 4) == 1);
+    CHECK(jpeg_cache_policy::loop_distance(5, 1, 10, 5) == 10);         /*刚播放过，一整圈后才再用到*/
+    CHECK(jpeg_cache_policy::loop_distance(2, 1, 10, 9) == 3);          /*绕回段首*/
+    CHECK(jpeg_cache_policy::loop_distance(23, 21, 30, 30) == 3);       /*段不从1开始*/
+
+    /*淘汰项的选择*/
+    entry_t entries[5] = {{0, false, 0}, {3, true, 0}, {8, true, 0}, {9, false, 1}, {7, true, 1}};
+    auto distance_of = [](int i){ return jpeg_cache_policy::loop_distance(i, 1, 10, 2); };
+    /*空闲、填充中、读取中的项跳过，7虽然最远但正在读取*/
+    CHECK(jpeg_cache_policy::farthest_victim(entries, 5, 1, distance_of) == &entries[2]);
+    /*新帧比所有项都更晚用到时不淘汰*/
+    CHECK(jpeg_cache_policy::farthest_victim(entries, 5, 6, distance_of) == NULL);
+    CHECK(jpeg_cache_policy::farthest_victim(entries, 0, 1, distance_of) == NULL);
+
+    /*基准：不同长度的循环动画各播放10遍*/
+    const int loops = 10;
+    const int lens[] = {4, 7, 8, 12, 20, 40};
+    int capacity = DECODED_CACHE_BYTES / FRAME_BYTES;
+    for(int len : lens){
+        decoded_cache_t cache(len);
+        for(int l = 0; l < loops; l++)for(int j = 1; j <= len; j++)cache.play(j);
+        int lru = lru_hits(len, loops);
+        int total = len * loops;
+        printf("loop %2d frames, %d fit: farthest %3d/%d hits (%3d%%), lru %3d/%d hits (%3d%%)\n",
+                len, capacity, cache.hit, total, cache.hit * 100 / total, lru, total, lru * 100 / total);
+        CHECK(cache.bytes <= DECODED_CACHE_BYTES);
+        CHECK(cache.hit >= lru);
+        /*第一遍之后每一遍命中缓存能放下的帧数*/
+        CHECK(cache.hit == (loops - 1) * std::min(len, capacity));
+        if(len > capacity)CHECK(lru == 0);
+    }
+    return CHECK_RESULT();
+}
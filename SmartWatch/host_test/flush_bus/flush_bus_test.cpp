@@ -0,0 +1,138 @@
+/**
+ * @file flush_bus_test.cpp
+ * @author 李威延
+ * @brief 桩总线上回放LVGL局部渲染的刷屏顺序：检查总线占用的先后顺序，对比同步刷屏和DMA刷屏的帧时间
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include <stdint.h>
+#include <algorithm>
+#include "check.hpp"
+#include "flush_tracker.hpp"
+
+using namespace hdl;
+
+/*与hdl_config.hpp一致*/
+#define WRITE_FREQ              (80 * 1000 * 1000)
+#define WIDTH                   (240)
+#define HEIGHT                  (280)
+#define STRIPE_LINES            (40)
+#define WINDOW_US               (2.0)       /*设置窗口的命令开销*/
+#define DMA_SETUP_US            (5.0)       /*启动一次DMA传输的开销*/
+
+/*桩总线：虚拟时钟上记录传输时间，同时检查调用顺序*/
+struct stub_bus{
+    double now = 0;
+    double dma_end = 0;
+    bool in_write = false;
+    bool dma_active = false;
+    int errors = 0;
+    int windows = 0;
+    int writes = 0;
+
+    static double transfer_us(uint32_t len){ return (double)len * 16 * 1000000 / WRITE_FREQ; }
+    void startWrite(){ if(in_write)errors++; in_write = true; }
+    void setWindow(int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+    {
+        /*DMA传输中不能改窗口*/
+        if(!in_write || dma_active || x2 < x1 || y2 < y1)errors++;
+        windows++;
+        now += WINDOW_US;
+    }
+    void writePixels(uint32_t len)
+    {
+        if(!in_write || dma_active)errors++;
+        writes++;
+        now += transfer_us(len);
+    }
+    void writePixelsDMA(uint32_t len)
+    {
+        if(!in_write || dma_active)errors++;
+        writes++;
+        dma_active = true;
+        now += DMA_SETUP_US;
+        dma_end = now + transfer_us(len);
+    }
+    void waitDMA()
+    {
+        if(!dma_active)return;
+        now = std::max(now, dma_end);
+        dma_active = false;
+    }
+    void endWrite(){ if(!in_write || dma_active)errors++; in_write = false; }
+};
+
+/*与lvgl.hpp的_disp_flush/_disp_flush_dma/_disp_flush_wait相同的调用顺序*/
+static void disp_flush(flush_tracker<stub_bus>& tracker, stub_bus& bus, int y1, int y2)
+{
+    tracker.begin(bus, 0, y1, WIDTH - 1, y2);
+    bus.writePixels(WIDTH * (y2 - y1 + 1));
+    tracker.end(bus);
+}
+
+static void disp_flush_dma(flush_tracker<stub_bus>& tracker, stub_bus& bus, int y1, int y2)
+{
+    tracker.begin(bus, 0, y1, WIDTH - 1, y2);
+    bus.writePixelsDMA(WIDTH * (y2 - y1 + 1));
+    tracker.end_dma();
+}
+
+/*一帧整屏重绘：LVGL双缓冲时先渲染到空闲的缓冲区，刷屏前等待上一次传输，帧结束时再等待一次*/
+static double replay_frame(bool dma, double render_us, int* errors)
+{
+    stub_bus bus;
+    flush_tracker<stub_bus> tracker;
+    for(int y = 0; y < HEIGHT; y += STRIPE_LINES){
+        bus.now += render_us;
+        if(dma){
+            tracker.wait(bus);
+            disp_flush_dma(tracker, bus, y, y + STRIPE_LINES - 1);
+        }else{
+            disp_flush(tracker, bus, y, y + STRIPE_LINES - 1);
+        }
+    }
+    tracker.wait(bus);
+    if(bus.in_write || bus.dma_active || tracker.pending())bus.errors++;
+    if(bus.windows != HEIGHT / STRIPE_LINES || bus.writes != HEIGHT / STRIPE_LINES)bus.errors++;
+    *errors += bus.errors;
+    return bus.now;
+}
+
+int main()
+{
+    /*记录本身*/
+    stub_bus bus;
+    flush_tracker<stub_bus> tracker;
+    CHECK(!tracker.wait(bus));                      /*没有传输时不等待，也不释放总线*/
+    CHECK(bus.errors == 0);
+    disp_flush_dma(tracker, bus, 0, 39);
+    CHECK(tracker.pending() && bus.in_write && bus.dma_active);
+    CHECK(tracker.wait(bus));
+    CHECK(!tracker.pending() && !bus.in_write && !bus.dma_active);
+    CHECK(bus.now >= stub_bus::transfer_us(WIDTH * 40));
+    CHECK(!tracker.wait(bus));                      /*重复调用不会再次endWrite*/
+    disp_flush(tracker, bus, 40, 79);
+    CHECK(!tracker.pending() && !bus.in_write);
+    CHECK(bus.errors == 0);
+
+    /*基准：不同渲染耗时下的整帧时间*/
+    int errors = 0;
+    double stripe_us = stub_bus::transfer_us(WIDTH * STRIPE_LINES);
+    printf("stripe %dx%d: transfer %.0fus\n", WIDTH, STRIPE_LINES, stripe_us);
+    const double render_us[] = {500, 1000, 2000, 3000, 5000};
+    for(double r : render_us){
+        double sync_us = replay_frame(false, r, &errors);
+        double dma_us = replay_frame(true, r, &errors);
+        printf("render %4.0fus/stripe: sync %6.0fus (%4.1ffps), dma %6.0fus (%4.1ffps), %.0f%% faster\n",
+                r, sync_us, 1000000 / sync_us, dma_us, 1000000 / dma_us, (sync_us - dma_us) * 100 / sync_us);
+        CHECK(dma_us < sync_us);
+        /*传输被渲染完全覆盖时，DMA的帧时间只比纯渲染多最后一个条带的传输*/
+        double overlap_bound = (HEIGHT / STRIPE_LINES) * (std::max(r, stripe_us) + WINDOW_US + DMA_SETUP_US) + stripe_us;
+        CHECK(dma_us <= overlap_bound);
+    }
+    CHECK(errors == 0);
+    return CHECK_RESULT();
+}
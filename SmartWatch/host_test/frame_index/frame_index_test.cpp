@@ -0,0 +1,118 @@
+/**
+ * @file frame_index_test.cpp
+ * @author 李威延
+ * @brief 帧目录排序：序号位数不一致、没有序号的文件，以及1000个文件的建立索引耗时
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <random>
+#include "check.hpp"
+#include "JpegFrameIndex.hpp"
+
+using namespace fml;
+
+#define FRAME_NUMBER            (1000)
+#define BENCH_ROUNDS            (20)
+
+static void touch(const std::string& path)
+{
+    FILE* f = fopen(path.c_str(), "w");
+    if(f != NULL)fclose(f);
+}
+
+/*同一个序号用不同的位数写出，模拟不同工具导出的帧*/
+static std::string frame_name(int i)
+{
+    char name[32];
+    switch(i % 4){
+        case 0:  snprintf(name, sizeof(name), "frame_%d.jpg", i); break;
+        case 1:  snprintf(name, sizeof(name), "frame_%02d.jpg", i); break;
+        case 2:  snprintf(name, sizeof(name), "frame_%04d.jpg", i); break;
+        default: snprintf(name, sizeof(name), "%03d.jpg", i); break;
+    }
+    return name;
+}
+
+int main()
+{
+    long n = 0;
+    CHECK(jpeg_frame_index::get_frame_number("frame_002.jpg", &n) && n == 2);
+    CHECK(jpeg_frame_index::get_frame_number("10", &n) && n == 10);
+    CHECK(jpeg_frame_index::get_frame_number("a1b23.jpg", &n) && n == 23);        /*只取最后一段数字*/
+    CHECK(!jpeg_frame_index::get_frame_number("cover.jpg", &n));
+    CHECK(!jpeg_frame_index::get_frame_number("frame_1x.jpg", &n));
+    /*按数值而不是字典序*/
+    CHECK(jpeg_frame_index::frame_name_less("2.jpg", "10.jpg"));
+    CHECK(jpeg_frame_index::frame_name_less("01.jpg", "10.jpg"));
+    CHECK(jpeg_frame_index::frame_name_less("9.jpg", "010.jpg"));
+    CHECK(!jpeg_frame_index::frame_name_less("10.jpg", "002.jpg"));
+    /*序号相同时按字典序，排序结果稳定*/
+    CHECK(jpeg_frame_index::frame_name_less("01.jpg", "1.jpg"));
+    CHECK(!jpeg_frame_index::frame_name_less("1.jpg", "01.jpg"));
+    /*没有序号的排在后面*/
+    CHECK(jpeg_frame_index::frame_name_less("999.jpg", "cover.jpg"));
+    CHECK(!jpeg_frame_index::frame_name_less("cover.jpg", "1.jpg"));
+    CHECK(jpeg_frame_index::frame_name_less("cover.jpg", "readme"));
+
+    /*打乱顺序创建文件，readdir的顺序与创建顺序无关*/
+    char dir_template[] = "/tmp/frame_index_XXXXXX";
+    char* dir = mkdtemp(dir_template);
+    CHECK(dir != NULL);
+    if(dir == NULL)return CHECK_RESULT();
+    std::vector<int> order;
+    for(int i = 1; i <= FRAME_NUMBER; i++)order.push_back(i);
+    std::shuffle(order.begin(), order.end(), std::mt19937(1));
+    for(int i : order)touch(std::string(dir) + "/" + frame_name(i));
+    touch(std::string(dir) + "/readme");
+    touch(std::string(dir) + "/cover.jpg");
+    mkdir((std::string(dir) + "/0").c_str(), 0755);     /*子目录不算帧*/
+
+    std::vector<std::string> filenames;
+    CHECK(jpeg_frame_index::scan_dir(dir, filenames));
+    CHECK(filenames.size() == FRAME_NUMBER + 2);
+    bool in_order = true;
+    for(int i = 1; i <= FRAME_NUMBER && i <= (int)filenames.size(); i++){
+        if(filenames[i - 1] != frame_name(i))in_order = false;
+    }
+    CHECK(in_order);
+    if(filenames.size() == FRAME_NUMBER + 2){
+        CHECK(filenames[FRAME_NUMBER] == "cover.jpg");
+        CHECK(filenames[FRAME_NUMBER + 1] == "readme");
+    }
+    CHECK(!jpeg_frame_index::scan_dir("/tmp/frame_index_does_not_exist", filenames));
+
+    /*基准：遍历并排序1000个文件，与只按字典序排序对比*/
+    auto start = std::chrono::steady_clock::now();
+    for(int r = 0; r < BENCH_ROUNDS; r++){
+        filenames.clear();
+        jpeg_frame_index::scan_dir(dir, filenames);
+    }
+    double scan_ms = elapsed_ms(start) / BENCH_ROUNDS;
+    start = std::chrono::steady_clock::now();
+    for(int r = 0; r < BENCH_ROUNDS; r++){
+        std::shuffle(filenames.begin(), filenames.end(), std::mt19937(r));
+        std::sort(filenames.begin(), filenames.end(), jpeg_frame_index::frame_name_less);
+    }
+    double sort_ms = elapsed_ms(start) / BENCH_ROUNDS;
+    start = std::chrono::steady_clock::now();
+    for(int r = 0; r < BENCH_ROUNDS; r++){
+        std::shuffle(filenames.begin(), filenames.end(), std::mt19937(r));
+        std::sort(filenames.begin(), filenames.end());
+    }
+    double lex_ms = elapsed_ms(start) / BENCH_ROUNDS;
+    printf("%d files: scan_dir %.3fms, frame_name_less sort %.3fms, lexicographic sort %.3fms\n",
+            FRAME_NUMBER + 2, scan_ms, sort_ms, lex_ms);
+
+    for(int i = 1; i <= FRAME_NUMBER; i++)unlink((std::string(dir) + "/" + frame_name(i)).c_str());
+    unlink((std::string(dir) + "/readme").c_str());
+    unlink((std::string(dir) + "/cover.jpg").c_str());
+    rmdir((std::string(dir) + "/0").c_str());
+    rmdir(dir);
+    return CHECK_RESULT();
+}
@@ -0,0 +1,171 @@
+/**
+ * @file jpeg_cache_test.cpp
+ * @author 李威延
+ * @brief 压缩帧缓存：按JpegDecoder的acquire_frame/read_ahead/evict_for回放循环播放，检查淘汰顺序和预算，统计解码路径上的同步读取
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "check.hpp"
+#include "JpegCachePolicy.hpp"
+
+using namespace fml;
+
+/*与JpegDecoder.hpp一致*/
+#define CACHE_BYTES             (160*1024)
+#define FRAME_BYTES             (12*1024)       /*240x280壁纸帧压缩后的典型大小*/
+
+/*只有缓存状态的JpegDecoder，读入帧只记账不读文件*/
+struct frame_cache_t{
+    int number;
+    std::vector<uint8_t*> buff;
+    std::vector<int> len;
+    std::vector<uint32_t> last_use;
+    std::vector<uint8_t> pinned;
+    std::vector<uint8_t> busy;
+    uint32_t use_clock = 0;
+    size_t cache_bytes = 0;
+    size_t max_bytes = 0;
+    int sync_loads = 0;             /*解码路径上的同步读取*/
+    int ahead_loads = 0;            /*预读*/
+    uint8_t dummy = 0;
+
+    explicit frame_cache_t(int n) : number(n), buff(n, nullptr), len(n, FRAME_BYTES), last_use(n, 0), pinned(n, 0), busy(n, 0) {}
+
+    void load(int i)
+    {
+        buff[i] = &dummy;
+        last_use[i] = ++use_clock;
+        cache_bytes += len[i];
+        if(cache_bytes > max_bytes)max_bytes = cache_bytes;
+    }
+    bool evict_for(size_t need, uint32_t keep_clock)
+    {
+        while(cache_bytes + need > CACHE_BYTES){
+            int lru = jpeg_cache_policy::lru_victim(number, buff.data(), pinned.data(), busy.data(), last_use.data(), keep_clock);
+            if(lru < 0)return false;
+            buff[lru] = nullptr;
+            cache_bytes -= len[lru];
+        }
+        return true;
+    }
+    void acquire(int i)
+    {
+        if(buff[i] != nullptr){
+            last_use[i] = ++use_clock;
+        }else{
+            sync_loads++;
+            evict_for(len[i], UINT32_MAX);
+            load(i);
+        }
+        busy[i]++;
+    }
+    void release(int i){ busy[i]--; }
+    void read_ahead(int jpeg_index, int start, int end, int count)
+    {
+        uint32_t keep_clock = last_use[jpeg_index - 1];
+        int index = jpeg_index;
+        for(int n = 0; n < count; n++){
+            index++;
+            if(index > end)index = start;
+            if(index == jpeg_index)break;
+            int i = index - 1;
+            if(buff[i] != nullptr){
+                last_use[i] = ++use_clock;
+                continue;
+            }
+            if(!evict_for(len[i], keep_clock))break;
+            ahead_loads++;
+            load(i);
+        }
+    }
+};
+
+/*循环播放[start,end]共loops遍，每一帧在解码前后持有帧，解码完预读后续帧*/
+static void play(frame_cache_t* cache, int start, int end, int loops, int read_ahead, bool* window_kept)
+{
+    for(int l = 0; l < loops; l++){
+        for(int j = start; j <= end; j++){
+            cache->acquire(j - 1);
+            cache->read_ahead(j, start, end, read_ahead);
+            /*当前帧和预读窗口都在缓存中*/
+            int index = j;
+            for(int n = 0; n <= read_ahead && n < end - start + 1; n++){
+                if(cache->buff[index - 1] == nullptr)*window_kept = false;
+                if(++index > end)index = start;
+            }
+            cache->release(j - 1);
+        }
+    }
+}
+
+int main()
+{
+    /*淘汰顺序*/
+    uint8_t d = 0;
+    uint8_t* buff[6] = {&d, &d, nullptr, &d, &d, &d};
+    uint8_t pinned[6] = {0, 1, 0, 0, 0, 0};
+    uint8_t busy[6] = {0, 0, 0, 1, 0, 0};
+    uint32_t last_use[6] = {5, 1, 0, 2, 3, 9};
+    CHECK(jpeg_cache_policy::lru_victim(6, buff, pinned, busy, last_use, UINT32_MAX) == 4);    /*跳过常驻的1、没读入的2、解码中的3*/
+    CHECK(jpeg_cache_policy::lru_victim(6, buff, pinned, busy, last_use, 3) == -1);            /*3之后用过的不淘汰*/
+    CHECK(jpeg_cache_policy::lru_victim(6, buff, pinned, busy, last_use, 6) == 4);
+    busy[4] = 1;
+    CHECK(jpeg_cache_policy::lru_victim(6, buff, pinned, busy, last_use, UINT32_MAX) == 0);
+    CHECK(jpeg_cache_policy::lru_victim(0, buff, pinned, busy, last_use, UINT32_MAX) == -1);
+
+    /*40帧的循环动画(480KB)放不进160KB缓存*/
+    const int frames = 40;
+    const int read_ahead_values[] = {0, 1, 3, 6};
+    for(int ra : read_ahead_values){
+        frame_cache_t cache(frames);
+        bool window_kept = true;
+        play(&cache, 1, frames, 3, ra, &window_kept);
+        printf("read_ahead %d: %d sync loads, %d read-ahead loads in %d frames, peak %dKB/%dKB\n",
+                ra, cache.sync_loads, cache.ahead_loads, frames * 3, (int)(cache.max_bytes / 1024), CACHE_BYTES / 1024);
+        CHECK(cache.max_bytes <= CACHE_BYTES);
+        CHECK(window_kept);
+        /*预读之后只有第一帧在解码路径上同步读取*/
+        if(ra > 0)CHECK(cache.sync_loads == 1);
+        else CHECK(cache.sync_loads == frames * 3);
+    }
+
+    /*常驻帧不计入预算也不被淘汰*/
+    {
+        frame_cache_t cache(frames);
+        for(int i = 0; i < 4; i++){
+            cache.buff[i] = &cache.dummy;
+            cache.pinned[i] = 1;
+        }
+        bool window_kept = true;
+        play(&cache, 5, frames, 2, 3, &window_kept);
+        bool pinned_kept = true;
+        for(int i = 0; i < 4; i++)if(cache.buff[i] == nullptr)pinned_kept = false;
+        CHECK(pinned_kept);
+        CHECK(window_kept);
+        CHECK(cache.max_bytes <= CACHE_BYTES);
+    }
+
+    /*基准：淘汰时线性扫描所有帧，1000帧时每次选择的耗时*/
+    {
+        const int number = 1000;
+        std::vector<uint8_t*> b(number, &d);
+        std::vector<uint8_t> p(number, 0), u(number, 0);
+        std::vector<uint32_t> lu(number);
+        for(int i = 0; i < number; i++)lu[i] = (uint32_t)rand();
+        const int rounds = 20000;
+        volatile int sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(int r = 0; r < rounds; r++){
+            lu[r % number] = (uint32_t)rand();
+            sink += jpeg_cache_policy::lru_victim(number, b.data(), p.data(), u.data(), lu.data(), UINT32_MAX);
+        }
+        printf("lru_victim over %d frames: %.2fus per call\n", number, elapsed_ms(start) * 1000 / rounds);
+    }
+    return CHECK_RESULT();
+}
@@ -0,0 +1,147 @@
+/**
+ * @file te_window_test.cpp
+ * @author 李威延
+ * @brief 按hdl_config.hpp的面板参数模拟扫描，回放局部渲染的刷屏时间线，检查写入不会跨越光栅
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include <stdlib.h>
+#include <math.h>
+#include "check.hpp"
+#include "te_window.hpp"
+
+using namespace hdl;
+
+/*与hdl_config.hpp一致*/
+#define PERIOD_US               (16667)
+#define SCAN_LINES              (320)
+#define WRITE_FREQ              (80 * 1000 * 1000)
+#define OFFSET_Y                (20)
+#define SMALL_AREA_LINES        (60)
+#define WIDTH                   (240)
+#define HEIGHT                  (280)
+#define STRIPE_LINES            (40)
+#define WAKE_LATENCY_US         (40)        /*定时器/信号量唤醒的最大延迟，小于一行的扫描时间*/
+
+struct scanout_t{
+    double phase;                           /*第0次TE上升沿的时间*/
+    double edge(int64_t k) const { return phase + (double)k * PERIOD_US; }
+    /*now之前最近一次TE上升沿的序号*/
+    int64_t last_edge(double now) const { return (int64_t)floor((now - phase) / PERIOD_US); }
+    /*第k帧读取面板行y的时间*/
+    double read_time(int64_t k, int y) const { return edge(k) + (double)y * PERIOD_US / SCAN_LINES; }
+};
+
+struct replay_stat_t{
+    int flushes;
+    int torn;
+    double wait_us;
+};
+
+/*按te_sync的策略决定写入开始时间，sync为false时立即写入*/
+static double start_time(const scanout_t& scan, double now, int y1, int y2, int w, bool sync)
+{
+    if(!sync)return now;
+    int lines = y2 - y1 + 1;
+    double latency = (double)(rand() % (WAKE_LATENCY_US + 1));
+    if(lines > SMALL_AREA_LINES)return scan.edge(scan.last_edge(now) + 1) + latency;
+    int64_t elapsed = (int64_t)(now - scan.edge(scan.last_edge(now)));
+    int line = te_window::scanline(elapsed, PERIOD_US, SCAN_LINES);
+    int write_lines = te_window::write_lines(w, lines, WRITE_FREQ, PERIOD_US, SCAN_LINES);
+    int64_t wait = te_window::wait_us(line, y1 + OFFSET_Y, y2 + OFFSET_Y, write_lines, PERIOD_US, SCAN_LINES);
+    if(wait < 0)return scan.edge(scan.last_edge(now) + 1) + latency;
+    if(wait == 0)return now;
+    return now + (double)wait + latency;
+}
+
+/*写入[t0, t0 + lines * line_us)期间，任何一帧读到的区域必须全是旧内容或者全是新内容*/
+static bool is_torn(const scanout_t& scan, double t0, int y1, int y2, int w)
+{
+    double line_us = (double)w * 16 * 1000000 / WRITE_FREQ;
+    double t1 = t0 + (y2 - y1 + 1) * line_us;
+    for(int64_t k = scan.last_edge(t0) - 1; scan.edge(k) <= t1; k++){
+        int new_lines = 0, old_lines = 0;
+        for(int y = y1; y <= y2; y++){
+            double r = scan.read_time(k, y + OFFSET_Y);
+            double done = t0 + (y - y1 + 1) * line_us;
+            if(r >= done)new_lines++;
+            else if(r < done - line_us)old_lines++;
+            else return true;       /*读到正在写的行*/
+        }
+        if(new_lines != 0 && old_lines != 0)return true;
+    }
+    return false;
+}
+
+static void flush(const scanout_t& scan, double* now, int y1, int y2, int w, bool sync, replay_stat_t* stat)
+{
+    double t0 = start_time(scan, *now, y1, y2, w, sync);
+    stat->wait_us += t0 - *now;
+    stat->flushes++;
+    if(is_torn(scan, t0, y1, y2, w))stat->torn++;
+    *now = t0 + (y2 - y1 + 1) * ((double)w * 16 * 1000000 / WRITE_FREQ);
+}
+
+/*整屏重绘：局部渲染按条带自上而下刷屏，条带之间是渲染时间*/
+static void replay_full_redraw(const scanout_t& scan, double* now, bool sync, replay_stat_t* stat)
+{
+    for(int y = 0; y < HEIGHT; y += STRIPE_LINES){
+        flush(scan, now, y, y + STRIPE_LINES - 1, WIDTH, sync, stat);
+        *now += 500 + rand() % 3000;
+    }
+}
+
+/*零散的小区域：时钟数字、按钮等*/
+static void replay_small_areas(const scanout_t& scan, double* now, bool sync, replay_stat_t* stat)
+{
+    for(int i = 0; i < 20; i++){
+        int h = 1 + rand() % SMALL_AREA_LINES;
+        int y1 = rand() % (HEIGHT - h + 1);
+        int w = 8 + rand() % (WIDTH - 7);
+        flush(scan, now, y1, y1 + h - 1, w, sync, stat);
+        *now += rand() % 8000;
+    }
+}
+
+int main()
+{
+    srand(1);
+    /*窗口计算本身*/
+    CHECK(te_window::scanline(0, PERIOD_US, SCAN_LINES) == 0);
+    CHECK(te_window::scanline(PERIOD_US - 1, PERIOD_US, SCAN_LINES) == SCAN_LINES - 1);
+    CHECK(abs(te_window::scanline(PERIOD_US * 3 + PERIOD_US / 2, PERIOD_US, SCAN_LINES) - SCAN_LINES / 2) <= 1);
+    CHECK(te_window::wait_us(0, 200, 239, 10, PERIOD_US, SCAN_LINES) == 0);         /*光栅远在区域前方*/
+    CHECK(te_window::wait_us(250, 200, 239, 10, PERIOD_US, SCAN_LINES) == 0);       /*光栅已经扫过区域*/
+    CHECK(te_window::wait_us(195, 200, 239, 10, PERIOD_US, SCAN_LINES) > 0);        /*写完前光栅会进入区域*/
+    CHECK(te_window::wait_us(315, 0, 39, 10, PERIOD_US, SCAN_LINES) > 0);           /*光栅会绕回区域*/
+    CHECK(te_window::wait_us(0, 0, 279, 300, PERIOD_US, SCAN_LINES) == -1);         /*一帧内没有窗口*/
+
+    /*不同的TE相位下回放，TE同步时不允许撕裂*/
+    replay_stat_t sync_stat = {}, nosync_stat = {};
+    double max_redraw_wait = 0;
+    for(int run = 0; run < 200; run++){
+        scanout_t scan = {(double)(rand() % PERIOD_US)};
+        double now = 20000 + rand() % PERIOD_US;
+        double redraw_wait = sync_stat.wait_us;
+        replay_full_redraw(scan, &now, true, &sync_stat);
+        redraw_wait = sync_stat.wait_us - redraw_wait;
+        if(redraw_wait > max_redraw_wait)max_redraw_wait = redraw_wait;
+        replay_small_areas(scan, &now, true, &sync_stat);
+
+        double now2 = 20000 + rand() % PERIOD_US;
+        replay_full_redraw(scan, &now2, false, &nosync_stat);
+        replay_small_areas(scan, &now2, false, &nosync_stat);
+    }
+    printf("sync:   %d flushes, %d torn, avg wait %.0fus, worst full redraw wait %.0fus\n",
+            sync_stat.flushes, sync_stat.torn, sync_stat.wait_us / sync_stat.flushes, max_redraw_wait);
+    printf("nosync: %d flushes, %d torn\n", nosync_stat.flushes, nosync_stat.torn);
+    CHECK(sync_stat.torn == 0);
+    /*回放本身能发现撕裂，否则上面的检查没有意义*/
+    CHECK(nosync_stat.torn > 0);
+    /*整屏7个条带的等待不能逐条带累加成好几帧*/
+    CHECK(max_redraw_wait < 3 * PERIOD_US);
+    return CHECK_RESULT();
+}
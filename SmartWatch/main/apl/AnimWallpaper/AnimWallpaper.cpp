@@ -0,0 +1,125 @@
+/**
+ * @file AnimWallpaper.cpp
+ * @author 李威延
+ * @brief
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "AnimWallpaper.hpp"
+
+namespace apl{
+
+    AnimWallpaper::AnimWallpaper()
+    {
+        player = NULL;
+        img = NULL;
+        memset(&img_dsc, 0, sizeof(img_dsc));
+        ring = NULL;
+        stripe = NULL;
+        delta = NULL;
+    }
+
+    AnimWallpaper::~AnimWallpaper()
+    {
+        destroy();
+    }
+
+    void AnimWallpaper::set_src(const void* src)
+    {
+        lv_img_set_src(img, src);
+        lv_obj_align(img, LV_ALIGN_CENTER, 0, 0);
+    }
+
+    void AnimWallpaper::create(lv_obj_t* parent, const char* name)
+    {
+        if(parent == NULL || img != NULL)return;
+        fml::JpegDecoder& decoder = fml::JpegDecoder::getInstance();
+        struct fml::JpegDecoder::jpeg_anim_info_t anim;
+        if(decoder.FindJpegAnimation(BLL_JPEG_DESC_PATH, name, &anim) == true)player = decoder.CreateAnimPlayer(name, &anim);
+        if(player == NULL)ESP_LOGE(TAG, "%s anim player create fialed", name);
+        /*差分编码的动画只能由差分解码源播放*/
+        if(player != NULL && player->anim.delta == true){
+            delta = decoder.CreateDeltaSource(BLL_JPEG_OUTPUT_WIDTH, BLL_JPEG_OUTPUT_HEIGHT);
+            if(delta == NULL)ESP_LOGE(TAG, "%s delta source create fialed", name);
+        }
+#if BLL_JPEG_BLOCK_MODE
+        /*块模式渲染时直接解码到LVGL条带，不支持时退回整帧输出环*/
+        if(delta == NULL)stripe = decoder.CreateStripeSource(BLL_JPEG_OUTPUT_WIDTH, BLL_JPEG_OUTPUT_HEIGHT);
+#endif
+        if(delta == NULL && stripe == NULL){
+            ring = decoder.CreateFrameRing(BLL_JPEG_OUTPUT_WIDTH * BLL_JPEG_OUTPUT_HEIGHT * BLL_JPEG_PIXEL_BYTE);
+            if(ring == NULL)ESP_LOGE(TAG, "%s frame ring create fialed", name);
+        }
+        img = lv_img_create(parent);
+        lv_obj_align(img, LV_ALIGN_CENTER, 0, 0);
+        //设置背景图像描述
+        img_dsc.header.w = BLL_JPEG_OUTPUT_WIDTH;
+        img_dsc.header.h = BLL_JPEG_OUTPUT_HEIGHT;
+        img_dsc.header.cf = BLL_LV_COLOR_FORMAT;
+        img_dsc.data = NULL;
+        img_dsc.data_size = BLL_JPEG_OUTPUT_WIDTH * BLL_JPEG_OUTPUT_HEIGHT * BLL_JPEG_PIXEL_BYTE;
+    }
+
+    void AnimWallpaper::update(TickType_t xTicksToWait)
+    {
+        if(player == NULL || img == NULL)return;
+        fml::JpegDecoder& decoder = fml::JpegDecoder::getInstance();
+        /*按动画帧率取当前时间应显示的帧，落后时中间的帧直接跳过*/
+        int64_t frame = decoder.AnimPlayerDueFrame(player);
+        if(delta != NULL){
+            /*差分模式：叠加到期的帧，只重绘变化的区域；一次追不上时先显示追到的帧，追上之前不算显示了到期的帧*/
+            int index = decoder.AnimPlayerFrameIndex(player, frame);
+            if(frame == player->shown_frame && delta->shown_index == index)return;
+            if(decoder.SetDeltaFrame(delta, &player->anim, index) != true)return;
+            if(lv_img_get_src(img) != &delta->img_dsc)set_src(&delta->img_dsc);
+            decoder.InvalidateDeltaSource(delta, img);
+            if(delta->shown_index == index)decoder.AnimPlayerShown(player, frame);
+            return;
+        }
+        if(stripe != NULL){
+            /*块模式：到了下一帧的时间才切换并重绘，解码在渲染条带时进行*/
+            if(frame == player->shown_frame)return;
+            decoder.SetStripeFrame(stripe, decoder.AnimPlayerFrameIndex(player, frame));
+            if(player->shown_frame < 0)set_src(&stripe->img_dsc);
+            else lv_obj_invalidate(img);
+            decoder.AnimPlayerShown(player, frame);
+            return;
+        }
+        if(ring == NULL)return;
+        /*输出环：解码器空闲且到了下一帧的时间才开始解码*/
+        if(player->pending_frame < 0 && frame != player->shown_frame){
+            if(decoder.StartJpegDec(decoder.AnimPlayerFrameIndex(player, frame), ring) == true)player->pending_frame = frame;
+        }
+        /*后台槽位解码完成后才切换控件的数据*/
+        if(player->pending_frame >= 0){
+            uint8_t* data = decoder.WaitJpegDec(ring, NULL, xTicksToWait);
+            if(data != NULL){
+                img_dsc.data = data;
+                set_src(&img_dsc);
+                decoder.AnimPlayerShown(player, player->pending_frame);
+                player->pending_frame = -1;
+            }else if(ring->back < 0){
+                /*解码失败，下次重新解码当前时间的帧*/
+                player->pending_frame = -1;
+            }
+        }
+    }
+
+    void AnimWallpaper::destroy()
+    {
+        fml::JpegDecoder& decoder = fml::JpegDecoder::getInstance();
+        if(img != NULL)lv_obj_del(img);
+        decoder.DeleteFrameRing(ring);
+        decoder.DeleteStripeSource(stripe);
+        decoder.DeleteDeltaSource(delta);
+        decoder.DeleteAnimPlayer(player);
+        img = NULL;
+        ring = NULL;
+        stripe = NULL;
+        delta = NULL;
+        player = NULL;
+    }
+}
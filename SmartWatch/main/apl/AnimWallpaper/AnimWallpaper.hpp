@@ -0,0 +1,41 @@
+/**
+ * @file AnimWallpaper.hpp
+ * @author 李威延
+ * @brief 动画壁纸：WatchDial和AppStore共用的背景图像控件，播放时钟和解码源由JpegDecoder提供
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "bll.hpp"
+
+namespace apl{
+
+    /*差分动画用差分解码源，否则块模式用条带解码源，都不可用时用整帧输出环；只能在LVGL任务中使用*/
+    class AnimWallpaper
+    {
+        private:
+            const char* TAG = "AnimWallpaper";
+            fml::JpegDecoder::jpeg_anim_player_t* player;      /*播放时钟，决定每次显示哪一帧*/
+            lv_obj_t* img;
+            lv_image_dsc_t img_dsc;                             /*输出环模式下指向前台槽位*/
+            fml::JpegDecoder::jpeg_frame_ring_t* ring;         /*前后台解码缓存，由JpegDecoder持有*/
+            fml::JpegDecoder::jpeg_stripe_src_t* stripe;       /*块模式解码源，不为NULL时不使用ring*/
+            fml::JpegDecoder::jpeg_delta_src_t* delta;         /*差分动画的解码源，不为NULL时不使用stripe和ring*/
+
+            void set_src(const void* src);
+        public:
+            AnimWallpaper();
+            ~AnimWallpaper();
+            /*name为描述文件中的动画名*/
+            void create(lv_obj_t* parent, const char* name);
+            /*显示当前时间应显示的帧，xTicksToWait只在输出环模式下等待解码*/
+            void update(TickType_t xTicksToWait);
+            void destroy();
+    };
+}
@@ -18,46 +18,6 @@ const int marquee_img_count = sizeof(marquee_img_srcs) / sizeof(marquee_img_srcs
 
 namespace apl{
 
-    void AppStore::bg_img_event_cb(lv_event_t* e)
-    {
-        static int old_jpeg_index = -1;
-        if(lv_event_get_code(e) == LV_EVENT_DRAW_POST_END){
-            if(old_jpeg_index != ((AppStore*)lv_event_get_user_data(e))->lv_bg.cur_jpeg_index){
-                /*图片已经渲染到屏幕*/
-                fml::JpegDecoder::getInstance().StartJpegDec(((AppStore*)lv_event_get_user_data(e))->lv_bg.cur_jpeg_index, ((AppStore*)lv_event_get_user_data(e))->lv_bg.jpeg_src);
-                old_jpeg_index = ((AppStore*)lv_event_get_user_data(e))->lv_bg.cur_jpeg_index;
-            }
-        }
-    }
-
-    void AppStore::get_lv_bg(struct appstore_lv_bg_t* lv_bg, struct appstore_lv_screen_t* lv_screen, void* arg)
-    {
-        if(lv_bg != NULL && lv_screen != NULL){
-            fml::JpegDecoder::FindJpegMaterial(BLL_JPEG_DESC_PATH,APPSTORE_TAG_NAME,&lv_bg->start_jpeg_index, &lv_bg->end_jpeg_index);
-            lv_bg->jpeg_src.jpeg_len = BLL_JPEG_OUTPUT_WIDTH * BLL_JPEG_OUTPUT_HEIGHT * BLL_JPEG_PIXEL_BYTE;
-            lv_bg->jpeg_src.jpeg_buff = (uint8_t*)heap_caps_aligned_alloc(16, lv_bg->jpeg_src.jpeg_len, MALLOC_CAP_SPIRAM);
-            lv_bg->cur_jpeg_index = lv_bg->start_jpeg_index;
-            lv_bg->img = lv_img_create(lv_screen->tile);
-            lv_obj_add_event_cb(lv_bg->img, bg_img_event_cb, LV_EVENT_DRAW_POST_END, arg);
-            lv_obj_align(lv_bg->img, LV_ALIGN_CENTER, 0, 0);
-            //设置背景图像描述
-            lv_bg->img_dsc.header.w = BLL_JPEG_OUTPUT_WIDTH;
-            lv_bg->img_dsc.header.h = BLL_JPEG_OUTPUT_HEIGHT;
-            lv_bg->img_dsc.header.cf = BLL_LV_COLOR_FORMAT; 
-            lv_bg->img_dsc.data = lv_bg->jpeg_src.jpeg_buff;
-            lv_bg->img_dsc.data_size = lv_bg->jpeg_src.jpeg_len;
-        }
-    }
-
-    void AppStore::set_lv_bg(struct appstore_lv_bg_t* lv_bg, uint8_t* data)
-    {
-        if(lv_bg != NULL && data != NULL){
-            lv_bg->img_dsc.data = data;
-            lv_img_set_src(lv_bg->img, &lv_bg->img_dsc);  
-            lv_obj_align(lv_bg->img, LV_ALIGN_CENTER, 0, 0);
-        }
-    }
-
     void AppStore::lv_marquee_timer_cb(lv_timer_t *timer)
     {
         struct appstore_lv_marquee_t* lv_marquee = (struct appstore_lv_marquee_t*)lv_timer_get_user_data(timer);
@@ -144,7 +104,6 @@ namespace apl{
     AppStore::AppStore(lv_obj_t* screen, lv_obj_t* tileview, lv_obj_t* tile, lv_marquee_icon_event_cb_t _icon_cb, void* _icon_cb_data)
     {
         memset(&lv_screen, 0, sizeof(lv_screen));
-        memset(&lv_bg, 0, sizeof(lv_bg));
         memset(&lv_marquee, 0, sizeof(lv_marquee));
 
         lv_screen.screen = screen;
@@ -161,8 +120,7 @@ namespace apl{
         if(lv_marquee.container_bottom != NULL)lv_obj_del(lv_marquee.container_bottom);
         if(lv_marquee.timer != NULL)lv_timer_del(lv_marquee.timer);
 
-        if(lv_bg.img != NULL)lv_obj_del(lv_bg.img);
-         if(lv_bg.jpeg_src.jpeg_buff != NULL)heap_caps_free(lv_bg.jpeg_src.jpeg_buff);
+        lv_bg.destroy();
 
         ESP_LOGI(TAG, "AppStore on deconstruct");
     }
@@ -170,12 +128,9 @@ namespace apl{
     void AppStore::onCreate()
     {
         /*获取背景图像控件 */
-        get_lv_bg(&lv_bg, &lv_screen, this);
-        /*开启解码*/
-        fml::JpegDecoder::getInstance().StartJpegDec(lv_bg.cur_jpeg_index, lv_bg.jpeg_src);
-        fml::JpegDecoder::getInstance().WaitJpegDec(NULL, portMAX_DELAY);
-        /*解码成功，设置控件*/
-        set_lv_bg(&lv_bg, lv_bg.jpeg_src.jpeg_buff);
+        lv_bg.create(lv_screen.tile, APPSTORE_TAG_NAME);
+        /*显示第一帧，输出环模式下等待解码完成*/
+        lv_bg.update(portMAX_DELAY);
         /*获取选取框控件*/
         get_lv_marquee(&lv_marquee, &lv_screen, this);
         ESP_LOGI(TAG, "AppStore on create");
@@ -189,19 +144,8 @@ namespace apl{
 
     void AppStore::onRunning()
     {
-        int cur_jpeg_index;
         /*刷新背景图*/
-        if(fml::JpegDecoder::getInstance().WaitJpegDec(&cur_jpeg_index, 0) == true){
-            if(lv_bg.start_jpeg_index <= cur_jpeg_index && cur_jpeg_index <= lv_bg.end_jpeg_index){
-                /*设置下一个要解码的index*/
-                lv_bg.cur_jpeg_index++;
-                if(lv_bg.cur_jpeg_index > lv_bg.end_jpeg_index)lv_bg.cur_jpeg_index = lv_bg.start_jpeg_index;
-                /*解码成功，设置控件*/
-                set_lv_bg(&lv_bg, lv_bg.jpeg_src.jpeg_buff);
-            }else{
-                fml::JpegDecoder::getInstance().StartJpegDec(lv_bg.cur_jpeg_index, lv_bg.jpeg_src);
-            }
-        }
+        lv_bg.update(0);
 
         //ESP_LOGI(TAG, "AppStore on Running");
     }
@@ -14,6 +14,7 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include "bll.hpp"
+#include "AnimWallpaper.hpp"
 
 namespace apl{
 
@@ -37,15 +38,6 @@ namespace apl{
             lv_marquee_icon_event_cb_t icon_cb;
         };
 
-        struct appstore_lv_bg_t{
-            int start_jpeg_index;
-            int end_jpeg_index;
-            int cur_jpeg_index;
-            lv_obj_t* img;
-            lv_image_dsc_t img_dsc;
-            struct fml::JpegDecoder::jpeg_output_info_t jpeg_src;
-        };
-
         struct appstore_lv_marquee_t{
             lv_obj_t* container_top;
             lv_obj_t* container_bottom;
@@ -55,13 +47,9 @@ namespace apl{
         private:
             const char* TAG = APPSTORE_TAG_NAME;
             struct appstore_lv_screen_t lv_screen;
-            struct appstore_lv_bg_t lv_bg;
+            AnimWallpaper lv_bg;
             struct appstore_lv_marquee_t lv_marquee;
 
-            static void bg_img_event_cb(lv_event_t* e);
-            static void get_lv_bg(struct appstore_lv_bg_t* lv_bg, struct appstore_lv_screen_t* lv_screen, void* arg);
-            static void set_lv_bg(struct appstore_lv_bg_t* lv_bg, uint8_t* data);
-
             static void lv_marquee_timer_cb(lv_timer_t *timer);
             static void get_lv_marquee(struct appstore_lv_marquee_t* lv_marquee, struct appstore_lv_screen_t* lv_screen, void* user_data);
         public:
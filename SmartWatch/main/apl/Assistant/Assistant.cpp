@@ -55,7 +55,7 @@ namespace apl{
         Assistant* app = static_cast<Assistant*>(user_data);
         /*恢复发送按钮状态*/
         app->set_send_btn_busy(false);
-        lv_async_call([](void* data){
+        fml::HdlManager::lvgl_async_call([](void* data){
              AsyncData* d = static_cast<AsyncData*>(data);
             d->app->add_message(d->text, 0);
             free(d->text);  /*释放内存*/
@@ -108,7 +108,7 @@ namespace apl{
              /*恢复发送按钮状态*/
             app->set_send_btn_busy(false);
 
-            lv_async_call([](void* data){
+            fml::HdlManager::lvgl_async_call([](void* data){
                 AsyncData* d = static_cast<AsyncData*>(data);
                 lv_textarea_set_text(d->app->input_ta, d->text);
                 free(d->text);  /*释放内存*/
@@ -195,7 +195,7 @@ namespace apl{
             std::lock_guard<std::mutex> lock(btn_mutex);
             is_send_btn_busy = enabled;
         }
-        lv_async_call([](void* arg) {
+        fml::HdlManager::lvgl_async_call([](void* arg) {
             Assistant* app = static_cast<Assistant*>(arg);
             if (!app->is_send_btn_busy) {
                 lv_obj_set_style_bg_color(app->send_btn, lv_color_hex(ASSISTANT_SEND_BTN_UP_COLOR), 0);
@@ -214,7 +214,7 @@ namespace apl{
             std::lock_guard<std::mutex> lock(btn_mutex);
             is_voice_btn_busy = enabled;
         }
-        lv_async_call([](void* arg) {
+        fml::HdlManager::lvgl_async_call([](void* arg) {
             Assistant* app = static_cast<Assistant*>(arg);
             if (!app->is_voice_btn_busy) {
                 lv_obj_set_style_bg_color(app->voice_btn, lv_color_hex(ASSISTANT_VOICE_BTN_UP_COLOR), 0);
@@ -59,7 +59,7 @@ namespace apl{
         if (strstr(answer, "https://") != nullptr || 
             strstr(answer, "http://") != nullptr) {
             /*在主线程创建图片气泡*/
-            lv_async_call([](void* data) {
+            fml::HdlManager::lvgl_async_call([](void* data) {
                 AsyncData* d = static_cast<AsyncData*>(data);
                 d->app->create_image_bubble(d->text);
                 d->app->image_url = d->text; /*保存URL*/
@@ -68,7 +68,7 @@ namespace apl{
             }, new AsyncData{app, strdup(answer)});
         } else {
             /*文本消息处理*/
-            lv_async_call([](void* data){
+            fml::HdlManager::lvgl_async_call([](void* data){
                 AsyncData* d = static_cast<AsyncData*>(data);
                 d->app->add_message(d->text, 0);
                 free(d->text);  /*释放内存*/
@@ -123,7 +123,7 @@ namespace apl{
             /*恢复发送按钮状态*/
             app->set_send_btn_busy(false);
 
-            lv_async_call([](void* data){
+            fml::HdlManager::lvgl_async_call([](void* data){
                 AsyncData* d = static_cast<AsyncData*>(data);
                 lv_textarea_set_text(d->app->input_ta, d->text);
                 free(d->text);  /*释放内存*/
@@ -177,162 +177,100 @@ namespace apl{
         }
     }
 
-    /*JPEG解码任务*/
-    void Painter::jpeg_decode_task(void* arg) {
-        DecodeTaskData* data = static_cast<DecodeTaskData*>(arg);
-        Painter* app = data->app;
-        app->decode_task_handle = xTaskGetCurrentTaskHandle(); /*记录任务句柄*/
-
-        /*检查终止标志*/
-        if (app->abort_tasks) {
-            ESP_LOGW(app->TAG, "Decode task aborted before start");
-            delete data;
-            app->decode_task_handle = nullptr;
-            vTaskDelete(NULL);
-            return;
-        }
-        
-        /*复制数据到本地*/
-        app->download_buffer = std::move(data->buffer);
-        delete data; /*释放任务数据*/
-        
-        /*执行解码*/
-        bool decode_ok = app->decode_jpeg();
-
-        /*检查终止标志*/
-        if (app->abort_tasks) {
-            ESP_LOGW(app->TAG, "Decode task aborted after processing");
-            if (app->img_dsc.data) {
-                free((void*)app->img_dsc.data);
-                app->img_dsc.data = nullptr;
-            }
-            app->decode_task_handle = nullptr;
-            vTaskDelete(NULL);
-            return;
-        }
-        
-        /*通知主线程结果*/
-        if (decode_ok && app->img_dsc.data) {
-            lv_async_call([](void* arg) {
-                Painter* app = static_cast<Painter*>(arg);
-                app->scale_and_display_image();
-                /*恢复发送按钮状态*/
-                app->set_send_btn_busy(false);
-            }, app);
-        } else {
-            lv_async_call([](void* arg) {
-                Painter* app = static_cast<Painter*>(arg);
-                if (app->current_image) {
-                    lv_obj_t* parent = lv_obj_get_parent(app->current_image);
-                    lv_obj_clean(parent);
-                    lv_obj_t* label = lv_label_create(parent);
-                    lv_label_set_text(label, "解码失败");
-                    lv_obj_set_style_text_font(label, &MyFonts16, 0);
-                    lv_obj_center(label);
-                    /*恢复发送按钮状态*/
-                    app->set_send_btn_busy(false);
-                }
-            }, app);
-        }
-        app->decode_task_handle = nullptr; /*清除任务句柄*/
-        vTaskDelete(NULL);
-    }
-
     void Painter::reset()
     {
-        /* 1. 设置任务终止标志 */
-        abort_tasks = true;
-        
-        /* 2. 唤醒并等待下载任务退出 */
-        if (download_task_handle != nullptr) {
-            /*发送通知唤醒可能阻塞的任务*/
-            xTaskNotify(download_task_handle, 0, eNoAction);
-            /*等待任务退出（最多50ms）*/
-            for (int i = 0; i < 5; i++) {
-                vTaskDelay(pdMS_TO_TICKS(10));
-                if (download_task_handle == nullptr) break;
-            }
-            /*如果任务仍未退出，强制终止*/
-            if (download_task_handle != nullptr) {
-                vTaskDelete(download_task_handle);
-                download_task_handle = nullptr;
-                ESP_LOGW(TAG, "Force deleted download task");
-            }
-        }
-        
-        /* 3. 唤醒并等待解码任务退出 */
-        if (decode_task_handle != nullptr) {
-            xTaskNotify(decode_task_handle, 0, eNoAction);
-            for (int i = 0; i < 5; i++) {
-                vTaskDelay(pdMS_TO_TICKS(10));
-                if (decode_task_handle == nullptr) break;
-            }
-            if (decode_task_handle != nullptr) {
-                vTaskDelete(decode_task_handle);
-                decode_task_handle = nullptr;
-                ESP_LOGW(TAG, "Force deleted decode task");
-            }
+        /* 1. 作废进行中的下载和解码，它们发现代数不一致时自行丢弃结果并退出，这里不等待，不阻塞LVGL任务 */
+        {
+            std::lock_guard<std::mutex> lock(img_mutex);
+            image_generation++;
+            image_url.clear();
         }
         
-        /* 4. 清空消息容器 */
+        /* 2. 清空消息容器，图像对象删除时归还各自的槽位 */
         if (msg_cont) {
             lv_obj_clean(msg_cont);
         }
         
-        /* 5. 清理图像资源 */
-        if (img_dsc.data) {
-            free((void*)img_dsc.data);
-            img_dsc.data = nullptr;
-        }
-        memset(&img_dsc, 0, sizeof(lv_img_dsc_t));
-        
-        /* 6. 隐藏键盘和候选面板 */
+        /* 3. 隐藏键盘和候选面板 */
         if (kb) lv_obj_add_flag(kb, LV_OBJ_FLAG_HIDDEN);
         if (cand_panel) lv_obj_add_flag(cand_panel, LV_OBJ_FLAG_HIDDEN);
         
-        /* 7. 清空输入框 */
+        /* 4. 清空输入框 */
         if (input_ta) lv_textarea_set_text(input_ta, "");
         
-        /* 8. 重置按钮状态 */
+        /* 5. 重置按钮状态 */
         set_send_btn_busy(false);
         set_voice_btn_busy(false);
         
-        /* 9. 确保消息容器可见 */
+        /* 6. 确保消息容器可见 */
         if (msg_cont) lv_obj_clear_flag(msg_cont, LV_OBJ_FLAG_HIDDEN);
         
-        /* 10. 重置图像状态 */
+        /* 7. 重置图像状态，下载缓冲区由下载任务在开始时清空 */
         current_image = NULL;
-        image_url.clear();
-        download_buffer.clear();
-        download_buffer.shrink_to_fit();
-        downloaded_size = 0;
-        is_jpeg_valid = false;
-        
-        /* 11. 重置任务标志 */
-        abort_tasks = false;
     }
 
     /*启动图片下载*/
     void Painter::start_image_download(const char* url) {
-        image_url = url;
-        /*创建下载任务*/
-        xTaskCreatePinnedToCore(
+        {
+            std::lock_guard<std::mutex> lock(img_mutex);
+            image_url = url;
+        }
+        /*创建下载任务，开始时的image_generation通过任务通知传入*/
+        TaskHandle_t task = NULL;
+        BaseType_t ret = xTaskCreatePinnedToCore(
         [](void* arg) {
             Painter* app = static_cast<Painter*>(arg);
-            app->download_task_handle = xTaskGetCurrentTaskHandle(); /*记录任务句柄*/
-            app->download_image();
-            app->download_task_handle = nullptr;        /*清除任务句柄*/
+            uint32_t generation = 0;
+            xTaskNotifyWait(0, 0, &generation, portMAX_DELAY);
+            /*上一个下载任务被reset作废后可能还在等HTTP返回，等它退出后才能使用下载缓冲区*/
+            if (xSemaphoreTake(app->download_sem, pdMS_TO_TICKS(PAINTER_DOWNLOAD_WAIT_MS)) == pdTRUE) {
+                app->download_generation = generation;
+                if (!app->aborted()) app->download_image();
+                xSemaphoreGive(app->download_sem);
+            } else {
+                ESP_LOGE(app->TAG, "wait previous download fialed");
+            }
             vTaskDelete(NULL);
         },                                              /*任务函数*/
         "jpeg_download_task",                           /*任务名称*/
         4096,                                           /*堆栈大小*/
         this,                                           /*参数*/
         PAINTER_JPEG_DOWNLOAD_TASK_PRIOR,               /*优先级*/
-        NULL,                                           /*任务句柄*/
+        &task,                                          /*任务句柄*/
         PAINTER_JPEG_DOWNLOAD_TASK_CORE);               /*内核号*/
+        if (ret != pdPASS) {
+            ESP_LOGE(TAG, "download task create fialed");
+            set_send_btn_busy(false);
+            return;
+        }
+        xTaskNotify(task, image_generation, eSetValueWithOverwrite);
+    }
+
+    /*取一个空闲的槽位，调用者持有img_mutex；槽位和缓冲区都在构造时分配，这里不分配内存*/
+    Painter::painter_image_t* Painter::acquire_img_slot() {
+        for (int i = 0; i < PAINTER_IMG_SLOT_NUM; i++) {
+            painter_image_t* img = &img_slots[i];
+            if (img->buff != nullptr && img->state == PAINTER_IMG_FREE) {
+                img->state = PAINTER_IMG_DECODING;
+                return img;
+            }
+        }
+        return nullptr;
+    }
+
+    /*归还槽位，缓冲区留给下一次解码*/
+    void Painter::release_image(painter_image_t* img) {
+        std::lock_guard<std::mutex> lock(img_mutex);
+        img->state = PAINTER_IMG_FREE;
+    }
+
+    /*图像对象删除时LVGL不再绘制它，槽位可以交给下一次解码*/
+    void Painter::image_delete_cb(lv_event_t *e) {
+        painter_image_t* img = static_cast<painter_image_t*>(lv_event_get_user_data(e));
+        img->app->release_image(img);
     }
 
-    /*JPEG解码函数*/
+    /*提交给JpegDecoder的解码任务，由Decode直接解码到空闲槽位的输出缓冲区，在jpeg_decode_done_cb中显示*/
     bool Painter::decode_jpeg() {
         if (!is_jpeg_valid) {
             ESP_LOGE(TAG, "Skipping decode, invalid JPEG");
@@ -345,57 +283,125 @@ namespace apl{
                      download_buffer.size(), PAINTER_MAX_IMAGE_SIZE);
             return false;
         }
-        
-        /*使用JpegDecoder进行解码*/
-        auto result = fml::JpegDecoder::Decode(
-            download_buffer.data(), 
-            download_buffer.size(),
-            PAINTER_MSG_BUBBLE_ANSWER_W,        /*目标宽度*/
-            PAINTER_MSG_BUBBLE_ANSWER_H,        /*目标高度*/
-            BLL_JPEG_PIXEL_FORMAT,              /*输出格式*/
-            BLL_JPEG_ROTATE                     /*旋转角度*/
-        );
-        
-        if (!result.success) {
-            ESP_LOGE(TAG, "JPEG decode failed: %s", result.error_message.c_str());
+
+        /*检查作废和提交在同一把锁内，reset之后不会再提交*/
+        std::lock_guard<std::mutex> lock(img_mutex);
+        if (aborted()) return false;
+        painter_image_t* img = acquire_img_slot();
+        if (img == nullptr) {
+            ESP_LOGE(TAG, "no free image slot");
             return false;
         }
-        
-        /*创建图像描述符*/
-        memset(&img_dsc, 0, sizeof(lv_img_dsc_t));
-        img_dsc.header.w = result.width;
-        img_dsc.header.h = result.height;
-        img_dsc.header.cf = BLL_LV_COLOR_FORMAT; 
-        img_dsc.data_size = result.data_size;
-        img_dsc.data = result.data.release();   /*转移数据所有权*/
-        
+        img->generation = download_generation;
+        img->start_us = esp_timer_get_time();
+
+        fml::JpegDecoder::jpeg_dec_request_t req = {};
+        req.jpeg_index = 0;                             /*解码src中的下载数据*/
+        req.src = download_buffer.data();
+        req.src_len = download_buffer.size();
+        req.dst = img->buff;
+        req.dst_len = PAINTER_IMG_BUFF_LEN;
+        req.width = PAINTER_MSG_BUBBLE_ANSWER_W;        /*目标宽度*/
+        req.height = PAINTER_MSG_BUBBLE_ANSWER_H;       /*目标高度*/
+        req.format = BLL_JPEG_PIXEL_FORMAT;             /*输出格式*/
+        req.rotate = BLL_JPEG_ROTATE;                   /*旋转角度*/
+        req.priority = fml::JpegDecoder::JPEG_DEC_PRIORITY_HIGH;    /*用户正在等待，排在预取之前*/
+        req.cb = jpeg_decode_done_cb;
+        req.user_data = img;
+        if (!fml::JpegDecoder::getInstance().SubmitJpegDec(&req)) {
+            ESP_LOGE(TAG, "Submit decode request fialed");
+            img->state = PAINTER_IMG_FREE;
+            return false;
+        }
+        /*提交成功后才标记解码进行中，回调要先拿到img_mutex才能清除，不会早于这里*/
+        xEventGroupClearBits(img_events, PAINTER_EVT_DECODE_IDLE);
         return true;
     }
 
-    /*缩放并显示图像*/
-    void Painter::scale_and_display_image() {
-        if (!img_dsc.data) return;
-        
-        if (current_image) {
-            lv_img_set_src(current_image, &img_dsc);
-            lv_obj_clear_flag(current_image, LV_OBJ_FLAG_HIDDEN);
-            
-            /*删除加载提示*/
-            lv_obj_t* parent = lv_obj_get_parent(current_image);
-            /*获取子对象列表*/
-            std::vector<lv_obj_t*> to_delete;
-            uint32_t child_count = lv_obj_get_child_cnt(parent);
-            /*收集需要删除的对象*/
-            for (uint32_t i = 0; i < child_count; i++) {
-                lv_obj_t* child = lv_obj_get_child(parent, i);
-                if (child != current_image) {
-                    to_delete.push_back(child);
+    /*解码完成回调，在JpegDecoder的解码任务中执行，显示放到LVGL任务*/
+    void Painter::jpeg_decode_done_cb(fml::JpegDecoder::jpeg_dec_request_t* req, bool success) {
+        painter_image_t* img = static_cast<painter_image_t*>(req->user_data);
+        Painter* app = img->app;
+        bool stale = false;
+        {
+            std::lock_guard<std::mutex> lock(app->img_mutex);
+            stale = (img->generation != app->image_generation);
+            if (stale || !success) img->state = PAINTER_IMG_FREE;
+            /*不再读取下载缓冲区，先于投递LVGL任务置位，等待者不会和LVGL锁互相等待*/
+            xEventGroupSetBits(app->img_events, PAINTER_EVT_DECODE_IDLE);
+        }
+
+        if (stale) {
+            ESP_LOGW(app->TAG, "Decode aborted after processing");
+            return;
+        }
+        if (!success) {
+            ESP_LOGE(app->TAG, "JPEG decode failed");
+            fml::HdlManager::lvgl_async_call([](void* arg) {
+                Painter* app = static_cast<Painter*>(arg);
+                if (app->current_image) {
+                    lv_obj_t* parent = lv_obj_get_parent(app->current_image);
+                    lv_obj_clean(parent);
+                    lv_obj_t* label = lv_label_create(parent);
+                    lv_label_set_text(label, "解码失败");
+                    lv_obj_set_style_text_font(label, &MyFonts16, 0);
+                    lv_obj_center(label);
+                    /*恢复发送按钮状态*/
+                    app->set_send_btn_busy(false);
                 }
+            }, app);
+            return;
+        }
+        ESP_LOGI(app->TAG, "JPEG decoded %dx%d in %dus", req->out_width, req->out_height,
+                 (int)(esp_timer_get_time() - img->start_us));
+
+        /*创建图像描述符*/
+        memset(&img->dsc, 0, sizeof(lv_img_dsc_t));
+        img->dsc.header.w = req->out_width;
+        img->dsc.header.h = req->out_height;
+        img->dsc.header.cf = BLL_LV_COLOR_FORMAT;
+        img->dsc.data_size = req->out_width * req->out_height * BLL_JPEG_PIXEL_BYTE;
+        img->dsc.data = img->buff;
+        fml::HdlManager::lvgl_async_call([](void* arg) {
+            painter_image_t* img = static_cast<painter_image_t*>(arg);
+            Painter* app = img->app;
+            app->scale_and_display_image(img);
+            /*恢复发送按钮状态*/
+            app->set_send_btn_busy(false);
+        }, img);
+    }
+
+    /*缩放并显示图像，图像对象删除前一直占用槽位*/
+    void Painter::scale_and_display_image(painter_image_t* img) {
+        /*图像气泡已被清除*/
+        if (!current_image || img->generation != image_generation) {
+            release_image(img);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(img_mutex);
+            img->state = PAINTER_IMG_SHOWN;
+        }
+
+        lv_img_set_src(current_image, &img->dsc);
+        lv_obj_add_event_cb(current_image, image_delete_cb, LV_EVENT_DELETE, img);
+        lv_obj_clear_flag(current_image, LV_OBJ_FLAG_HIDDEN);
+        
+        /*删除加载提示*/
+        lv_obj_t* parent = lv_obj_get_parent(current_image);
+        /*获取子对象列表*/
+        std::vector<lv_obj_t*> to_delete;
+        uint32_t child_count = lv_obj_get_child_cnt(parent);
+        /*收集需要删除的对象*/
+        for (uint32_t i = 0; i < child_count; i++) {
+            lv_obj_t* child = lv_obj_get_child(parent, i);
+            if (child != current_image) {
+                to_delete.push_back(child);
             }
-            /*删除收集到的对象*/
-            for (lv_obj_t* child : to_delete) {
-                lv_obj_del(child);
-            }
+        }
+        /*删除收集到的对象*/
+        for (lv_obj_t* child : to_delete) {
+            lv_obj_del(child);
         }
     }
 
@@ -434,6 +440,8 @@ namespace apl{
         switch (evt->event_id) {
             case HTTP_EVENT_ON_DATA:
                 if (app) {
+                    /*已被reset作废，终止下载*/
+                    if (app->aborted()) return ESP_FAIL;
                     /*检查图片大小是否超过限制*/
                     app->downloaded_size += evt->data_len;
                     if (app->downloaded_size > PAINTER_MAX_IMAGE_SIZE) {
@@ -462,7 +470,7 @@ namespace apl{
                 if (app) {
                     /*检查是否超过大小限制*/
                     if (app->downloaded_size > PAINTER_MAX_IMAGE_SIZE) {
-                        lv_async_call([](void* arg) {
+                        fml::HdlManager::lvgl_async_call([](void* arg) {
                             Painter* app = static_cast<Painter*>(arg);
                             if (app->current_image) {
                                 lv_obj_t* parent = lv_obj_get_parent(app->current_image);
@@ -476,26 +484,25 @@ namespace apl{
                             }
                         }, app);
                     } else if (app->is_jpeg_valid) {
-                        /*创建解码任务数据*/
-                        DecodeTaskData* task_data = new DecodeTaskData{
-                            .app = app,
-                            .buffer = std::move(app->download_buffer) /*转移数据所有权*/
-                        };
-                        
-                        /*清空原始缓冲区*/
-                        app->download_buffer.clear();
-                        
-                        /*创建解码任务*/
-                        xTaskCreatePinnedToCore(
-                            jpeg_decode_task,                               /*任务函数*/
-                            "jpeg_decode_task",                             /*任务名称*/
-                            4096,                                           /*堆栈大小*/
-                            task_data,                                      /*参数*/
-                            PAINTER_JPEG_DECODE_TASK_PRIOR,                 /*优先级*/
-                            NULL,                                           /*任务句柄（不需要保存）*/
-                            PAINTER_JPEG_DECODE_TASK_CORE);                 /*内核号*/
+                        /*提交解码后由jpeg_decode_done_cb显示，下载任务不等待解码*/
+                        if (!app->decode_jpeg()) {
+                            if (app->aborted()) break;
+                            fml::HdlManager::lvgl_async_call([](void* arg) {
+                                Painter* app = static_cast<Painter*>(arg);
+                                if (app->current_image) {
+                                    lv_obj_t* parent = lv_obj_get_parent(app->current_image);
+                                    lv_obj_clean(parent);
+                                    lv_obj_t* label = lv_label_create(parent);
+                                    lv_label_set_text(label, "解码失败");
+                                    lv_obj_set_style_text_font(label, &MyFonts16, 0);
+                                    lv_obj_center(label);
+                                    /*恢复发送按钮状态*/
+                                    app->set_send_btn_busy(false);
+                                }
+                            }, app);
+                        }
                     } else {
-                        lv_async_call([](void* arg) {
+                        fml::HdlManager::lvgl_async_call([](void* arg) {
                             Painter* app = static_cast<Painter*>(arg);
                             if (app->current_image) {
                                 lv_obj_t* parent = lv_obj_get_parent(app->current_image);
@@ -513,7 +520,7 @@ namespace apl{
                 break;
                 
             case HTTP_EVENT_ERROR:
-                lv_async_call([](void* arg) {
+                fml::HdlManager::lvgl_async_call([](void* arg) {
                     Painter* app = static_cast<Painter*>(arg);
                     if (app->current_image) {
                         lv_obj_t* parent = lv_obj_get_parent(app->current_image);
@@ -548,16 +555,22 @@ namespace apl{
     void Painter::download_image() {
         is_jpeg_valid = false;
         downloaded_size = 0;
+        /*上一张图片的解码可能还在读取下载缓冲区*/
+        if ((xEventGroupWaitBits(img_events, PAINTER_EVT_DECODE_IDLE, pdFALSE, pdTRUE, pdMS_TO_TICKS(PAINTER_DECODE_WAIT_MS)) & PAINTER_EVT_DECODE_IDLE) == 0) {
+            ESP_LOGE(TAG, "wait previous decode fialed");
+            set_send_btn_busy(false);
+            return;
+        }
         download_buffer.clear();
-        download_buffer.reserve(PAINTER_MAX_IMAGE_SIZE); /*预分配内存*/
-        /*清理图像资源*/
-        if (img_dsc.data) {
-            free((void*)img_dsc.data);
-            img_dsc.data = nullptr;
+        download_buffer.reserve(PAINTER_MAX_IMAGE_SIZE); /*第一次下载时分配，之后保留容量*/
+        std::string url;
+        {
+            std::lock_guard<std::mutex> lock(img_mutex);
+            url = image_url;
         }
         
         esp_http_client_config_t config = {
-            .url = image_url.c_str(),
+            .url = url.c_str(),
             .timeout_ms = 15000,
             .event_handler = http_event_handler,
             .buffer_size = 4096,
@@ -567,7 +580,7 @@ namespace apl{
         esp_http_client_handle_t client = esp_http_client_init(&config);
         if (!client) {
             ESP_LOGE(TAG, "Failed to initialize HTTP client");
-            lv_async_call([](void* arg) {
+            fml::HdlManager::lvgl_async_call([](void* arg) {
                 Painter* app = static_cast<Painter*>(arg);
                 if (app->current_image) {
                     lv_obj_t* parent = lv_obj_get_parent(app->current_image);
@@ -584,14 +597,14 @@ namespace apl{
         }
 
         esp_err_t err = ESP_OK;
-        while (!abort_tasks) {
+        while (!aborted()) {
             err = esp_http_client_perform(client);
             if (err != ESP_ERR_HTTP_EAGAIN) break;          /*完成或非重试错误*/
             vTaskDelay(pdMS_TO_TICKS(10));                  /*短暂等待后重试*/
         }
         
         /*如果被终止，清理资源*/
-        if (abort_tasks) {
+        if (aborted()) {
             ESP_LOGW(TAG, "HTTP download aborted");
             esp_http_client_close(client);
             esp_http_client_cleanup(client);
@@ -600,7 +613,7 @@ namespace apl{
         
         if (err != ESP_OK) {
             ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
-            lv_async_call([](void* arg) {
+            fml::HdlManager::lvgl_async_call([](void* arg) {
                 Painter* app = static_cast<Painter*>(arg);
                 if (app->current_image) {
                     lv_obj_t* parent = lv_obj_get_parent(app->current_image);
@@ -640,7 +653,7 @@ namespace apl{
             std::lock_guard<std::mutex> lock(btn_mutex);
             is_send_btn_busy = enabled;
         }
-        lv_async_call([](void* arg) {
+        fml::HdlManager::lvgl_async_call([](void* arg) {
             Painter* app = static_cast<Painter*>(arg);
             if (!app->is_send_btn_busy) {
                 lv_obj_set_style_bg_color(app->send_btn, lv_color_hex(PAINTER_SEND_BTN_UP_COLOR), 0);
@@ -659,7 +672,7 @@ namespace apl{
             std::lock_guard<std::mutex> lock(btn_mutex);
             is_voice_btn_busy = enabled;
         }
-        lv_async_call([](void* arg) {
+        fml::HdlManager::lvgl_async_call([](void* arg) {
             Painter* app = static_cast<Painter*>(arg);
             if (!app->is_voice_btn_busy) {
                 lv_obj_set_style_bg_color(app->voice_btn, lv_color_hex(PAINTER_VOICE_BTN_UP_COLOR), 0);
@@ -692,13 +705,22 @@ namespace apl{
         kb = NULL;
         cand_panel = NULL;
         /*初始化JPEG解码相关变量*/
-        memset(&img_dsc, 0, sizeof(img_dsc));
         current_image = NULL;
         is_jpeg_valid = false;
         downloaded_size = 0;
-        abort_tasks = false;
-        decode_task_handle = NULL;
-        download_task_handle = NULL;
+        image_generation = 0;
+        download_generation = 0;
+        /*输出缓冲区一次分配，之后每张图像都复用*/
+        memset(img_slots, 0, sizeof(img_slots));
+        for (int i = 0; i < PAINTER_IMG_SLOT_NUM; i++) {
+            img_slots[i].app = this;
+            img_slots[i].buff = (uint8_t*)heap_caps_aligned_alloc(16, PAINTER_IMG_BUFF_LEN, MALLOC_CAP_SPIRAM);
+            if (img_slots[i].buff == NULL) ESP_LOGE(TAG, "image buffer malloc fialed");
+        }
+        img_events = xEventGroupCreate();
+        if (img_events != NULL) xEventGroupSetBits(img_events, PAINTER_EVT_DECODE_IDLE);
+        download_sem = xSemaphoreCreateBinary();
+        if (download_sem != NULL) xSemaphoreGive(download_sem);
         is_send_btn_busy = false;
         is_voice_btn_busy = false;
         ESP_LOGI(TAG, "Painter on construct");
@@ -706,27 +728,14 @@ namespace apl{
 
     Painter::~Painter()
     {
-        /* 强制终止所有后台任务 */
-        abort_tasks = true;
-
-        /*终止下载任务*/
-        if (download_task_handle != NULL) {
-            if (eTaskGetState(download_task_handle) != eDeleted) {
-                vTaskDelete(download_task_handle);
-                ESP_LOGW(TAG, "Force deleted download task in destructor");
-            }
-            download_task_handle = NULL;
+        /* 作废后台任务，等下载任务和解码回调退出，都有超时 */
+        {
+            std::lock_guard<std::mutex> lock(img_mutex);
+            image_generation++;
         }
+        bool idle = (xSemaphoreTake(download_sem, pdMS_TO_TICKS(PAINTER_DOWNLOAD_WAIT_MS)) == pdTRUE);
+        idle = idle && (xEventGroupWaitBits(img_events, PAINTER_EVT_DECODE_IDLE, pdFALSE, pdTRUE, pdMS_TO_TICKS(PAINTER_DECODE_WAIT_MS)) & PAINTER_EVT_DECODE_IDLE);
         
-        /*终止解码任务*/
-        if (decode_task_handle != NULL) {
-            if (eTaskGetState(decode_task_handle) != eDeleted) {
-                vTaskDelete(decode_task_handle);
-                ESP_LOGW(TAG, "Force deleted decode task in destructor");
-            }
-            decode_task_handle = NULL;
-        }
-
         /*确保清理所有资源*/
         reset(); 
 
@@ -735,6 +744,17 @@ namespace apl{
             lv_obj_del(main_cont);
             main_cont = NULL;
         }
+        /*图像对象都已删除，最后释放输出缓冲区；后台任务没有退出时不释放，避免解码写入已释放的内存*/
+        if (idle) {
+            for (int i = 0; i < PAINTER_IMG_SLOT_NUM; i++) {
+                if (img_slots[i].buff) heap_caps_free(img_slots[i].buff);
+                img_slots[i].buff = NULL;
+            }
+            vEventGroupDelete(img_events);
+            vSemaphoreDelete(download_sem);
+        } else {
+            ESP_LOGE(TAG, "background task still running, image buffers not freed");
+        }
         
         /*重置所有指针*/
         title_bar = NULL;
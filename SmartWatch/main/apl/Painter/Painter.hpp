@@ -13,6 +13,8 @@
 #include <esp_log.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
 #include <vector>
 #include <string>
 #include <algorithm>
@@ -57,13 +59,19 @@ namespace apl{
 
         #define PAINTER_MSG_BUBBLE_ANSWER_X                           (21)
         #define PAINTER_MSG_BUBBLE_ANSWER_Y                           (78)
-        #define PAINTER_MSG_BUBBLE_ANSWER_W                           (120)         /*需要8的倍数，不然解码会失败*/
-        #define PAINTER_MSG_BUBBLE_ANSWER_H                           (96)          /*需要8的倍数，不然解码会失败*/    
+        #define PAINTER_MSG_BUBBLE_ANSWER_W                           (120)         /*缩放解码的目标尺寸*/
+        #define PAINTER_MSG_BUBBLE_ANSWER_H                           (96)
+        #if (PAINTER_MSG_BUBBLE_ANSWER_W % JPEGDECODER_SCALE_ALIGN) != 0 || (PAINTER_MSG_BUBBLE_ANSWER_H % JPEGDECODER_SCALE_ALIGN) != 0
+        #error "PAINTER_MSG_BUBBLE_ANSWER_W/H must be multiples of JPEGDECODER_SCALE_ALIGN"
+        #endif
 
         #define PAINTER_MAX_IMAGE_SIZE                                (300*1024) 
+        #define PAINTER_IMG_BUFF_LEN                                  (PAINTER_MSG_BUBBLE_ANSWER_W * PAINTER_MSG_BUBBLE_ANSWER_H * BLL_JPEG_PIXEL_BYTE)
+        #define PAINTER_IMG_SLOT_NUM                                  (2)           /*发送时清空消息，最多一张显示中、一张解码中*/
 
-        #define PAINTER_JPEG_DECODE_TASK_PRIOR                        (2)
-        #define PAINTER_JPEG_DECODE_TASK_CORE                         (1)
+        #define PAINTER_DOWNLOAD_WAIT_MS                              (20000)       /*等上一个下载任务退出，大于HTTP超时*/
+        #define PAINTER_DECODE_WAIT_MS                                (1000)        /*等上一次解码回调返回*/
+        #define PAINTER_EVT_DECODE_IDLE                               (1 << 0)      /*没有已提交、回调还没有返回的解码请求*/
 
         #define PAINTER_JPEG_DOWNLOAD_TASK_PRIOR                      (2)
         #define PAINTER_JPEG_DOWNLOAD_TASK_CORE                       (1)
@@ -87,9 +95,20 @@ namespace apl{
             char* text;
         };
 
-        struct DecodeTaskData {
+        enum painter_img_state_t {
+            PAINTER_IMG_FREE = 0,
+            PAINTER_IMG_DECODING,
+            PAINTER_IMG_SHOWN,
+        };
+
+        /*一张图像气泡的解码输出，缓冲区在构造时预分配并一直复用，图像对象删除时槽位才空闲，显示中的图像不会被下一次解码覆盖*/
+        struct painter_image_t {
             Painter* app;
-            std::vector<uint8_t> buffer;
+            lv_img_dsc_t dsc;
+            uint8_t* buff;
+            painter_img_state_t state;                      /*由img_mutex保护*/
+            uint32_t generation;                            /*提交时的image_generation，不一致时结果作废*/
+            int64_t start_us;                               /*提交解码的时间*/
         };
 
         private:
@@ -110,15 +129,17 @@ namespace apl{
             lv_obj_t *cand_panel;                           /*汉字候选框*/
 
             /*JPEG 解码相关成员*/
-            lv_img_dsc_t img_dsc;
+            painter_image_t img_slots[PAINTER_IMG_SLOT_NUM];
+            std::mutex img_mutex;                           /*保护槽位状态、image_url和解码的提交，下载任务、解码任务和LVGL任务都会访问*/
+            EventGroupHandle_t img_events;                  /*PAINTER_EVT_DECODE_IDLE*/
+            SemaphoreHandle_t download_sem;                 /*同一时间只有一个下载任务，持有期间独占download_buffer*/
+            volatile uint32_t image_generation;             /*reset时加一，作废进行中的下载和解码，不需要等待它们退出*/
+            volatile uint32_t download_generation;          /*当前下载任务开始时的image_generation*/
             std::vector<uint8_t> download_buffer;
             lv_obj_t* current_image;
             std::string image_url;
             bool is_jpeg_valid;                             /*JPEG有效性标志*/
             size_t downloaded_size;                         /*已下载字节数*/
-            volatile bool abort_tasks;                      /*任务终止标志*/
-            TaskHandle_t decode_task_handle;                /*解码任务句柄*/
-            TaskHandle_t download_task_handle;              /*下载任务句柄*/
             std::mutex btn_mutex;                           /*按钮状态互斥锁*/
             bool is_send_btn_busy;                          /*发送按钮忙状态*/
             bool is_voice_btn_busy;                         /*语音按钮忙状态*/
@@ -129,11 +150,15 @@ namespace apl{
             static void get_sr_pinyin(void* user_data, char* pinyin);
             static void voice_btn_event_cb(lv_event_t *e);
             static void ta_event_cb(lv_event_t *e);
-            static void jpeg_decode_task(void* arg);  
+            static void jpeg_decode_done_cb(fml::JpegDecoder::jpeg_dec_request_t* req, bool success);
+            static void image_delete_cb(lv_event_t *e);
             void reset();
             void start_image_download(const char* url);
             bool decode_jpeg();
-            void scale_and_display_image();
+            inline bool aborted(){return download_generation != image_generation;}
+            painter_image_t* acquire_img_slot();
+            void release_image(painter_image_t* img);
+            void scale_and_display_image(painter_image_t* img);
             void create_image_bubble(const char* url);
             static esp_err_t http_event_handler(esp_http_client_event_t *evt);
             void download_image();
@@ -26,46 +26,6 @@ namespace apl{
         }
     }
 
-    void WatchDial::bg_img_event_cb(lv_event_t* e)
-    {
-        static int old_jpeg_index = -1;
-        if(lv_event_get_code(e) == LV_EVENT_DRAW_POST_END){
-            if(old_jpeg_index != ((WatchDial*)lv_event_get_user_data(e))->lv_bg.cur_jpeg_index){
-                /*图片已经渲染到屏幕*/
-                fml::JpegDecoder::getInstance().StartJpegDec(((WatchDial*)lv_event_get_user_data(e))->lv_bg.cur_jpeg_index, ((WatchDial*)lv_event_get_user_data(e))->lv_bg.jpeg_src);
-                old_jpeg_index = ((WatchDial*)lv_event_get_user_data(e))->lv_bg.cur_jpeg_index;
-            }
-        }
-    }
-
-    void WatchDial::get_lv_bg(struct watchdial_lv_bg_t* lv_bg, struct watchdial_lv_screen_t* lv_screen, void* arg)
-    {
-        if(lv_bg != NULL && lv_screen != NULL){
-            fml::JpegDecoder::FindJpegMaterial(BLL_JPEG_DESC_PATH,WATCHDIAL_TAG_NAME,&lv_bg->start_jpeg_index, &lv_bg->end_jpeg_index);
-            lv_bg->jpeg_src.jpeg_len = BLL_JPEG_OUTPUT_WIDTH * BLL_JPEG_OUTPUT_HEIGHT * BLL_JPEG_PIXEL_BYTE;
-            lv_bg->jpeg_src.jpeg_buff = (uint8_t*)heap_caps_aligned_alloc(16, lv_bg->jpeg_src.jpeg_len, MALLOC_CAP_SPIRAM);
-            lv_bg->cur_jpeg_index = lv_bg->start_jpeg_index;
-            lv_bg->img = lv_img_create(lv_screen->tile);
-            lv_obj_add_event_cb(lv_bg->img, bg_img_event_cb, LV_EVENT_DRAW_POST_END, arg);
-            lv_obj_align(lv_bg->img, LV_ALIGN_CENTER, 0, 0);
-            //设置背景图像描述
-            lv_bg->img_dsc.header.w = BLL_JPEG_OUTPUT_WIDTH;
-            lv_bg->img_dsc.header.h = BLL_JPEG_OUTPUT_HEIGHT;
-            lv_bg->img_dsc.header.cf = BLL_LV_COLOR_FORMAT; 
-            lv_bg->img_dsc.data = lv_bg->jpeg_src.jpeg_buff;
-            lv_bg->img_dsc.data_size = lv_bg->jpeg_src.jpeg_len;
-        }
-    }
-
-    void WatchDial::set_lv_bg(struct watchdial_lv_bg_t* lv_bg, uint8_t* data)
-    {
-        if(lv_bg != NULL && data != NULL){
-            lv_bg->img_dsc.data = data;
-            lv_img_set_src(lv_bg->img, &lv_bg->img_dsc);  
-            lv_obj_align(lv_bg->img, LV_ALIGN_CENTER, 0, 0);
-        }
-    }
-
     void WatchDial::get_lv_status(struct watchdial_lv_status_t* lv_status, struct watchdial_lv_screen_t* lv_screen)
     {
         if(lv_status != NULL && lv_screen != NULL){
@@ -170,18 +130,23 @@ namespace apl{
     void WatchDial::get_lv_time(struct watchdial_lv_time_t* lv_time, struct watchdial_lv_screen_t* lv_screen)
     {
         if(lv_time != NULL && lv_screen != NULL){
+            /*表盘字库放在littlefs中按需读取，读取失败时退回默认字库*/
+            const lv_font_t* font_hm = fml::GlyphFont::getInstance().LoadFont(BLL_FONT_CLOCK_50_PATH);
+            const lv_font_t* font_mw = fml::GlyphFont::getInstance().LoadFont(BLL_FONT_CLOCK_25_PATH);
+            if(font_hm == NULL)font_hm = LV_FONT_DEFAULT;
+            if(font_mw == NULL)font_mw = LV_FONT_DEFAULT;
             lv_time->hm_lable = lv_label_create(lv_screen->tile);
             lv_obj_set_pos(lv_time->hm_lable, WATCHDIAL_LV_TIME_HM_X, WATCHDIAL_LV_TIME_HM_Y);
             lv_obj_set_size(lv_time->hm_lable, WATCHDAIL_LV_TIME_HM_W, WATCHDIAL_LV_TIME_HM_H);
             lv_obj_set_style_text_color(lv_time->hm_lable, lv_color_hex(0xffffff), 0);
-            lv_obj_set_style_text_font(lv_time->hm_lable, &lv_font_ArchitectsDaughter_50, 0);
+            lv_obj_set_style_text_font(lv_time->hm_lable, font_hm, 0);
             lv_obj_set_style_text_align(lv_time->hm_lable, LV_TEXT_ALIGN_RIGHT, 0);
 
             lv_time->mw_lable = lv_label_create(lv_screen->tile);
             lv_obj_set_pos(lv_time->mw_lable, WATCHDIAL_LV_TIME_MW_X, WATCHDIAL_LV_TIME_MW_Y);
             lv_obj_set_size(lv_time->mw_lable, WATCHDAIL_LV_TIME_MW_W, WATCHDIAL_LV_TIME_MW_H);
             lv_obj_set_style_text_color(lv_time->mw_lable, lv_color_hex(0xffffff), 0);
-            lv_obj_set_style_text_font(lv_time->mw_lable, &lv_font_ArchitectsDaughter_25, 0);
+            lv_obj_set_style_text_font(lv_time->mw_lable, font_mw, 0);
             lv_obj_set_style_text_align(lv_time->mw_lable, LV_TEXT_ALIGN_RIGHT, 0);
         }
     }
@@ -208,7 +173,6 @@ namespace apl{
     WatchDial::WatchDial(lv_obj_t* screen, lv_obj_t* tileview, lv_obj_t* tile)
     {
         memset(&lv_screen, 0, sizeof(lv_screen));
-        memset(&lv_bg, 0, sizeof(lv_bg));
         memset(&lv_status, 0, sizeof(lv_status));
         memset(&lv_time, 0, sizeof(lv_time));
 
@@ -228,8 +192,7 @@ namespace apl{
         /*自动递归删除其子对象*/
         if(lv_status.container != NULL)lv_obj_del(lv_status.container);
 
-        if(lv_bg.img != NULL)lv_obj_del(lv_bg.img);
-        if(lv_bg.jpeg_src.jpeg_buff != NULL)heap_caps_free(lv_bg.jpeg_src.jpeg_buff);
+        lv_bg.destroy();
 
         ESP_LOGI(TAG, "WatchDial on deconstruct");
     }
@@ -237,16 +200,13 @@ namespace apl{
     void WatchDial::onCreate()
     {
         /*获取背景图像控件 */
-        get_lv_bg(&lv_bg, &lv_screen, this);
+        lv_bg.create(lv_screen.tile, WATCHDIAL_TAG_NAME);
         /*获取状态栏控件*/
         get_lv_status(&lv_status, &lv_screen);
         /*获取时间控件*/
         get_lv_time(&lv_time, &lv_screen);
-        /*开启解码*/
-        fml::JpegDecoder::getInstance().StartJpegDec(lv_bg.cur_jpeg_index, lv_bg.jpeg_src);
-        fml::JpegDecoder::getInstance().WaitJpegDec(NULL, portMAX_DELAY);
-        /*解码成功，设置控件*/
-        set_lv_bg(&lv_bg, lv_bg.jpeg_src.jpeg_buff);
+        /*显示第一帧，输出环模式下等待解码完成*/
+        lv_bg.update(portMAX_DELAY);
         /*设置为主界面*/
         lv_tileview_set_tile(lv_screen.tileview,lv_screen.tile,LV_ANIM_OFF);
         ESP_LOGI(TAG, "WatchDial on create");
@@ -259,19 +219,8 @@ namespace apl{
 
     void WatchDial::onForeground()
     {
-        int cur_jpeg_index;
         /*刷新背景图*/
-        if(fml::JpegDecoder::getInstance().WaitJpegDec(&cur_jpeg_index, 0) == true){
-            if(lv_bg.start_jpeg_index <= cur_jpeg_index && cur_jpeg_index <= lv_bg.end_jpeg_index){
-                /*设置下一个要解码的index*/
-                lv_bg.cur_jpeg_index++;
-                if(lv_bg.cur_jpeg_index > lv_bg.end_jpeg_index)lv_bg.cur_jpeg_index = lv_bg.start_jpeg_index;
-                /*解码成功，设置控件*/
-                set_lv_bg(&lv_bg, lv_bg.jpeg_src.jpeg_buff);
-            }else{
-                fml::JpegDecoder::getInstance().StartJpegDec(lv_bg.cur_jpeg_index, lv_bg.jpeg_src);
-            }
-        }
+        lv_bg.update(0);
         /*更新电量状态*/
         set_lv_status_bat(&lv_status, HdlManager::getInstance().get_battery_level(), HdlManager::getInstance().get_battery_is_charging());
         /*更新时间状态*/
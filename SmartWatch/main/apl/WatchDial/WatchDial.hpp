@@ -15,6 +15,7 @@
 #include <freertos/task.h>
 #include <sys/time.h>
 #include "bll.hpp"
+#include "AnimWallpaper.hpp"
 
 using namespace fml;
 
@@ -41,15 +42,6 @@ namespace apl{
             lv_obj_t* tile;
         };
 
-        struct watchdial_lv_bg_t{
-            int start_jpeg_index;
-            int end_jpeg_index;
-            int cur_jpeg_index;
-            lv_obj_t* img;
-            lv_image_dsc_t img_dsc;
-            struct fml::JpegDecoder::jpeg_output_info_t jpeg_src;
-        };
-
         struct watchdial_lv_status_t{
             lv_obj_t* container;
             lv_obj_t* wifi_lable;
@@ -67,16 +59,12 @@ namespace apl{
         private:
             const char* TAG = WATCHDIAL_TAG_NAME;
             struct watchdial_lv_screen_t lv_screen;
-            struct watchdial_lv_bg_t lv_bg;
+            AnimWallpaper lv_bg;
             struct watchdial_lv_status_t lv_status;
             struct watchdial_lv_time_t lv_time;
 
             static void tileview_event_cb(lv_event_t * e);
 
-            static void bg_img_event_cb(lv_event_t* e);
-            static void get_lv_bg(struct watchdial_lv_bg_t* lv_bg, struct watchdial_lv_screen_t* lv_screen, void* arg);
-            static void set_lv_bg(struct watchdial_lv_bg_t* lv_bg, uint8_t* data);
-
             static void get_lv_status(struct watchdial_lv_status_t* lv_status, struct watchdial_lv_screen_t* lv_screen);
             static void set_lv_status_time(struct watchdial_lv_status_t* lv_status, struct tm* tm);
             static void set_lv_status_bat(struct watchdial_lv_status_t* lv_status, int percent, bool is_charge);
@@ -40,6 +40,9 @@ namespace apl{
     {
         /*自动递归释放子控件*/
         if(screen != NULL)lv_obj_del(screen);
+        for(auto& snap : tile_snapshots){
+            if(snap.data != NULL)heap_caps_free(snap.data);
+        }
         /*销毁app*/
         if(WatchDial_id != -1)mc.extensionManager()->destroyAbility(WatchDial_id);
         if(AppStore_id != -1)mc.extensionManager()->destroyAbility(AppStore_id);
@@ -54,6 +57,17 @@ namespace apl{
         lv_event_code_t code = lv_event_get_code(e);
         apl* app = (apl*)lv_event_get_user_data(e);
 
+#if APL_TILE_SNAPSHOT_ENABLE
+        /*滑动期间只移动快照，不再每帧重绘两个tile的全部控件*/
+        if(lv_event_get_target(e) == app->tileview){
+            if((code == LV_EVENT_SCROLL_BEGIN) || (code == LV_EVENT_SCROLL)){
+                app->tile_snapshot_update();
+            }else if(code == LV_EVENT_SCROLL_END){
+                app->tile_snapshot_release();
+            }
+        }
+#endif
+
         /*切换事件处理*/
         if (code == LV_EVENT_VALUE_CHANGED) {
             mooncake::AbilityManager* am = app->mc.extensionManager();
@@ -193,6 +207,65 @@ namespace apl{
         lv_obj_set_style_text_letter_space(lv_boot.label, 5, 0);
     }
 
+    void apl::tile_snapshot_take(struct apl_tile_snapshot_t* snap)
+    {
+        int32_t w = lv_obj_get_width(snap->tile);
+        int32_t h = lv_obj_get_height(snap->tile);
+        uint32_t stride = lv_draw_buf_width_to_stride(w, LV_COLOR_FORMAT_RGB565);
+        uint32_t size = stride * h;
+        /*缓冲区常驻复用，分辨率变大(旋转)时重新分配*/
+        if(snap->data_size < size){
+            if(snap->data != NULL)heap_caps_free(snap->data);
+            snap->data = heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, size, MALLOC_CAP_SPIRAM);
+            snap->data_size = (snap->data != NULL) ? size : 0;
+            if(snap->data == NULL){
+                ESP_LOGW(TAG, "malloc tile snapshot buffer fialed:%d", (int)size);
+                snap->failed = true;
+                return;
+            }
+        }
+        lv_draw_buf_init(&snap->draw_buf, w, h, LV_COLOR_FORMAT_RGB565, stride, snap->data, snap->data_size);
+        if(lv_snapshot_take_to_draw_buf(snap->tile, LV_COLOR_FORMAT_RGB565, &snap->draw_buf) != LV_RESULT_OK){
+            ESP_LOGW(TAG, "take tile snapshot fialed");
+            snap->failed = true;
+            return;
+        }
+        lv_image_cache_drop(&snap->draw_buf);
+
+        /*隐藏实时控件，改为显示快照*/
+        uint32_t cnt = lv_obj_get_child_count(snap->tile);
+        for(uint32_t i = 0; i < cnt; i++){
+            lv_obj_t* child = lv_obj_get_child(snap->tile, i);
+            if(!lv_obj_has_flag(child, LV_OBJ_FLAG_HIDDEN)){
+                lv_obj_add_flag(child, LV_OBJ_FLAG_HIDDEN);
+                snap->hidden.push_back(child);
+            }
+        }
+        snap->img = lv_image_create(snap->tile);
+        lv_obj_set_pos(snap->img, 0, 0);
+        lv_image_set_src(snap->img, &snap->draw_buf);
+    }
+
+    void apl::tile_snapshot_update()
+    {
+        /*tile第一次进入视野时截取快照，失败的tile这次滑动按实时控件绘制，不在每个滑动步重新分配和截取*/
+        for(auto& snap : tile_snapshots){
+            if((snap.img == NULL) && !snap.failed && lv_obj_is_visible(snap.tile))tile_snapshot_take(&snap);
+        }
+    }
+
+    void apl::tile_snapshot_release()
+    {
+        for(auto& snap : tile_snapshots){
+            snap.failed = false;
+            if(snap.img == NULL)continue;
+            lv_obj_delete(snap.img);
+            snap.img = NULL;
+            for(auto child : snap.hidden)lv_obj_clear_flag(child, LV_OBJ_FLAG_HIDDEN);
+            snap.hidden.clear();
+        }
+    }
+
     void apl::tileview_overlap_container_set(APL_TILEVIEW_TILE_OVERLAP_CONTAINER_CONTAINER_DISPLAY_E cur_disp)
     {
         mooncake::AbilityManager* am = mc.extensionManager();
@@ -273,13 +346,44 @@ namespace apl{
         lv_obj_remove_style_all(OverLap_tile_container_Gamepad);
         lv_obj_set_size(OverLap_tile_container_Gamepad, APL_SCREEN_W, APL_SCREEN_H);
         lv_obj_add_flag(OverLap_tile_container_Gamepad, LV_OBJ_FLAG_HIDDEN);
+        tile_snapshots[0].tile = WatchDial_tile;
+        tile_snapshots[1].tile = AppStore_tile;
+        tile_snapshots[2].tile = Setting_tile;
+        tile_snapshots[3].tile = OverLap_tile;
         /*添加视图回调事件*/
         lv_obj_add_event_cb(tileview, tileview_event_cb, LV_EVENT_ALL, this);
 
 
 
         /*初始化功能模块层*/
-        fml::JpegDecoder::getInstance().Init(BLL_JPEG_DIR_PATH,BLL_JPEG_PIXEL_FORMAT,BLL_JPEG_ROTATE,JpegDecoderInputInfoCallBack,&lv_boot);
+        /*壁纸容器优先直接使用映射的素材分区，分区里没有时再从littlefs读取*/
+        size_t jpak_len = 0;
+        const uint8_t* jpak = NULL;
+        if(fml::AssetPartition::getInstance().Init(BLL_ASSET_PARTITION_LABEL) == true){
+            fml::AssetPartition::getInstance().PrintInfo();
+            jpak = fml::AssetPartition::getInstance().Find(BLL_ASSET_JPAK_NAME, &jpak_len);
+        }
+        /*分区中的容器损坏时也改用littlefs*/
+        if(jpak == NULL || fml::JpegDecoder::getInstance().Init(jpak,jpak_len,BLL_JPEG_PIXEL_FORMAT,BLL_JPEG_ROTATE,JpegDecoderInputInfoCallBack,&lv_boot) != true){
+            /*littlefs也没有可用的素材时解码任务照常启动，壁纸动画找不到动画表，不播放*/
+            if(fml::JpegDecoder::getInstance().Init(BLL_JPEG_PATH,BLL_JPEG_PIXEL_FORMAT,BLL_JPEG_ROTATE,JpegDecoderInputInfoCallBack,&lv_boot) != true){
+                ESP_LOGE(TAG, "load %s fialed, wallpaper animations disabled", BLL_JPEG_PATH);
+            }
+        }
+        struct fml::JpegDecoder::jpeg_anim_info_t jpeg_anim;
+        if(fml::JpegDecoder::getInstance().FindJpegAnimation(BLL_JPEG_DESC_PATH, WATCHDIAL_TAG_NAME, &jpeg_anim) == true){
+            fml::JpegDecoder::getInstance().SetRangeConfig(jpeg_anim.start, jpeg_anim.end, BLL_JPEG_WATCHDIAL_LOAD_MODE, BLL_JPEG_WATCHDIAL_READ_AHEAD);
+        }
+        if(fml::JpegDecoder::getInstance().FindJpegAnimation(BLL_JPEG_DESC_PATH, APPSTORE_TAG_NAME, &jpeg_anim) == true){
+            fml::JpegDecoder::getInstance().SetRangeConfig(jpeg_anim.start, jpeg_anim.end, BLL_JPEG_APPSTORE_LOAD_MODE, BLL_JPEG_APPSTORE_READ_AHEAD);
+        }
+        fml::JpegDecoder::getInstance().SetDecodedCacheBytes(BLL_JPEG_DECODED_CACHE_BYTES);
+        #if BLL_JPEG_DECODE_BENCH_ITERATIONS > 0
+        /*按聊天图片的尺寸解码第一帧*/
+        fml::JpegDecoder::getInstance().DecodeBenchmark(1, PAINTER_MSG_BUBBLE_ANSWER_W, PAINTER_MSG_BUBBLE_ANSWER_H, BLL_JPEG_DECODE_BENCH_ITERATIONS);
+        #endif
+        fml::LvglImgDecoder::getInstance().Init(BLL_LVGL_IMG_CACHE_BYTES);
+        fml::GlyphFont::getInstance().Init(BLL_GLYPH_CACHE_BYTES);
         fml::SpeechRecongnition::getInstance().sr_register_get_audio_callback(get_m_audio);
         fml::SpeechRecongnition::getInstance().init("M", cmd_phoneme, sizeof(cmd_phoneme) / sizeof(cmd_phoneme[0]));
         fml::TextToSpeech::getInstance().tts_register_set_audio_callback(set_m_audio);
@@ -310,27 +414,34 @@ namespace apl{
         if(pdPASS == fml::SpeechRecongnition::getInstance().sr_get_result(&sr_result, 0)){
             ESP_LOGI(TAG, "sr_result:%d, %d, %s\n",sr_result.state, sr_result.command_id, sr_result.out_string.c_str());
             if(sr_result.state == 1){
+                /*只在切换界面时持有LVGL锁，语音播报不需要*/
+                bool handled = true;
+                fml::HdlManager::getInstance().lvgl_lock();
                 if(sr_result.command_id == sr_cmd[0].id){
                     tileview_overlap_container_set(APL_TILEVIEW_TILE_OVERLAP_CONTAINER_DISPLAY_ASSISTANT);
-                    fml::TextToSpeech::getInstance().tts_set_speech(&tts_resp, 0);
                 }else if(sr_result.command_id == sr_cmd[1].id){
                     tileview_overlap_container_set(APL_TILEVIEW_TILE_OVERLAP_CONTAINER_DISPLAY_PAINTER);
-                    fml::TextToSpeech::getInstance().tts_set_speech(&tts_resp, 0);
                 }else if(sr_result.command_id == sr_cmd[2].id){
                     tileview_overlap_container_set(APL_TILEVIEW_TILE_OVERLAP_CONTAINER_DISPLAY_GAMEPAD);
-                    fml::TextToSpeech::getInstance().tts_set_speech(&tts_resp, 0);
                 }else if(sr_result.command_id == sr_cmd[3].id){
                     lv_tileview_set_tile_by_index(tileview, APL_TILEVIEW_TILE_COL_ID_WATCHDIAL, APL_TILEVIEW_TILE_ROW_ID_WATCHDIAL, LV_ANIM_ON);
-                    fml::TextToSpeech::getInstance().tts_set_speech(&tts_resp, 0);
                 }else if(sr_result.command_id == sr_cmd[4].id){
                     lv_tileview_set_tile_by_index(tileview, APL_TILEVIEW_TILE_COL_ID_SETTING,APL_TILEVIEW_TILE_ROW_ID_SETTING, LV_ANIM_ON);
-                    fml::TextToSpeech::getInstance().tts_set_speech(&tts_resp, 0);
+                }else{
+                    handled = false;
                 }
+                fml::HdlManager::getInstance().lvgl_unlock();
+                if(handled == true)fml::TextToSpeech::getInstance().tts_set_speech(&tts_resp, 0);
             }
         }
         
         
+        /*各个应用的onRunning都在操作LVGL对象*/
+        fml::HdlManager::getInstance().telemetry_app_begin();
+        fml::HdlManager::getInstance().lvgl_lock();
         mc.update();
+        fml::HdlManager::getInstance().lvgl_unlock();
+        fml::HdlManager::getInstance().telemetry_app_end();
     }
 
 
@@ -14,6 +14,8 @@
 #include <esp_log.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <esp_heap_caps.h>
+#include <vector>
 #include "WatchDial.hpp"
 #include "AppStore.hpp"
 #include "Assistant.hpp"
@@ -45,11 +47,24 @@ namespace apl{
         #define APL_TILEVIEW_TILE_COL_ID_OVERLAP                        (2)
         #define APL_TILEVIEW_TILE_ROW_ID_OVERLAP                        (1)
 
+        #define APL_TILEVIEW_TILE_NUM                                   (4)
+        #define APL_TILE_SNAPSHOT_ENABLE                                (1)     /*1:tileview滑动期间用PSRAM快照代替实时控件，结束后恢复*/
+
         struct apl_lv_boot_t{      
             lv_obj_t* background;
             lv_obj_t* label;
         };
 
+        struct apl_tile_snapshot_t{
+            lv_obj_t* tile;
+            lv_obj_t* img;                                      /*滑动期间显示快照的图片，NULL表示未使用快照*/
+            lv_draw_buf_t draw_buf;
+            void* data;                                         /*PSRAM快照缓冲区，首次使用时分配，之后复用*/
+            uint32_t data_size;
+            std::vector<lv_obj_t*> hidden;                      /*被隐藏的实时控件，滑动结束后恢复*/
+            bool failed;                                        /*本次滑动中分配或截取失败，滑动结束前不再重试*/
+        };
+
         typedef enum {
             APL_TILEVIEW_TILE_OVERLAP_CONTAINER_DISPLAY_ASSISTANT = 0,
             APL_TILEVIEW_TILE_OVERLAP_CONTAINER_DISPLAY_PAINTER,
@@ -69,6 +84,7 @@ namespace apl{
             lv_obj_t* OverLap_tile_container_Painter;
             lv_obj_t* OverLap_tile_container_Gamepad;
             APL_TILEVIEW_TILE_OVERLAP_CONTAINER_CONTAINER_DISPLAY_E cur_overlap_container_disp;
+            struct apl_tile_snapshot_t tile_snapshots[APL_TILEVIEW_TILE_NUM] = {};
             
             int WatchDial_id;
             int AppStore_id;
@@ -98,6 +114,9 @@ namespace apl{
             static void lv_marquee_icon_event_cb(lv_event_t * e);
 
             void init_lv_boot();
+            void tile_snapshot_take(struct apl_tile_snapshot_t* snap);
+            void tile_snapshot_update();
+            void tile_snapshot_release();
         public:
             /*获取单例实例的静态方法*/
             inline static apl& getInstance() {
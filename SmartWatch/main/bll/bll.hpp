@@ -20,19 +20,31 @@ LV_IMAGE_DECLARE(_Setting_BG_RGB565_240x280);
 LV_IMAGE_DECLARE(_GamePad_BG_RGB565_240x280);
 LV_IMAGE_DECLARE(_painter_bg_RGB565_240x280);
 
-LV_FONT_DECLARE(lv_font_ArchitectsDaughter_50);
-LV_FONT_DECLARE(lv_font_ArchitectsDaughter_25);
 LV_FONT_DECLARE(lv_font_montserrat_16);
 LV_FONT_DECLARE(MyFonts16);/*unicode编码范围：0x4e00-0x9fff,0x00-0x7f,0x3000-0x303f,0xff00-0xffef,0x2010-0x205f*/
 
-#define BLL_JPEG_DIR_PATH                                           "/littlefs/JpegMaterials"
-#define BLL_JPEG_DESC_PATH                                          "/littlefs/JpegMaterialsDesc.txt"
+#define BLL_ASSET_PARTITION_LABEL                                   "assets"            /*只读素材分区，启动时整个映射进地址空间*/
+#define BLL_ASSET_JPAK_NAME                                         "JpegMaterials.jpak"
+#define BLL_JPEG_PATH                                               "/littlefs/JpegMaterials.jpak"      /*素材分区中没有JPAK容器时使用，也可以是帧目录*/
+#define BLL_JPEG_DESC_PATH                                          "/littlefs/JpegMaterialsDesc.txt"   /*帧目录模式下的动画描述文件*/
 #define BLL_JPEG_OUTPUT_WIDTH                                       (DISPLAY_WIDTH)
 #define BLL_JPEG_OUTPUT_HEIGHT                                      (DISPLAY_HEIGHT)
 #define BLL_JPEG_PIXEL_BYTE                                         (16/8)
 #define BLL_JPEG_PIXEL_FORMAT                                       (JPEG_PIXEL_FORMAT_RGB565_LE)
 #define BLL_JPEG_ROTATE                                             (JPEG_ROTATE_0D)
 #define BLL_LV_COLOR_FORMAT                                         (LGVL_COLORDEPTH)
+#define BLL_JPEG_BLOCK_MODE                                         (1)     /*1:渲染时块模式解码到LVGL条带，不需要整帧缓存; 0:解码任务解码整帧到输出环*/
+#define BLL_JPEG_DECODE_BENCH_ITERATIONS                            (0)     /*大于0时启动后对比两个Decode重载的耗时和分配，0为关闭*/
+#define BLL_JPEG_DECODED_CACHE_BYTES                                (1024*1024)     /*解码结果缓存的PSRAM预算，短循环动画的帧可以不再重复解码，0为关闭*/
+#define BLL_LVGL_IMG_CACHE_BYTES                                    (640*1024)      /*压缩背景图片解压结果的PSRAM预算，4张240x280背景共525KB*/
+#define BLL_GLYPH_CACHE_BYTES                                       (64*1024)       /*按需读取的字形位图缓存的PSRAM预算*/
+#define BLL_FONT_CLOCK_50_PATH                                      "/littlefs/fonts/ArchitectsDaughter_50.lvgf"    /*表盘时分，只有数字和冒号*/
+#define BLL_FONT_CLOCK_25_PATH                                      "/littlefs/fonts/ArchitectsDaughter_25.lvgf"    /*表盘月日和星期*/
+/*各段壁纸素材的加载策略：JPEG_LOAD_PRELOAD启动时全部读入，JPEG_LOAD_LAZY按需读取并预读后续几帧*/
+#define BLL_JPEG_WATCHDIAL_LOAD_MODE                                (fml::JpegDecoder::JPEG_LOAD_LAZY)
+#define BLL_JPEG_WATCHDIAL_READ_AHEAD                               (3)
+#define BLL_JPEG_APPSTORE_LOAD_MODE                                 (fml::JpegDecoder::JPEG_LOAD_LAZY)
+#define BLL_JPEG_APPSTORE_READ_AHEAD                                (3)
 
 struct sr_cmd_t {
     int id;
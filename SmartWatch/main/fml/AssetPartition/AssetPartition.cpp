@@ -0,0 +1,103 @@
+/**
+ * @file AssetPartition.cpp
+ * @author 李威延
+ * @brief
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "AssetPartition.hpp"
+
+namespace fml{
+
+    AssetPartition::AssetPartition()
+    {
+        base = NULL;
+        header = NULL;
+        entries = NULL;
+        mmap_handle = 0;
+    }
+
+    AssetPartition::~AssetPartition()
+    {
+        if(base != NULL)esp_partition_munmap(mmap_handle);
+    }
+
+    bool AssetPartition::Init(const char* label)
+    {
+        if(base != NULL)return true;
+        int64_t start_us = esp_timer_get_time();
+        const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+        if(part == NULL){
+            ESP_LOGW(TAG, "partition %s not found", label);
+            return false;
+        }
+        /*先只读头部校验，没有烧录素材的分区不做映射*/
+        astp_header_t head;
+        if(esp_partition_read(part, 0, &head, sizeof(head)) != ESP_OK || memcmp(head.magic, ASTP_MAGIC, 4) != 0 ||
+           head.version != ASTP_VERSION || head.total_size > part->size ||
+           head.total_size < sizeof(astp_header_t) + head.entry_number * sizeof(astp_entry_t)){
+            ESP_LOGW(TAG, "partition %s is not an ASTP v%d image", label, ASTP_VERSION);
+            return false;
+        }
+        const void* ptr = NULL;
+        esp_err_t err = esp_partition_mmap(part, 0, head.total_size, ESP_PARTITION_MMAP_DATA, &ptr, &mmap_handle);
+        if(err != ESP_OK){
+            ESP_LOGE(TAG, "mmap %s fialed, %s", label, esp_err_to_name(err));
+            return false;
+        }
+        base = (const uint8_t*)ptr;
+        header = (const astp_header_t*)base;
+        entries = (const astp_entry_t*)(base + sizeof(astp_header_t));
+        ESP_LOGI(TAG, "map %s: %d assets, %dKB at %p in %dus", label, header->entry_number,
+                (int)(header->total_size / 1024), base, (int)(esp_timer_get_time() - start_us));
+        return true;
+    }
+
+    const uint8_t* AssetPartition::Find(const char* name, size_t* size)
+    {
+        if(base == NULL || name == NULL)return NULL;
+        /*素材表按名称升序，二分查找*/
+        int lo = 0, hi = (int)header->entry_number - 1;
+        while(lo <= hi){
+            int mid = (lo + hi) / 2;
+            int cmp = strncmp(entries[mid].name, name, ASTP_NAME_LEN);
+            if(cmp == 0){
+                if(entries[mid].offset + entries[mid].size > header->total_size)return NULL;
+                if(size != NULL)*size = entries[mid].size;
+                return base + entries[mid].offset;
+            }
+            if(cmp < 0)lo = mid + 1;
+            else hi = mid - 1;
+        }
+        return NULL;
+    }
+
+    bool AssetPartition::GetImage(const char* name, lv_image_dsc_t* dsc)
+    {
+        size_t size = 0;
+        const uint8_t* data = Find(name, &size);
+        if(data == NULL || dsc == NULL || size <= sizeof(lv_image_header_t))return false;
+        lv_image_header_t img_header;
+        memcpy(&img_header, data, sizeof(img_header));
+        if(img_header.magic != LV_IMAGE_HEADER_MAGIC){
+            ESP_LOGE(TAG, "%s is not a LVGL image", name);
+            return false;
+        }
+        memset(dsc, 0, sizeof(lv_image_dsc_t));
+        dsc->header = img_header;
+        dsc->data = data + sizeof(lv_image_header_t);
+        dsc->data_size = size - sizeof(lv_image_header_t);
+        return true;
+    }
+
+    void AssetPartition::PrintInfo()
+    {
+        if(base == NULL)return;
+        for(int i = 0; i < header->entry_number; i++){
+            ESP_LOGI(TAG, "%8u %8u  %.*s", (unsigned)entries[i].offset, (unsigned)entries[i].size, ASTP_NAME_LEN, entries[i].name);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * @file AssetPartition.hpp
+ * @author 李威延
+ * @brief 只读素材分区：启动时整个分区映射进地址空间，素材直接在flash映射的内存上使用，不经过文件系统
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include "esp_partition.h"
+#include "lvgl.h"
+
+namespace fml{
+
+    class AssetPartition
+    {
+        #define ASTP_MAGIC                              "ASTP"
+        #define ASTP_VERSION                            (1)
+        #define ASTP_NAME_LEN                           (40)
+
+        /*ASTP格式，与process_assets/pack_assets.py一致，小端*/
+        struct astp_header_t{
+            char magic[4];
+            uint16_t version;
+            uint16_t entry_number;
+            uint32_t total_size;
+            uint32_t reserved;
+        };
+
+        struct astp_entry_t{
+            char name[ASTP_NAME_LEN];       /*相对assets目录的路径，按名称升序*/
+            uint32_t offset;                /*相对分区开头的偏移*/
+            uint32_t size;
+        };
+
+        private:
+            const char* TAG = "AssetPartition";
+            const uint8_t* base;            /*分区映射后的地址，NULL表示没有映射*/
+            const astp_header_t* header;
+            const astp_entry_t* entries;
+            esp_partition_mmap_handle_t mmap_handle;
+
+            /*私有构造函数，禁止外部直接实例化*/
+            AssetPartition();
+            ~AssetPartition();
+            /*禁止拷贝构造和赋值操作*/
+            AssetPartition(const AssetPartition&) = delete;
+            AssetPartition& operator = (const AssetPartition&) = delete;
+
+        public:
+            /*获取单例实例的静态方法*/
+            inline static AssetPartition& getInstance() {
+                static AssetPartition instance;
+                return instance;
+            }
+
+            /*映射label分区，分区不存在或者不是ASTP镜像时返回false，之后Find都返回NULL*/
+            bool Init(const char* label);
+            /*返回素材在映射内存中的地址，整个运行期间有效*/
+            const uint8_t* Find(const char* name, size_t* size);
+            /*LVGL的.bin图片(12字节lv_image_header_t加像素)，dsc->data直接指向flash映射的内存*/
+            bool GetImage(const char* name, lv_image_dsc_t* dsc);
+            void PrintInfo();
+    };
+}
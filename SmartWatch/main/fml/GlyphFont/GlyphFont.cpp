@@ -0,0 +1,273 @@
+/**
+ * @file GlyphFont.cpp
+ * @author 李威延
+ * @brief
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "GlyphFont.hpp"
+
+namespace fml{
+
+    GlyphFont::GlyphFont()
+    {
+        mutex = xSemaphoreCreateMutex();
+        memset(fonts, 0, sizeof(fonts));
+        font_number = 0;
+        memset(entries, 0, sizeof(entries));
+        for(int i = 0; i < GLYPHFONT_CACHE_BUCKETS; i++)buckets[i] = -1;
+        cache_bytes = 0;
+        cache_budget = 0;
+        use_clock = 0;
+        hit_count = 0;
+        miss_count = 0;
+        hit_us = 0;
+        miss_us = 0;
+    }
+
+    GlyphFont::~GlyphFont()
+    {
+        for(int i = 0; i < GLYPHFONT_CACHE_MAX; i++){
+            if(entries[i].bitmap != NULL)heap_caps_free(entries[i].bitmap);
+        }
+        for(int i = 0; i < font_number; i++){
+            if(fonts[i].file != NULL)fclose(fonts[i].file);
+            if(fonts[i].glyphs != NULL)heap_caps_free(fonts[i].glyphs);
+        }
+        if(mutex != NULL)vSemaphoreDelete(mutex);
+    }
+
+    void GlyphFont::Init(size_t cache_bytes)
+    {
+        cache_budget = cache_bytes;
+        ESP_LOGI(TAG, "GlyphFont on create, cache %dKB", (int)(cache_budget / 1024));
+    }
+
+    const lv_font_t* GlyphFont::LoadFont(const char* path)
+    {
+        for(int i = 0; i < font_number; i++){
+            if(strcmp(fonts[i].path, path) == 0)return &fonts[i].font;
+        }
+        if(font_number >= GLYPHFONT_FONT_MAX || strlen(path) >= GLYPHFONT_PATH_LEN)return NULL;
+
+        glyph_font_t* font = &fonts[font_number];
+        FILE* file = fopen(path, "rb");
+        if(file == NULL){
+            ESP_LOGE(TAG, "open %s fialed", path);
+            return NULL;
+        }
+        lvgf_header_t header;
+        if(fread(&header, 1, sizeof(header), file) != sizeof(header) || memcmp(header.magic, LVGF_MAGIC, 4) != 0 ||
+           header.version != LVGF_VERSION || header.glyph_number == 0){
+            ESP_LOGE(TAG, "%s is not a LVGF v%d font", path, LVGF_VERSION);
+            fclose(file);
+            return NULL;
+        }
+        /*字形索引常驻PSRAM，查询字形描述时不读文件*/
+        size_t index_len = header.glyph_number * sizeof(lvgf_glyph_t);
+        lvgf_glyph_t* glyphs = (lvgf_glyph_t*)heap_caps_malloc(index_len, MALLOC_CAP_SPIRAM);
+        if(glyphs == NULL || fseek(file, header.index_offset, SEEK_SET) != 0 || fread(glyphs, 1, index_len, file) != index_len){
+            ESP_LOGE(TAG, "read %s index fialed", path);
+            if(glyphs != NULL)heap_caps_free(glyphs);
+            fclose(file);
+            return NULL;
+        }
+
+        strcpy(font->path, path);
+        font->file = file;
+        font->header = header;
+        font->glyphs = glyphs;
+        lv_font_t* lv_font = &font->font;
+        lv_font->get_glyph_dsc = font_get_glyph_dsc;
+        lv_font->get_glyph_bitmap = font_get_glyph_bitmap;
+        lv_font->release_glyph = NULL;
+        lv_font->line_height = header.line_height;
+        lv_font->base_line = header.base_line;
+        lv_font->subpx = LV_FONT_SUBPX_NONE;
+        lv_font->kerning = LV_FONT_KERNING_NONE;
+        lv_font->underline_position = header.underline_position;
+        lv_font->underline_thickness = header.underline_thickness;
+        lv_font->dsc = NULL;
+        lv_font->fallback = NULL;
+        lv_font->user_data = font;
+        font_number++;
+        ESP_LOGI(TAG, "load %s: %u glyphs, index %uB, bitmap %uB", path, (unsigned)header.glyph_number,
+                (unsigned)index_len, (unsigned)header.bitmap_size);
+        return lv_font;
+    }
+
+    void GlyphFont::PrintCacheInfo()
+    {
+        if(hit_count + miss_count == 0)return;
+        ESP_LOGI(TAG, "cache: %dKB/%dKB, hit %u avg %uus, miss %u avg %uus",
+                (int)(cache_bytes / 1024), (int)(cache_budget / 1024),
+                (unsigned)hit_count, (unsigned)((hit_count != 0) ? (hit_us / hit_count) : 0),
+                (unsigned)miss_count, (unsigned)((miss_count != 0) ? (miss_us / miss_count) : 0));
+    }
+
+    const GlyphFont::lvgf_glyph_t* GlyphFont::find_glyph(const glyph_font_t* font, uint32_t unicode)
+    {
+        int lo = 0, hi = (int)font->header.glyph_number - 1;
+        while(lo <= hi){
+            int mid = (lo + hi) / 2;
+            uint32_t code = font->glyphs[mid].unicode;
+            if(code == unicode)return &font->glyphs[mid];
+            if(code < unicode)lo = mid + 1;
+            else hi = mid - 1;
+        }
+        return NULL;
+    }
+
+    void GlyphFont::expand_bitmap(const uint8_t* in, uint8_t bpp, const lvgf_glyph_t* glyph, lv_draw_buf_t* draw_buf)
+    {
+        /*PLAIN格式的位图连续存放，展开成LVGL绘制需要的A8*/
+        uint8_t* out = draw_buf->data;
+        uint32_t stride = draw_buf->header.stride;
+        uint32_t bit = 0;
+        uint8_t mask = (uint8_t)((1 << bpp) - 1);
+        for(int y = 0; y < glyph->box_h; y++){
+            for(int x = 0; x < glyph->box_w; x++, bit += bpp){
+                if(bpp == 8){
+                    out[x] = in[bit >> 3];
+                    continue;
+                }
+                uint8_t v = (in[bit >> 3] >> (8 - bpp - (bit & 7))) & mask;
+                out[x] = (uint8_t)(v * 255 / mask);
+            }
+            out += stride;
+        }
+    }
+
+    void GlyphFont::unlink(int index)
+    {
+        glyph_cache_entry_t* entry = &entries[index];
+        int16_t* link = &buckets[bucket_of(entry->font, entry->unicode)];
+        while(*link != -1){
+            if(*link == index){
+                *link = entry->next;
+                break;
+            }
+            link = &entries[*link].next;
+        }
+        cache_bytes -= entry->length;
+        heap_caps_free(entry->bitmap);
+        memset(entry, 0, sizeof(glyph_cache_entry_t));
+    }
+
+    void GlyphFont::evict(size_t need)
+    {
+        /*位图拷贝到LVGL的绘制缓冲区后才释放锁，缓存项不会在使用中被淘汰*/
+        while(1){
+            int free_index = -1;
+            int victim = -1;
+            for(int i = 0; i < GLYPHFONT_CACHE_MAX; i++){
+                if(entries[i].font == NULL){
+                    free_index = i;
+                    continue;
+                }
+                if(victim == -1 || (int32_t)(entries[i].last_use - entries[victim].last_use) < 0)victim = i;
+            }
+            if(free_index != -1 && cache_bytes + need <= cache_budget)return;
+            if(victim == -1)return;
+            unlink(victim);
+        }
+    }
+
+    GlyphFont::glyph_cache_entry_t* GlyphFont::acquire(glyph_font_t* font, const lvgf_glyph_t* glyph, bool* hit)
+    {
+        uint32_t bucket = bucket_of(font, glyph->unicode);
+        for(int16_t i = buckets[bucket]; i != -1; i = entries[i].next){
+            if(entries[i].font == font && entries[i].unicode == glyph->unicode){
+                entries[i].last_use = ++use_clock;
+                *hit = true;
+                return &entries[i];
+            }
+        }
+
+        *hit = false;
+        evict(glyph->length);
+        int index = -1;
+        for(int i = 0; i < GLYPHFONT_CACHE_MAX; i++){
+            if(entries[i].font == NULL){
+                index = i;
+                break;
+            }
+        }
+        if(index == -1)return NULL;
+        uint8_t* bitmap = (uint8_t*)heap_caps_malloc(glyph->length, MALLOC_CAP_SPIRAM);
+        if(bitmap == NULL)return NULL;
+        if(fseek(font->file, font->header.bitmap_offset + glyph->offset, SEEK_SET) != 0 ||
+           fread(bitmap, 1, glyph->length, font->file) != glyph->length){
+            ESP_LOGE(TAG, "read U+%04X from %s fialed", (unsigned)glyph->unicode, font->path);
+            heap_caps_free(bitmap);
+            return NULL;
+        }
+        glyph_cache_entry_t* entry = &entries[index];
+        entry->font = font;
+        entry->unicode = glyph->unicode;
+        entry->bitmap = bitmap;
+        entry->length = glyph->length;
+        entry->last_use = ++use_clock;
+        entry->next = buckets[bucket];
+        buckets[bucket] = index;
+        cache_bytes += glyph->length;
+        return entry;
+    }
+
+    bool GlyphFont::font_get_glyph_dsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next)
+    {
+        /*与lv_font_fmt_txt一样，制表符按两个空格处理*/
+        bool is_tab = (letter == '\t');
+        if(is_tab)letter = ' ';
+        const glyph_font_t* gfont = (const glyph_font_t*)font->user_data;
+        const lvgf_glyph_t* glyph = find_glyph(gfont, letter);
+        if(glyph == NULL)return false;
+        uint32_t adv_w = glyph->adv_w;
+        if(is_tab)adv_w *= 2;
+        dsc->adv_w = (adv_w + (1 << 3)) >> 4;
+        dsc->box_w = is_tab ? glyph->box_w * 2 : glyph->box_w;
+        dsc->box_h = glyph->box_h;
+        dsc->ofs_x = glyph->ofs_x;
+        dsc->ofs_y = glyph->ofs_y;
+        dsc->format = (lv_font_glyph_format_t)gfont->header.bpp;
+        dsc->is_placeholder = false;
+        /*0保留给找不到的字形*/
+        dsc->gid.index = (uint32_t)(glyph - gfont->glyphs) + 1;
+        return true;
+    }
+
+    const void* GlyphFont::font_get_glyph_bitmap(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf)
+    {
+        /*只提供展开后的A8，原始位图在缓存中随时可能被淘汰*/
+        if(dsc->req_raw_bitmap || draw_buf == NULL || dsc->gid.index == 0)return NULL;
+        GlyphFont& app = getInstance();
+        glyph_font_t* gfont = (glyph_font_t*)dsc->resolved_font->user_data;
+        const lvgf_glyph_t* glyph = &gfont->glyphs[dsc->gid.index - 1];
+        if(glyph->length == 0)return NULL;
+
+        int64_t start_us = esp_timer_get_time();
+        bool hit = false;
+        xSemaphoreTake(app.mutex, portMAX_DELAY);
+        glyph_cache_entry_t* entry = app.acquire(gfont, glyph, &hit);
+        if(entry == NULL){
+            xSemaphoreGive(app.mutex);
+            return NULL;
+        }
+        expand_bitmap(entry->bitmap, gfont->header.bpp, glyph, draw_buf);
+        /*冷缓存的耗时包含从littlefs读取位图，热缓存只有展开*/
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start_us);
+        if(hit){
+            app.hit_count++;
+            app.hit_us += us;
+        }else{
+            app.miss_count++;
+            app.miss_us += us;
+        }
+        xSemaphoreGive(app.mutex);
+        lv_draw_buf_flush_cache(draw_buf, NULL);
+        return draw_buf;
+    }
+}
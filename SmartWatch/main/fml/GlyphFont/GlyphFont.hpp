@@ -0,0 +1,126 @@
+/**
+ * @file GlyphFont.hpp
+ * @author 李威延
+ * @brief 存放在littlefs中的LVGF字库：字形索引常驻PSRAM，字形位图绘制时按需读取并放入LRU缓存
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <esp_log.h>
+#include "esp_heap_caps.h"
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "lvgl.h"
+#include "lvgl_private.h"
+
+namespace fml{
+
+    class GlyphFont
+    {
+        #define GLYPHFONT_FONT_MAX                     (4)
+        #define GLYPHFONT_PATH_LEN                     (48)
+        #define GLYPHFONT_CACHE_MAX                    (128)           /*字形缓存的最大项数，字节上限由Init设置*/
+        #define GLYPHFONT_CACHE_BUCKETS                (64)            /*字形缓存哈希桶个数，必须是2的幂*/
+        #define LVGF_MAGIC                             "LVGF"
+        #define LVGF_VERSION                           (1)
+
+        /*LVGF文件格式，与process_lvgl_font/pack_lvgl_font.py一致，小端*/
+        struct lvgf_header_t{
+            char magic[4];
+            uint16_t version;
+            uint8_t bpp;
+            uint8_t flags;
+            int16_t line_height;
+            int16_t base_line;
+            int8_t underline_position;
+            int8_t underline_thickness;
+            uint16_t reserved;
+            uint32_t glyph_number;
+            uint32_t index_offset;
+            uint32_t bitmap_offset;
+            uint32_t bitmap_size;
+        };
+
+        struct lvgf_glyph_t{
+            uint32_t unicode;
+            uint32_t offset;                /*相对位图区开头的偏移*/
+            uint16_t adv_w;                 /*单位1/16像素*/
+            uint8_t box_w;
+            uint8_t box_h;
+            int8_t ofs_x;
+            int8_t ofs_y;
+            uint16_t length;
+        };
+
+        struct glyph_font_t{
+            lv_font_t font;
+            char path[GLYPHFONT_PATH_LEN];
+            FILE* file;                     /*保持打开，读取字形时不再查找文件*/
+            lvgf_header_t header;
+            lvgf_glyph_t* glyphs;           /*按unicode升序，二分查找*/
+        };
+
+        /*一个字形的原始位图，按(字库, unicode)挂在哈希桶上*/
+        struct glyph_cache_entry_t{
+            glyph_font_t* font;
+            uint32_t unicode;
+            uint8_t* bitmap;
+            uint16_t length;
+            int16_t next;
+            uint32_t last_use;
+        };
+
+        private:
+            const char* TAG = "GlyphFont";
+            SemaphoreHandle_t mutex;
+            glyph_font_t fonts[GLYPHFONT_FONT_MAX];
+            int font_number;
+            glyph_cache_entry_t entries[GLYPHFONT_CACHE_MAX];
+            int16_t buckets[GLYPHFONT_CACHE_BUCKETS];
+            size_t cache_bytes;
+            size_t cache_budget;
+            uint32_t use_clock;
+            uint32_t hit_count;
+            uint32_t miss_count;
+            uint64_t hit_us;
+            uint64_t miss_us;
+
+            /*私有构造函数，禁止外部直接实例化*/
+            GlyphFont();
+            ~GlyphFont();
+            /*禁止拷贝构造和赋值操作*/
+            GlyphFont(const GlyphFont&) = delete;
+            GlyphFont& operator = (const GlyphFont&) = delete;
+
+            static inline uint32_t bucket_of(const glyph_font_t* font, uint32_t unicode){
+                return (unicode ^ ((uint32_t)(uintptr_t)font >> 4)) & (GLYPHFONT_CACHE_BUCKETS - 1);
+            }
+            static const lvgf_glyph_t* find_glyph(const glyph_font_t* font, uint32_t unicode);
+            static void expand_bitmap(const uint8_t* in, uint8_t bpp, const lvgf_glyph_t* glyph, lv_draw_buf_t* draw_buf);
+            glyph_cache_entry_t* acquire(glyph_font_t* font, const lvgf_glyph_t* glyph, bool* hit);
+            void evict(size_t need);
+            void unlink(int index);
+
+            static bool font_get_glyph_dsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next);
+            static const void* font_get_glyph_bitmap(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf);
+
+        public:
+            /*获取单例实例的静态方法*/
+            inline static GlyphFont& getInstance() {
+                static GlyphFont instance;
+                return instance;
+            }
+
+            /*cache_bytes为字形缓存占用PSRAM的上限*/
+            void Init(size_t cache_bytes);
+            /*打开LVGF字库，同一路径只打开一次，失败返回NULL*/
+            const lv_font_t* LoadFont(const char* path);
+            void PrintCacheInfo();
+    };
+}
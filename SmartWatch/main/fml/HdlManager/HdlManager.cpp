@@ -60,11 +60,16 @@ namespace fml{
             HDLMANAGER_EVENTGROUP_NO_SLEEP_FOR_LVGL_BIT)) != 0) {
             /*任一事件位置位 → 不允许睡眠*/
             /*重置默认显示器的不活动计时器,模拟用户活动*/
+            lvgl_lock();
             lv_disp_trig_activity(NULL);
+            lvgl_unlock();
         } else {
             /*两个位均为0 → 允许睡眠*/
             /* Check lvgl inactive time */
-            if (lv_disp_get_inactive_time(NULL) > _PowerManager.AutoSleepTime){
+            lvgl_lock();
+            uint32_t inactive_time = lv_disp_get_inactive_time(NULL);
+            lvgl_unlock();
+            if (inactive_time > _PowerManager.AutoSleepTime){
                 _PowerManager.PowerMode = POWERMODE_SLEEPING;                                                           /*一定时间没操作屏幕，进入睡眠*/
             }else if(_KeyData.KeyUp == hdl::button::PRESSED){                                                           /*当按下KeyUp，准备进入睡眠*/
                 _PowerManager.PowerMode = POWERMODE_GOINGSLEEP;
@@ -108,11 +113,14 @@ namespace fml{
             /* Restart display */
             hdl::hdl::getInstance().DispWakeUp();            
 
+            /*休眠期间不持有LVGL锁，唤醒后才加锁*/
+            lvgl_lock();
             /* Reset lvgl inactive time */
             lv_disp_trig_activity(NULL);
 
             /* Refresh full screen */
             lv_obj_invalidate(lv_scr_act());
+            lvgl_unlock();
 
             /* Display on */
             int brightness_volume = get_brightness();
@@ -163,6 +171,9 @@ namespace fml{
         }else{
             set_brightness(DISP_DEFAULT_BRIGHTNESS_VOLUME);
         }
+
+        /*恢复佩戴手(显示方向)，NVS只在用户修改设置时写入*/
+        apply_left_handed(get_left_handed());
     }
 
     void HdlManager::update()
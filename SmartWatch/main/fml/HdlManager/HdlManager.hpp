@@ -91,6 +91,18 @@ namespace fml{
             inline void clear_no_sleep_for_nothing(){xEventGroupClearBits(xEventGroup, HDLMANAGER_EVENTGROUP_NO_SLEEP_FOR_NOTHING_BIT);}
             inline void set_no_sleep_for_lvgl(){xEventGroupSetBits(xEventGroup, HDLMANAGER_EVENTGROUP_NO_SLEEP_FOR_LVGL_BIT);}
             inline void clear_no_sleep_for_lvgl(){xEventGroupClearBits(xEventGroup, HDLMANAGER_EVENTGROUP_NO_SLEEP_FOR_LVGL_BIT);}
+            /*LVGL锁相关*/
+            inline static void lvgl_lock(){hdl::hdl::getInstance().LvglLock();}
+            inline static void lvgl_unlock(){hdl::hdl::getInstance().LvglUnlock();}
+            inline static lv_result_t lvgl_async_call(lv_async_cb_t async_xcb, void *user_data){return hdl::hdl::getInstance().LvglAsyncCall(async_xcb, user_data);}
+            inline static uint32_t lvgl_time_until_next(){return hdl::hdl::getInstance().LvglTimeUntilNext();}
+            inline static uint32_t lvgl_refr_period(){return hdl::hdl::getInstance().LvglRefrPeriod();}
+            inline static uint32_t lvgl_fps(){return hdl::hdl::getInstance().LvglFps();}
+            /*性能遥测相关*/
+            inline static void telemetry_app_begin(){hdl::hdl::getInstance().TelemetryAppBegin();}
+            inline static void telemetry_app_end(){hdl::hdl::getInstance().TelemetryAppEnd();}
+            inline static void telemetry_commit(){hdl::hdl::getInstance().TelemetryCommit();}
+            inline static void telemetry_print_summary(){hdl::hdl::getInstance().TelemetryPrintSummary();}
             /*电量相关*/
             inline uint8_t get_battery_level(){return _PowerInfos.BatteryLevel;}
             inline bool get_battery_is_charging(){return _PowerInfos.BatteryIsCharging;}
@@ -104,6 +116,18 @@ namespace fml{
             inline static int get_brightness(){
                 return hdl::hdl::getInstance().FlashGetInt("disp",true,"brightness",0);
             }
+            /*佩戴手：显示方向由面板硬件旋转，没有渲染开销。1:左手 2:右手，未设置时为左手*/
+            inline static void set_left_handed(bool left){
+                apply_left_handed(left);
+                hdl::hdl::getInstance().FlashSetInt("disp",true,"hand",left ? 1 : 2);
+            }
+            /*只切换方向不写NVS，启动时恢复保存的设置用*/
+            inline static void apply_left_handed(bool left){
+                hdl::hdl::getInstance().setLeftHanded(left);
+            }
+            inline static bool get_left_handed(){
+                return hdl::hdl::getInstance().FlashGetInt("disp",true,"hand",0) != 2;
+            }
             /*wifi相关*/
             inline static void start_wifi_configuration_ap(){
                 hdl::hdl::getInstance().StartWifiConfigurationAp();
@@ -0,0 +1,66 @@
+/**
+ * @file JpegCachePolicy.hpp
+ * @author 李威延
+ * @brief 帧缓存的淘汰策略：只根据帧和缓存项的状态选择要淘汰的帧，不分配也不加锁，主机测试(host_test/jpeg_cache)直接包含
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace fml{
+
+    namespace jpeg_cache_policy{
+
+        /**
+         * @brief 压缩帧缓存按最近最少使用选择淘汰的帧
+         *        没有读入、常驻、正在解码的帧不淘汰，keep_clock之后使用过的帧(当前帧和预读窗口)不淘汰
+         * @return 帧下标，没有可淘汰的帧时返回-1
+         */
+        inline int lru_victim(int number, uint8_t* const* buff, const uint8_t* pinned, const uint8_t* busy, const uint32_t* last_use, uint32_t keep_clock)
+        {
+            int lru = -1;
+            for(int i = 0; i < number; i++){
+                if(buff[i] == NULL || pinned[i] || busy[i])continue;
+                if(last_use[i] >= keep_clock)continue;
+                if(lru < 0 || last_use[i] < last_use[lru])lru = i;
+            }
+            return lru;
+        }
+
+        /*循环播放[start,end]时，最近播放的是last，还要几帧才会再用到jpeg_index；没有播放记录(last为0)时按一整圈*/
+        inline int loop_distance(int jpeg_index, int start, int end, int last)
+        {
+            int len = end - start + 1;
+            if(last == 0)return len;
+            int distance = (jpeg_index - last + len) % len;
+            return (distance == 0) ? len : distance;
+        }
+
+        /**
+         * @brief 解码结果缓存按离下一次使用最远选择淘汰项，循环动画比缓存长时LRU每一项都会在用到之前被淘汰
+         *        空闲、正在填充、正在读取的项不淘汰；只淘汰比新帧(distance)更晚才会用到的项
+         * @return 淘汰项，NULL表示新帧不值得缓存
+         */
+        template<class Entry, class Distance>
+        inline Entry* farthest_victim(Entry* entries, int number, int distance, Distance distance_of)
+        {
+            Entry* victim = NULL;
+            int victim_distance = distance;
+            for(int i = 0; i < number; i++){
+                Entry* entry = &entries[i];
+                if(entry->jpeg_index == 0 || entry->valid != true || entry->busy != 0)continue;
+                int d = distance_of(entry->jpeg_index);
+                if(d > victim_distance){
+                    victim = entry;
+                    victim_distance = d;
+                }
+            }
+            return victim;
+        }
+    }
+}
@@ -9,262 +9,1524 @@
  *
  */
 #include "JpegDecoder.hpp"
+#include "JpegMaterials.h"
 
 namespace fml{
 
-    long JpegDecoder::get_dir_number(const char *filepath)
+    struct JpegDecoder::jpeg_range_config_t JpegDecoder::get_range_config(int jpeg_index)
     {
-        /*存储文件个数*/
-        long FileNumber = 0;
-        /*先打开文件*/
-        DIR *dir = opendir(filepath);
-        /*判断是否打开成功*/
-        if (NULL == dir)				
-        {
-            perror("打开文件");
-            exit(1);
+        for(int i = 0; i < range_config_number; i++){
+            if(range_config[i].start <= jpeg_index && jpeg_index <= range_config[i].end)return range_config[i];
         }
-        /*dirent结构体指针，用于指向数据*/
-        struct dirent *di;		
-        /*用于拼接字符串。遇到子目录。*/		
-        char p_file[1024];				
+        /*未配置的帧按默认策略，预读只在整个素材目录内循环*/
+        struct jpeg_range_config_t config = {1, jpeg_input_info.jpeg_number, JPEGDECODER_LOAD_MODE_DEFAULT, JPEGDECODER_READ_AHEAD_DEFAULT};
+        return config;
+    }
 
-        while ((di = readdir(dir)) != NULL)
-        {
-            /*要忽略掉.和 .. 如果读到它们，就不要对他们操作。strcmp函数用于比较字符串，相等返回0；*/
-            if (strcmp(di->d_name, ".") == 0 || strcmp(di->d_name, "..") == 0)
-            {
-                /*忽略掉*/
+    bool JpegDecoder::load_frame(int i, bool pinned)
+    {
+        if(jpeg_input_info.jpeg_buff[i] != NULL)return true;
+        if(jpeg_input_info.jpeg_len[i] <= 0)return false;
+        if(pack_file == NULL && jpeg_input_info.jpeg_path[i] == NULL)return false;
+
+        uint8_t* buff = (uint8_t*)heap_caps_malloc(jpeg_input_info.jpeg_len[i], MALLOC_CAP_SPIRAM);
+        if(buff == NULL){
+            ESP_LOGE(TAG, "jpeg_input_info.jpeg_buff[%d] malloc buffer from PSRAM fialed", i);
+            return false;
+        }
+        size_t len = 0;
+        if(pack_file != NULL){
+            /*容器模式：定位到帧数据直接读取*/
+            if(fseek(pack_file, jpeg_input_info.jpeg_offset[i], SEEK_SET) == 0){
+                len = fread(buff, 1, jpeg_input_info.jpeg_len[i], pack_file);
+            }
+        }else{
+            FILE* f = fopen(jpeg_input_info.jpeg_path[i], "r");
+            if(f == NULL){
+                ESP_LOGE(TAG, "Failed to open file for reading");
+                heap_caps_free(buff);
+                return false;
+            }
+            len = fread(buff, 1, jpeg_input_info.jpeg_len[i], f);
+            fclose(f);
+        }
+        if(len != (size_t)jpeg_input_info.jpeg_len[i]){
+            ESP_LOGE(TAG, "read frame %d fialed", i + 1);
+            heap_caps_free(buff);
+            return false;
+        }
+
+        jpeg_input_info.jpeg_buff[i] = buff;
+        jpeg_input_info.jpeg_pinned[i] = pinned;
+        jpeg_input_info.jpeg_last_use[i] = ++jpeg_input_info.use_clock;
+        if(pinned)jpeg_input_info.pinned_bytes += len;
+        else jpeg_input_info.cache_bytes += len;
+        return true;
+    }
+
+    void JpegDecoder::evict_frame(int i)
+    {
+        if(jpeg_input_info.jpeg_buff[i] == NULL || jpeg_input_info.jpeg_pinned[i])return;
+        heap_caps_free(jpeg_input_info.jpeg_buff[i]);
+        jpeg_input_info.jpeg_buff[i] = NULL;
+        jpeg_input_info.cache_bytes -= jpeg_input_info.jpeg_len[i];
+    }
+
+    bool JpegDecoder::evict_for(size_t need, uint32_t keep_clock)
+    {
+        /*按最近最少使用淘汰，keep_clock之后使用过的帧不淘汰*/
+        while(jpeg_input_info.cache_bytes + need > JPEGDECODER_CACHE_BYTES){
+            int lru = jpeg_cache_policy::lru_victim(jpeg_input_info.jpeg_number, jpeg_input_info.jpeg_buff, jpeg_input_info.jpeg_pinned,
+                                                    jpeg_input_info.jpeg_busy, jpeg_input_info.jpeg_last_use, keep_clock);
+            if(lru < 0)return false;
+            evict_frame(lru);
+        }
+        return true;
+    }
+
+    uint8_t* JpegDecoder::acquire_frame(int i)
+    {
+        uint8_t* buff;
+        xSemaphoreTake(cache_mutex, portMAX_DELAY);
+        if(jpeg_input_info.jpeg_buff[i] != NULL){
+            jpeg_input_info.cache_hit++;
+            jpeg_input_info.jpeg_last_use[i] = ++jpeg_input_info.use_clock;
+        }else{
+            jpeg_input_info.cache_miss++;
+            /*正在解码的帧必须读入，缓存不够时淘汰所有其他空闲的帧*/
+            evict_for(jpeg_input_info.jpeg_len[i], UINT32_MAX);
+            load_frame(i, false);
+        }
+        buff = jpeg_input_info.jpeg_buff[i];
+        if(buff != NULL)jpeg_input_info.jpeg_busy[i]++;
+        xSemaphoreGive(cache_mutex);
+        return buff;
+    }
+
+    void JpegDecoder::release_frame(int i)
+    {
+        xSemaphoreTake(cache_mutex, portMAX_DELAY);
+        if(jpeg_input_info.jpeg_busy[i] > 0)jpeg_input_info.jpeg_busy[i]--;
+        xSemaphoreGive(cache_mutex);
+    }
+
+    void JpegDecoder::read_ahead(int jpeg_index)
+    {
+        struct jpeg_range_config_t config = get_range_config(jpeg_index);
+        if(config.mode != JPEG_LOAD_LAZY)return;
+        xSemaphoreTake(cache_mutex, portMAX_DELAY);
+        /*当前帧及预读窗口内的帧不互相淘汰*/
+        uint32_t keep_clock = jpeg_input_info.jpeg_last_use[jpeg_index - 1];
+        int index = jpeg_index;
+        for(int n = 0; n < config.read_ahead; n++){
+            index++;
+            if(index > config.end)index = config.start;
+            if(index == jpeg_index)break;
+            int i = index - 1;
+            if(jpeg_input_info.jpeg_buff[i] != NULL){
+                jpeg_input_info.jpeg_last_use[i] = ++jpeg_input_info.use_clock;
                 continue;
             }
-            else if (di->d_type == DT_DIR)
-            {
-                /*遇到目录就要进入，使用递归*/
-                sprintf(p_file, "%s / %s", filepath, di->d_name);
-                /*这里是+=*/
-                FileNumber += get_dir_number(p_file);
+            if(evict_for(jpeg_input_info.jpeg_len[i], keep_clock) != true)break;
+            if(load_frame(i, false) != true)break;
+        }
+        xSemaphoreGive(cache_mutex);
+    }
+
+    int JpegDecoder::get_range_slot(int jpeg_index)
+    {
+        for(int i = 0; i < range_config_number; i++){
+            if(range_config[i].start <= jpeg_index && jpeg_index <= range_config[i].end)return i;
+        }
+        return JPEGDECODER_RANGE_CONFIG_MAX;
+    }
+
+    void JpegDecoder::note_played(int jpeg_index)
+    {
+        range_last_index[get_range_slot(jpeg_index)] = jpeg_index;
+    }
+
+    int JpegDecoder::decoded_distance(int jpeg_index)
+    {
+        /*按所在素材段循环播放计算，离最近播放的帧还有几帧才会再用到*/
+        struct jpeg_range_config_t config = get_range_config(jpeg_index);
+        return jpeg_cache_policy::loop_distance(jpeg_index, config.start, config.end, range_last_index[get_range_slot(jpeg_index)]);
+    }
+
+    struct JpegDecoder::jpeg_decoded_entry_t* JpegDecoder::acquire_decoded(const struct jpeg_decoded_entry_t* key)
+    {
+        if(decoded_cache_budget == 0)return NULL;
+        struct jpeg_decoded_entry_t* found = NULL;
+        xSemaphoreTake(decoded_mutex, portMAX_DELAY);
+        for(int i = 0; i < JPEGDECODER_DECODED_CACHE_MAX; i++){
+            struct jpeg_decoded_entry_t* entry = &decoded_cache[i];
+            if(entry->valid != true || entry->jpeg_index != key->jpeg_index)continue;
+            if(entry->scale_width != key->scale_width || entry->scale_height != key->scale_height)continue;
+            if(entry->format != key->format || entry->rotate != key->rotate)continue;
+            entry->busy++;
+            found = entry;
+            break;
+        }
+        if(found != NULL)decoded_hit++;
+        else decoded_miss++;
+        xSemaphoreGive(decoded_mutex);
+        return found;
+    }
+
+    struct JpegDecoder::jpeg_decoded_entry_t* JpegDecoder::admit_decoded(const struct jpeg_decoded_entry_t* key, int len)
+    {
+        if(decoded_cache_budget == 0 || (size_t)len > decoded_cache_budget)return NULL;
+        struct jpeg_decoded_entry_t* slot = NULL;
+        xSemaphoreTake(decoded_mutex, portMAX_DELAY);
+        int distance = decoded_distance(key->jpeg_index);
+        while(1){
+            slot = NULL;
+            for(int i = 0; i < JPEGDECODER_DECODED_CACHE_MAX; i++){
+                struct jpeg_decoded_entry_t* entry = &decoded_cache[i];
+                if(entry->jpeg_index == 0){
+                    if(slot == NULL)slot = entry;
+                    continue;
+                }
+                /*已经缓存或者正在填充*/
+                if(entry->jpeg_index == key->jpeg_index && entry->scale_width == key->scale_width && entry->scale_height == key->scale_height &&
+                    entry->format == key->format && entry->rotate == key->rotate){
+                    xSemaphoreGive(decoded_mutex);
+                    return NULL;
+                }
             }
-            else
-            {
-                /*我这里是统计的所有文件，不管是什么类型的。可以自定义条件，统计不同类型的文件数目*/
-                FileNumber++;
+            if(slot != NULL && decoded_cache_bytes + len <= decoded_cache_budget)break;
+            /*淘汰离下一次使用最远的帧；新帧比它们都更晚才会用到时不缓存*/
+            struct jpeg_decoded_entry_t* victim = jpeg_cache_policy::farthest_victim(decoded_cache, JPEGDECODER_DECODED_CACHE_MAX, distance,
+                                                    [this](int jpeg_index){ return decoded_distance(jpeg_index); });
+            if(victim == NULL){
+                xSemaphoreGive(decoded_mutex);
+                return NULL;
             }
+            heap_caps_free(victim->buff);
+            decoded_cache_bytes -= victim->len;
+            memset(victim, 0, sizeof(struct jpeg_decoded_entry_t));
         }
+        uint8_t* buff = (uint8_t*)heap_caps_aligned_alloc(16, len, MALLOC_CAP_SPIRAM);
+        if(buff == NULL){
+            xSemaphoreGive(decoded_mutex);
+            return NULL;
+        }
+        *slot = *key;
+        slot->buff = buff;
+        slot->len = len;
+        slot->valid = false;
+        slot->busy = 1;
+        decoded_cache_bytes += len;
+        xSemaphoreGive(decoded_mutex);
+        return slot;
+    }
 
-        closedir(dir);
-        return FileNumber;
+    void JpegDecoder::release_decoded(struct jpeg_decoded_entry_t* entry, bool filled)
+    {
+        if(entry == NULL)return;
+        xSemaphoreTake(decoded_mutex, portMAX_DELAY);
+        entry->busy--;
+        if(entry->valid != true){
+            if(filled){
+                entry->valid = true;
+            }else{
+                /*填充没有完成，放弃这一项*/
+                heap_caps_free(entry->buff);
+                decoded_cache_bytes -= entry->len;
+                memset(entry, 0, sizeof(struct jpeg_decoded_entry_t));
+            }
+        }
+        xSemaphoreGive(decoded_mutex);
     }
-    /*函数用于获取目录下的第N个文件*/
-    bool JpegDecoder::get_nth_file(const char *path, int n, char* filename, int filename_len)
+
+    void JpegDecoder::SetDecodedCacheBytes(size_t bytes)
+    {
+        xSemaphoreTake(decoded_mutex, portMAX_DELAY);
+        decoded_cache_budget = bytes;
+        /*缩小上限时先释放空闲的项*/
+        for(int i = 0; i < JPEGDECODER_DECODED_CACHE_MAX && decoded_cache_bytes > decoded_cache_budget; i++){
+            struct jpeg_decoded_entry_t* entry = &decoded_cache[i];
+            if(entry->jpeg_index == 0 || entry->valid != true || entry->busy != 0)continue;
+            heap_caps_free(entry->buff);
+            decoded_cache_bytes -= entry->len;
+            memset(entry, 0, sizeof(struct jpeg_decoded_entry_t));
+        }
+        xSemaphoreGive(decoded_mutex);
+    }
+
+    bool JpegDecoder::get_jpeg_input_info(void* input_info_user_data, JpegDecoderInputInfoCallBack_t cb, const char *dirpath)
     {
-        DIR *dir;
-        struct dirent *entry;
-        int count = 0;
+        char filePath[512];
+        struct stat fileStat;
+        std::vector<std::string> filenames;
 
-        if(filename_len < 256){
+        /*一次扫描得到按序号排序的文件列表*/
+        if(jpeg_frame_index::scan_dir(dirpath, filenames) != true){
+            ESP_LOGE(TAG, "Failed to open directory %s", dirpath);
             return false;
         }
-    
-        if ((dir = opendir(path)) == NULL) {
-            perror("Failed to open directory");
+        int number = filenames.size();
+        if(number <= 0)return false;
+        /*分配帧索引，帧数据按加载策略读入*/
+        jpeg_input_info.jpeg_buff = (uint8_t**)heap_caps_calloc(number, sizeof(uint8_t*), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_len = (int*)heap_caps_calloc(number, sizeof(int), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_path = (char**)heap_caps_calloc(number, sizeof(char*), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_last_use = (uint32_t*)heap_caps_calloc(number, sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_pinned = (uint8_t*)heap_caps_calloc(number, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_busy = (uint8_t*)heap_caps_calloc(number, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
+        if(jpeg_input_info.jpeg_buff == NULL || jpeg_input_info.jpeg_len == NULL || jpeg_input_info.jpeg_path == NULL ||
+            jpeg_input_info.jpeg_last_use == NULL || jpeg_input_info.jpeg_pinned == NULL || jpeg_input_info.jpeg_busy == NULL){
+            ESP_LOGE(TAG, "jpeg_input_info malloc buffer from PSRAM fialed");
+            /*部分分配成功的也释放，索引复位成没有素材，不留下半初始化的状态*/
+            free_input_info();
             return false;
         }
-    
-        while ((entry = readdir(dir)) != NULL) {
-            /*跳过"."和".."目录*/
-            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-                continue;
+        jpeg_input_info.jpeg_number = number;
+
+        for(int i = 0; i < jpeg_input_info.jpeg_number; i++){
+            /*获取文件路径*/
+            snprintf(filePath, 512, "%s/%s", dirpath, filenames[i].c_str());
+            if (stat(filePath, &fileStat) == 0) {
+                jpeg_input_info.jpeg_len[i] = fileStat.st_size;
+                jpeg_input_info.jpeg_path[i] = (char*)heap_caps_malloc(strlen(filePath) + 1, MALLOC_CAP_SPIRAM);
+                if(jpeg_input_info.jpeg_path[i] != NULL)strcpy(jpeg_input_info.jpeg_path[i], filePath);
             }
-            count++;
-            if (count == n) {
-                strncpy(filename, entry->d_name, 256);
-                break;
+            if(cb != NULL)cb(input_info_user_data, jpeg_input_info.jpeg_number, i);
+        }
+        return true;
+    }
+
+    bool JpegDecoder::get_jpeg_pack_info(void* input_info_user_data, JpegDecoderInputInfoCallBack_t cb, const char *packpath)
+    {
+        struct jpak_header_t header;
+        struct jpak_frame_t* frames = NULL;
+        struct stat fileStat;
+        size_t pack_len;
+
+        pack_file = fopen(packpath, "r");
+        if(pack_file == NULL){
+            ESP_LOGE(TAG, "Failed to open %s", packpath);
+            return false;
+        }
+        if(fstat(fileno(pack_file), &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(header)){
+            ESP_LOGE(TAG, "%s is not a JPAK v1-v%d file", packpath, JPAK_VERSION);
+            goto fail;
+        }
+        pack_len = fileStat.st_size;
+        /*校验头部，表和帧的范围与get_jpeg_pack_map一样按文件大小检查，先比较再相减，不做可能回绕的加法*/
+        if(fread(&header, 1, sizeof(header), pack_file) != sizeof(header) ||
+            memcmp(header.magic, JPAK_MAGIC, sizeof(header.magic)) != 0 || header.version < 1 || header.version > JPAK_VERSION ||
+            header.frame_number == 0 || header.anim_table_offset > pack_len ||
+            header.anim_number > (pack_len - header.anim_table_offset) / sizeof(struct jpak_anim_t) ||
+            header.frame_table_offset > pack_len ||
+            header.frame_number > (pack_len - header.frame_table_offset) / sizeof(struct jpak_frame_t) ||
+            (header.version >= 3 && (header.key_table_offset > pack_len || header.frame_number > pack_len - header.key_table_offset))){
+            ESP_LOGE(TAG, "%s is not a JPAK v1-v%d file", packpath, JPAK_VERSION);
+            goto fail;
+        }
+        /*一次读入动画表和帧表*/
+        pack_anims = (struct jpak_anim_t*)heap_caps_malloc(header.anim_number * sizeof(struct jpak_anim_t) + 1, MALLOC_CAP_SPIRAM);
+        frames = (struct jpak_frame_t*)heap_caps_malloc(header.frame_number * sizeof(struct jpak_frame_t), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_buff = (uint8_t**)heap_caps_calloc(header.frame_number, sizeof(uint8_t*), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_len = (int*)heap_caps_calloc(header.frame_number, sizeof(int), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_offset = (uint32_t*)heap_caps_calloc(header.frame_number, sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_key = (uint8_t*)heap_caps_calloc(header.frame_number, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_last_use = (uint32_t*)heap_caps_calloc(header.frame_number, sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_pinned = (uint8_t*)heap_caps_calloc(header.frame_number, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_busy = (uint8_t*)heap_caps_calloc(header.frame_number, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
+        if(pack_anims == NULL || frames == NULL || jpeg_input_info.jpeg_buff == NULL || jpeg_input_info.jpeg_len == NULL ||
+            jpeg_input_info.jpeg_offset == NULL || jpeg_input_info.jpeg_key == NULL || jpeg_input_info.jpeg_last_use == NULL ||
+            jpeg_input_info.jpeg_pinned == NULL || jpeg_input_info.jpeg_busy == NULL){
+            ESP_LOGE(TAG, "jpeg_input_info malloc buffer from PSRAM fialed");
+            goto fail;
+        }
+        /*v3的关键帧表一起读入；更早的容器没有，关键帧表全为0，差分动画只能从动画第一帧开始叠加*/
+        if(fseek(pack_file, header.anim_table_offset, SEEK_SET) != 0 ||
+            fread(pack_anims, sizeof(struct jpak_anim_t), header.anim_number, pack_file) != header.anim_number ||
+            fseek(pack_file, header.frame_table_offset, SEEK_SET) != 0 ||
+            fread(frames, sizeof(struct jpak_frame_t), header.frame_number, pack_file) != header.frame_number ||
+            (header.version >= 3 && (fseek(pack_file, header.key_table_offset, SEEK_SET) != 0 ||
+            fread(jpeg_input_info.jpeg_key, 1, header.frame_number, pack_file) != header.frame_number))){
+            ESP_LOGE(TAG, "read %s tables fialed", packpath);
+            goto fail;
+        }
+        pack_anim_number = header.anim_number;
+        pack_known = is_known_pack(&header);
+        jpeg_input_info.jpeg_number = header.frame_number;
+        for(int i = 0; i < jpeg_input_info.jpeg_number; i++){
+            if(frames[i].offset > pack_len || frames[i].length > pack_len - frames[i].offset){
+                ESP_LOGE(TAG, "frame %d out of pack", i + 1);
+                goto fail;
             }
+            jpeg_input_info.jpeg_offset[i] = frames[i].offset;
+            jpeg_input_info.jpeg_len[i] = frames[i].length;
         }
-        closedir(dir);
-        if (count < n) {
-            /*如果目录中的文件少于n个，返回NULL*/
+        heap_caps_free(frames);
+        if(cb != NULL)cb(input_info_user_data, jpeg_input_info.jpeg_number, jpeg_input_info.jpeg_number - 1);
+        return true;
+
+    fail:
+        if(frames != NULL)heap_caps_free(frames);
+        free_input_info();
+        fclose(pack_file);
+        pack_file = NULL;
+        return false;
+    }
+
+    bool JpegDecoder::get_jpeg_pack_map(void* input_info_user_data, JpegDecoderInputInfoCallBack_t cb, const uint8_t* pack, size_t pack_len)
+    {
+        struct jpak_header_t header;
+        const struct jpak_frame_t* frames;
+
+        /*校验头部，映射的内存可能没有对齐，表项用memcpy取出；偏移来自容器，先比较再相减，不做可能回绕的加法*/
+        if(pack == NULL || pack_len < sizeof(header))goto fail;
+        memcpy(&header, pack, sizeof(header));
+        if(memcmp(header.magic, JPAK_MAGIC, sizeof(header.magic)) != 0 || header.version < 1 || header.version > JPAK_VERSION ||
+            header.frame_number == 0 || header.anim_table_offset > pack_len ||
+            header.anim_number > (pack_len - header.anim_table_offset) / sizeof(struct jpak_anim_t) ||
+            header.frame_table_offset > pack_len ||
+            header.frame_number > (pack_len - header.frame_table_offset) / sizeof(struct jpak_frame_t) ||
+            (header.version >= 3 && (header.key_table_offset > pack_len || header.frame_number > pack_len - header.key_table_offset))){
+            goto fail;
+        }
+        /*只有动画表和索引数组放在PSRAM，帧数据留在映射的内存中*/
+        pack_anims = (struct jpak_anim_t*)heap_caps_malloc(header.anim_number * sizeof(struct jpak_anim_t) + 1, MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_buff = (uint8_t**)heap_caps_calloc(header.frame_number, sizeof(uint8_t*), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_len = (int*)heap_caps_calloc(header.frame_number, sizeof(int), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_offset = (uint32_t*)heap_caps_calloc(header.frame_number, sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_key = (uint8_t*)heap_caps_calloc(header.frame_number, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_last_use = (uint32_t*)heap_caps_calloc(header.frame_number, sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_pinned = (uint8_t*)heap_caps_calloc(header.frame_number, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
+        jpeg_input_info.jpeg_busy = (uint8_t*)heap_caps_calloc(header.frame_number, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
+        if(pack_anims == NULL || jpeg_input_info.jpeg_buff == NULL || jpeg_input_info.jpeg_len == NULL ||
+            jpeg_input_info.jpeg_offset == NULL || jpeg_input_info.jpeg_key == NULL || jpeg_input_info.jpeg_last_use == NULL ||
+            jpeg_input_info.jpeg_pinned == NULL || jpeg_input_info.jpeg_busy == NULL){
+            ESP_LOGE(TAG, "jpeg_input_info malloc buffer from PSRAM fialed");
+            free_input_info();
             return false;
         }
+        memcpy(pack_anims, pack + header.anim_table_offset, header.anim_number * sizeof(struct jpak_anim_t));
+        frames = (const struct jpak_frame_t*)(pack + header.frame_table_offset);
+        pack_map = pack;
+        for(int i = 0; i < (int)header.frame_number; i++){
+            struct jpak_frame_t frame;
+            memcpy(&frame, &frames[i], sizeof(frame));
+            if(frame.offset > pack_len || frame.length > pack_len - frame.offset){
+                ESP_LOGE(TAG, "frame %d out of pack", i + 1);
+                free_input_info();
+                return false;
+            }
+            /*映射的帧按常驻处理，load_frame直接命中，evict_frame不会释放*/
+            jpeg_input_info.jpeg_offset[i] = frame.offset;
+            jpeg_input_info.jpeg_len[i] = frame.length;
+            jpeg_input_info.jpeg_buff[i] = (uint8_t*)(pack + frame.offset);
+            jpeg_input_info.jpeg_pinned[i] = 1;
+            /*v3之前的容器没有关键帧表，帧数据就在内存中，直接看是不是以SOI开头*/
+            if(header.version >= 3)jpeg_input_info.jpeg_key[i] = pack[header.key_table_offset + i];
+            else jpeg_input_info.jpeg_key[i] = (frame.length >= 2 && pack[frame.offset] == 0xFF && pack[frame.offset + 1] == 0xD8);
+        }
+        pack_anim_number = header.anim_number;
+        pack_known = is_known_pack(&header);
+        jpeg_input_info.jpeg_number = header.frame_number;
+        if(cb != NULL)cb(input_info_user_data, jpeg_input_info.jpeg_number, jpeg_input_info.jpeg_number - 1);
         return true;
+
+    fail:
+        ESP_LOGE(TAG, "mapped pack is not a JPAK v1-v%d file", JPAK_VERSION);
+        return false;
     }
 
-    void JpegDecoder::get_jpeg_input_info(void* input_info_user_data, JpegDecoderInputInfoCallBack_t cb, const char* TAG, const char *dirpath, struct jpeg_input_info_t* jpeg_input_info)
+    bool JpegDecoder::is_known_pack(const struct jpak_header_t* header)
     {
-        char filePath[512];
-        char filename[256];
-        struct stat fileStat;
-        FILE *f = NULL;
-
-        /*获取文件总数*/
-        jpeg_input_info->jpeg_number = get_dir_number(dirpath);
-        /*获取各个文件的信息*/
-        if(jpeg_input_info->jpeg_number != 0){
-            jpeg_input_info->jpeg_buff = (uint8_t**)heap_caps_malloc(jpeg_input_info->jpeg_number * sizeof(uint8_t*), MALLOC_CAP_SPIRAM);
-            if(jpeg_input_info->jpeg_buff != NULL){
-                /*分配用于存储各个文件大小信息的缓存*/
-                jpeg_input_info->jpeg_len = (int*)heap_caps_malloc(jpeg_input_info->jpeg_number * sizeof(int), MALLOC_CAP_SPIRAM);
-                if(jpeg_input_info->jpeg_len == NULL){
-                    heap_caps_free(jpeg_input_info->jpeg_buff);
-                    jpeg_input_info->jpeg_number = 0;
-                    return;
-                }else{
-                    for(int i = 0; i < jpeg_input_info->jpeg_number; i++){
-                        /*获取文件路径*/
-                        if(get_nth_file(dirpath, i + 1, filename, 256) != true){
-                            memset(filename, 0, sizeof(filename));
-                        }
-                        snprintf(filePath, 512, "%s/%s", dirpath, filename);
-                        if (stat(filePath, &fileStat) == 0) {
-                            /*获取jpeg文件缓存空间和jpeg文件大小*/
-                            jpeg_input_info->jpeg_buff[i] = (uint8_t*)heap_caps_malloc(fileStat.st_size, MALLOC_CAP_SPIRAM);
-                            jpeg_input_info->jpeg_len[i] = fileStat.st_size;
-                            /*读取文件*/
-                            f = fopen(filePath, "r");
-                            if(f == NULL){
-                                ESP_LOGE(TAG, "Failed to open file for reading");
-                                if(jpeg_input_info->jpeg_buff[i] != NULL)heap_caps_free(jpeg_input_info->jpeg_buff[i]);
-                                jpeg_input_info->jpeg_len[i] = 0;
-                            }else{
-                                fread(jpeg_input_info->jpeg_buff[i], 1, jpeg_input_info->jpeg_len[i], f);
-                                fclose(f);
-                                f = NULL;
-                            }
-                        } else {
-                            jpeg_input_info->jpeg_buff[i] = NULL;
-                            jpeg_input_info->jpeg_len[i] = 0;
-                        }
-                        if(cb != NULL)cb(input_info_user_data, jpeg_input_info->jpeg_number, i);
-                        //ESP_LOGI(TAG, "get_jpeg_input_info:%d,%p,%d",i,(void*)jpeg_input_info->jpeg_buff[i], jpeg_input_info->jpeg_len[i]);
-                        vTaskDelay(pdMS_TO_TICKS(10));
-                    }
+        /*v1容器没有pack_id*/
+        return header->version >= 2 && header->pack_id == JPEG_MATERIALS_PACK_ID && header->frame_number == JPEG_MATERIALS_FRAME_NUMBER;
+    }
+
+    void JpegDecoder::free_input_info()
+    {
+        if(jpeg_input_info.jpeg_buff != NULL){
+            /*映射模式的帧不属于堆*/
+            for(int i = 0; i < jpeg_input_info.jpeg_number && pack_map == NULL; i++){
+                if(jpeg_input_info.jpeg_buff[i] != NULL){
+                    heap_caps_free(jpeg_input_info.jpeg_buff[i]);
                 }
             }
+            heap_caps_free(jpeg_input_info.jpeg_buff);
         }
+        if(jpeg_input_info.jpeg_path != NULL){
+            for(int i = 0; i < jpeg_input_info.jpeg_number; i++){
+                if(jpeg_input_info.jpeg_path[i] != NULL)heap_caps_free(jpeg_input_info.jpeg_path[i]);
+            }
+            heap_caps_free(jpeg_input_info.jpeg_path);
+        }
+        if(jpeg_input_info.jpeg_len != NULL)heap_caps_free(jpeg_input_info.jpeg_len);
+        if(jpeg_input_info.jpeg_offset != NULL)heap_caps_free(jpeg_input_info.jpeg_offset);
+        if(jpeg_input_info.jpeg_key != NULL)heap_caps_free(jpeg_input_info.jpeg_key);
+        if(jpeg_input_info.jpeg_last_use != NULL)heap_caps_free(jpeg_input_info.jpeg_last_use);
+        if(jpeg_input_info.jpeg_pinned != NULL)heap_caps_free(jpeg_input_info.jpeg_pinned);
+        if(jpeg_input_info.jpeg_busy != NULL)heap_caps_free(jpeg_input_info.jpeg_busy);
+        if(pack_anims != NULL)heap_caps_free(pack_anims);
+        memset(&jpeg_input_info, 0, sizeof(jpeg_input_info));
+        pack_anims = NULL;
+        pack_anim_number = 0;
+        pack_known = false;
+        pack_map = NULL;
+    }
+
+    JpegDecoder::jpeg_dec_err_t JpegDecoder::decode_with(jpeg_dec_handle_t* jpeg_dec, jpeg_dec_config_t* handle_config, const jpeg_dec_config_t* config,
+            const uint8_t* src, size_t src_len, uint8_t** dst, int* dst_len, uint16_t* out_width, uint16_t* out_height, int* out_len)
+    {
+        if(src == NULL || src_len < 2 || src[0] != 0xFF || src[1] != 0xD8)return JPEG_DEC_ERR_SIGNATURE;
+        /*配置变化时才重新创建解码句柄*/
+        if(*jpeg_dec == NULL || handle_config->output_type != config->output_type || handle_config->rotate != config->rotate ||
+            handle_config->scale.width != config->scale.width || handle_config->scale.height != config->scale.height){
+            if(*jpeg_dec != NULL){
+                jpeg_dec_close(*jpeg_dec);
+                *jpeg_dec = NULL;
+            }
+            *handle_config = *config;
+            if(jpeg_dec_open(handle_config, jpeg_dec) != JPEG_ERR_OK){
+                *jpeg_dec = NULL;
+                return JPEG_DEC_ERR_OPEN;
+            }
+        }
+
+        jpeg_dec_io_t io = {};
+        jpeg_dec_header_info_t info;
+        int outbuf_len = 0;
+        io.inbuf = (uint8_t*)src;
+        io.inbuf_len = src_len;
+        /*Parse jpeg picture header and get picture for user and decoder*/
+        if(jpeg_dec_parse_header(*jpeg_dec, &io, &info) != JPEG_ERR_OK)return JPEG_DEC_ERR_HEADER;
+        if(jpeg_dec_get_outbuf_len(*jpeg_dec, &outbuf_len) != JPEG_ERR_OK || outbuf_len <= 0)return JPEG_DEC_ERR_HEADER;
+        bool own_dst = false;
+        if(*dst == NULL){
+            *dst = (uint8_t*)heap_caps_aligned_alloc(16, outbuf_len, MALLOC_CAP_SPIRAM);
+            if(*dst == NULL)return JPEG_DEC_ERR_NO_MEM;
+            *dst_len = outbuf_len;
+            own_dst = true;
+        }else if(*dst_len < outbuf_len){
+            return JPEG_DEC_ERR_BUFFER_SMALL;
+        }else if(((uintptr_t)*dst & 0xF) != 0){
+            return JPEG_DEC_ERR_BUFFER_ALIGN;
+        }
+        io.outbuf = *dst;
+        /*Start decode jpeg*/
+        if(jpeg_dec_process(*jpeg_dec, &io) != JPEG_ERR_OK){
+            if(own_dst == true){
+                heap_caps_free(*dst);
+                *dst = NULL;
+                *dst_len = 0;
+            }
+            return JPEG_DEC_ERR_PROCESS;
+        }
+        if(out_width != NULL)*out_width = (handle_config->scale.width > 0) ? handle_config->scale.width : info.width;
+        if(out_height != NULL)*out_height = (handle_config->scale.height > 0) ? handle_config->scale.height : info.height;
+        if(out_len != NULL)*out_len = outbuf_len;
+        return JPEG_DEC_OK;
+    }
+
+    bool JpegDecoder::decode(struct jpeg_worker_t* worker, struct jpeg_dec_request_t* req)
+    {
+        const uint8_t* src = req->src;
+        int src_len = req->src_len;
+        bool success = false;
+        struct jpeg_decoded_entry_t key = {};
+
+        /*调用者提供输出缓冲区的内存JPEG(如聊天图像)走Decode的句柄缓存，不分配内存，也不会让工作任务按壁纸配置的句柄反复重建*/
+        if(req->jpeg_index == 0 && req->dst != NULL){
+            jpeg_dec_err_t err = Decode(src, src_len, req->dst, req->dst_len, &req->out_width, &req->out_height,
+                                        req->width, req->height, req->format, req->rotate);
+            if(err != JPEG_DEC_OK){
+                ESP_LOGE(TAG, "decode failed:%s", DecodeErrorName(err));
+                return false;
+            }
+            return true;
+        }
+
+        /*素材帧从压缩帧缓存中取，解码期间不会被淘汰*/
+        if(req->jpeg_index != 0){
+            if(req->jpeg_index < 1 || req->jpeg_index > jpeg_input_info.jpeg_number){
+                ESP_LOGE(TAG, "jpeg index %d out of range", req->jpeg_index);
+                return false;
+            }
+            note_played(req->jpeg_index);
+            /*解码结果缓存命中时直接拷贝，不解码*/
+            key.jpeg_index = req->jpeg_index;
+            key.scale_width = req->width & ~(JPEGDECODER_SCALE_ALIGN - 1);
+            key.scale_height = req->height & ~(JPEGDECODER_SCALE_ALIGN - 1);
+            key.format = req->format;
+            key.rotate = req->rotate;
+            struct jpeg_decoded_entry_t* entry = acquire_decoded(&key);
+            if(entry != NULL){
+                if(req->dst == NULL){
+                    req->dst = (uint8_t*)heap_caps_aligned_alloc(16, entry->len, MALLOC_CAP_SPIRAM);
+                    req->dst_len = (req->dst != NULL) ? entry->len : 0;
+                }
+                if(req->dst != NULL && req->dst_len >= entry->len){
+                    memcpy(req->dst, entry->buff, entry->len);
+                    req->out_width = entry->out_width;
+                    req->out_height = entry->out_height;
+                    success = true;
+                }
+                release_decoded(entry, true);
+                return success;
+            }
+            src = acquire_frame(req->jpeg_index - 1);
+            src_len = jpeg_input_info.jpeg_len[req->jpeg_index - 1];
+            if(src == NULL){
+                ESP_LOGE(TAG, "jpeg_input_info.jpeg_buff[%d] malloc buffer from PSRAM fialed", req->jpeg_index - 1);
+                return false;
+            }
+        }
+        {
+            jpeg_dec_config_t config = DEFAULT_JPEG_DEC_CONFIG();
+            config.output_type = req->format;
+            config.rotate = req->rotate;
+            config.scale.width = req->width & ~(JPEGDECODER_SCALE_ALIGN - 1);     /*确保是8的倍数*/
+            config.scale.height = req->height & ~(JPEGDECODER_SCALE_ALIGN - 1);
+            int outbuf_len = 0;
+            jpeg_dec_err_t err = decode_with(&worker->jpeg_dec, &worker->config, &config, src, src_len,
+                                             &req->dst, &req->dst_len, &req->out_width, &req->out_height, &outbuf_len);
+            if(err != JPEG_DEC_OK){
+                ESP_LOGE(TAG, "decode failed:%s", DecodeErrorName(err));
+                goto exit;
+            }
+            success = true;
+            /*素材帧的解码结果放入缓存，是否保留由淘汰策略决定*/
+            if(req->jpeg_index != 0){
+                struct jpeg_decoded_entry_t* entry = admit_decoded(&key, outbuf_len);
+                if(entry != NULL){
+                    memcpy(entry->buff, req->dst, outbuf_len);
+                    entry->out_width = req->out_width;
+                    entry->out_height = req->out_height;
+                    release_decoded(entry, true);
+                }
+            }
+        }
+
+    exit:
+        if(req->jpeg_index != 0)release_frame(req->jpeg_index - 1);
+        return success;
     }
 
     void JpegDecoder::JpegDecTask(void * arg)
     {
-        int ret;
-        JpegDecoder* app = (JpegDecoder*)arg;
-        //int start, end, duration_us;
+        struct jpeg_worker_t* worker = (struct jpeg_worker_t*)arg;
+        JpegDecoder* app = worker->app;
+        struct jpeg_dec_request_t req;
         while(1)
         {
-            xEventGroupWaitBits(app->xEventGroup,EVENTGROUP_JPEG_DEC_START_BIT,pdTRUE,pdTRUE,portMAX_DELAY);
-            //start = esp_timer_get_time();
-            if(app->jpeg_input_info.jpeg_index <= app->jpeg_input_info.jpeg_number){
-                if(app->jpeg_input_info.jpeg_buff != NULL){
-                    if(app->jpeg_input_info.jpeg_buff[app->jpeg_input_info.jpeg_index - 1] != NULL){
-                        /*Set input buffer and buffer len to io_callback*/
-                        app->jpeg_stream.jpeg_io.inbuf = app->jpeg_input_info.jpeg_buff[app->jpeg_input_info.jpeg_index - 1];
-                        app->jpeg_stream.jpeg_io.inbuf_len = app->jpeg_input_info.jpeg_len[app->jpeg_input_info.jpeg_index - 1];
-                        if(app->jpeg_output_info.jpeg_buff != NULL){
-                            /*Parse jpeg picture header and get picture for user and decoder*/
-                            ret = jpeg_dec_parse_header(app->jpeg_stream.jpeg_dec, &app->jpeg_stream.jpeg_io, &app->jpeg_stream.out_info);
-                            if (ret != JPEG_ERR_OK) {
-                                ESP_LOGE(app->TAG, "jpeg_dec_parse_header failed:%d", ret);
-                            }else{
-                                /*Start decode jpeg*/
-                                ret = jpeg_dec_process(app->jpeg_stream.jpeg_dec, &app->jpeg_stream.jpeg_io);
-                                if (ret != JPEG_ERR_OK) {
-                                    ESP_LOGE(app->TAG, "jpeg_dec_process failed:%d", ret);
-                                }else{
-                                    //ESP_LOGI(app->TAG, "jpeg_dec_process success");
-                                }
-                            }
-                        }else{
-                            ESP_LOGE(app->TAG, "jpeg_output_info.jpeg_buff malloc buffer from PSRAM fialed");
-                        }
-                    }else{
-                        ESP_LOGE(app->TAG, "app->jpeg_input_info.jpeg_buff[%d] malloc buffer from PSRAM fialed", app->jpeg_input_info.jpeg_index - 1);
-                    }
-                }else{
-                    ESP_LOGE(app->TAG, "app->jpeg_input_info.jpeg_buff malloc buffer from PSRAM fialed");
+            xQueueReceive(app->jpeg_queue, &req, portMAX_DELAY);
+            if(req.prefetch == true){
+                /*只读入压缩帧，解码在别处进行*/
+                bool success = false;
+                if(req.jpeg_index > 0 && req.jpeg_index <= app->jpeg_input_info.jpeg_number){
+                    success = (app->acquire_frame(req.jpeg_index - 1) != NULL);
+                    if(success)app->release_frame(req.jpeg_index - 1);
+                    app->read_ahead(req.jpeg_index);
                 }
+                if(req.cb != NULL)req.cb(&req, success);
+                continue;
+            }
+            int64_t start_us = esp_timer_get_time();
+            bool success = app->decode(worker, &req);
+            worker->dec_us += esp_timer_get_time() - start_us;
+            worker->dec_count++;
+            if(req.cb != NULL)req.cb(&req, success);
+            /*结果交出后再预读后续帧，不占用解码延迟*/
+            if(req.jpeg_index > 0 && req.jpeg_index <= app->jpeg_input_info.jpeg_number){
+                app->read_ahead(req.jpeg_index);
             }
-            //end = esp_timer_get_time();
-            //duration_us = end - start;
-            //ESP_LOGI(app->TAG, "JpegDecTask hs:%d,%.3f", duration_us, (float)duration_us / 1000);
-            //vTaskDelay(pdMS_TO_TICKS(LV_DEF_REFR_PERIOD));
-            xEventGroupSetBits(app->xEventGroup, EVENTGROUP_JPEG_DEC_END_BIT);
         }
     }
 
     JpegDecoder::JpegDecoder()
     {       
-        xEventGroup = NULL;
+        jpeg_queue = NULL;
+        cache_mutex = NULL;
+        memset(jpeg_workers, 0, sizeof(jpeg_workers));
         memset(&jpeg_input_info, 0, sizeof(jpeg_input_info));
-        memset(&jpeg_stream, 0, sizeof(jpeg_stream));
-        JpegDecTask_handle = NULL;
+        default_format = JPEG_PIXEL_FORMAT_RGB565_LE;
+        default_rotate = JPEG_ROTATE_0D;
+        memset(range_config, 0, sizeof(range_config));
+        range_config_number = 0;
+        pack_file = NULL;
+        pack_map = NULL;
+        pack_known = false;
+        pack_anims = NULL;
+        pack_anim_number = 0;
+        stripe_decoder = NULL;
+        stripe_block_count = 0;
+        stripe_block_us = 0;
+        stripe_restart_count = 0;
+        delta_frame_count = 0;
+        delta_key_count = 0;
+        delta_lag_count = 0;
+        delta_us = 0;
+        delta_px = 0;
+        memset(anim_players, 0, sizeof(anim_players));
+        decoded_mutex = NULL;
+        memset(decoded_cache, 0, sizeof(decoded_cache));
+        decoded_cache_budget = 0;
+        decoded_cache_bytes = 0;
+        decoded_hit = 0;
+        decoded_miss = 0;
+        memset(range_last_index, 0, sizeof(range_last_index));
+        decode_mutex = xSemaphoreCreateMutex();
+        memset(decode_handles, 0, sizeof(decode_handles));
+        decode_clock = 0;
         ESP_LOGI(TAG, "JpegDecoder on construct");
     }
 
     JpegDecoder::~JpegDecoder()
     {
-        if(xEventGroup != NULL)vEventGroupDelete(xEventGroup);
-
-        if(jpeg_input_info.jpeg_buff != NULL){
-            for(int i = 0; i < jpeg_input_info.jpeg_number; i++){
-                if(jpeg_input_info.jpeg_buff[i] != NULL){
-                    heap_caps_free(jpeg_input_info.jpeg_buff[i]);
-                }
-            }
-            heap_caps_free(jpeg_input_info.jpeg_buff);
+        for(int i = 0; i < JPEGDECODER_WORKER_NUM; i++){
+            if(jpeg_workers[i].handle != NULL)vTaskDelete(jpeg_workers[i].handle);
+            if(jpeg_workers[i].jpeg_dec != NULL)jpeg_dec_close(jpeg_workers[i].jpeg_dec);
         }
-        if(jpeg_input_info.jpeg_len != NULL)heap_caps_free(jpeg_input_info.jpeg_len);
-        
-        if(jpeg_stream.jpeg_dec != NULL)jpeg_dec_close(jpeg_stream.jpeg_dec);
-        if(JpegDecTask_handle != NULL)vTaskDelete(JpegDecTask_handle);
+        if(jpeg_queue != NULL)vQueueDelete(jpeg_queue);
+        if(cache_mutex != NULL)vSemaphoreDelete(cache_mutex);
+        for(int i = 0; i < JPEGDECODER_DECODED_CACHE_MAX; i++){
+            if(decoded_cache[i].buff != NULL)heap_caps_free(decoded_cache[i].buff);
+        }
+        if(decoded_mutex != NULL)vSemaphoreDelete(decoded_mutex);
+        for(int i = 0; i < JPEGDECODER_DECODE_HANDLE_MAX; i++){
+            if(decode_handles[i].jpeg_dec != NULL)jpeg_dec_close(decode_handles[i].jpeg_dec);
+        }
+        if(decode_mutex != NULL)vSemaphoreDelete(decode_mutex);
+
+        free_input_info();
+        if(pack_file != NULL)fclose(pack_file);
 
         ESP_LOGI(TAG, "JpegDecoder on deconstruct");
     }
 
-    void JpegDecoder::Init(const char* dirpath, jpeg_pixel_format_t format, jpeg_rotate_t rotate, JpegDecoderInputInfoCallBack_t cb, void* input_info_user_data)
+    bool JpegDecoder::Init(const char* path, jpeg_pixel_format_t format, jpeg_rotate_t rotate, JpegDecoderInputInfoCallBack_t cb, void* input_info_user_data)
+    {
+        /*获取jpeg输入缓存信息*/
+        int64_t start_us = esp_timer_get_time();
+        size_t psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+        /*path为文件时按JPAK容器打开，为目录时逐个文件建立索引*/
+        bool ret;
+        struct stat pathStat;
+        if(stat(path, &pathStat) == 0 && S_ISREG(pathStat.st_mode)){
+            ret = get_jpeg_pack_info(input_info_user_data, cb, path);
+        }else{
+            ret = get_jpeg_input_info(input_info_user_data, cb, path);
+        }
+        /*没有素材时也启动解码任务，内存中的JPEG(如聊天图片)仍然可以解码*/
+        start(format, rotate, start_us, psram_free);
+        return ret;
+    }
+
+    bool JpegDecoder::Init(const uint8_t* pack, size_t pack_len, jpeg_pixel_format_t format, jpeg_rotate_t rotate, JpegDecoderInputInfoCallBack_t cb, void* input_info_user_data)
+    {
+        int64_t start_us = esp_timer_get_time();
+        size_t psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+        /*失败时状态已经复位，不启动解码任务，调用者可以改用文件再Init一次*/
+        if(get_jpeg_pack_map(input_info_user_data, cb, pack, pack_len) != true)return false;
+        start(format, rotate, start_us, psram_free);
+        return true;
+    }
+
+    void JpegDecoder::start(jpeg_pixel_format_t format, jpeg_rotate_t rotate, int64_t start_us, size_t psram_free)
     {
-        /*创建事件组*/
-        xEventGroup = xEventGroupCreate();
-        /*获取jpeg输入缓存信息，默认第一个文件开始*/
-        jpeg_input_info.jpeg_index = 1;
-        get_jpeg_input_info(input_info_user_data, cb, TAG, dirpath, &jpeg_input_info);
+        ESP_LOGI(TAG, "index %d frames (%s%s) in %dms, PSRAM used %dKB",
+                jpeg_input_info.jpeg_number, (pack_map != NULL) ? "map" : ((pack_file != NULL) ? "pack" : "dir"), pack_known ? ", known" : "",
+                (int)((esp_timer_get_time() - start_us) / 1000), (int)((psram_free - heap_caps_get_free_size(MALLOC_CAP_SPIRAM)) / 1024));
+        /*创建请求队列和缓存锁*/
+        jpeg_queue = xQueueCreate(JPEGDECODER_QUEUE_LEN, sizeof(struct jpeg_dec_request_t));
+        cache_mutex = xSemaphoreCreateMutex();
+        decoded_mutex = xSemaphoreCreateMutex();
         /*设置解码配置*/
-        jpeg_stream.config.output_type = format;
-        jpeg_stream.config.rotate = rotate;
-        /*Create jpeg_dec handle*/
-        jpeg_dec_open(&jpeg_stream.config, &jpeg_stream.jpeg_dec);
-        /*创建解码任务*/
-        xTaskCreatePinnedToCore(JpegDecTask, 
-                                "JpegDecTask", 
-                                4096, 
-                                this, 
-                                JPEGDECODER_TASK_PRIOR, 
-                                &JpegDecTask_handle, 
-                                JPEGDECODER_TASK_CORE);
+        default_format = format;
+        default_rotate = rotate;
+        /*创建解码任务，解码句柄在第一个请求时创建*/
+        for(int i = 0; i < JPEGDECODER_WORKER_NUM; i++){
+            char name[16];
+            snprintf(name, sizeof(name), "JpegDecTask%d", i);
+            jpeg_workers[i].app = this;
+            xTaskCreatePinnedToCore(JpegDecTask, 
+                                    name, 
+                                    JPEGDECODER_TASK_STACK, 
+                                    &jpeg_workers[i], 
+                                    JPEGDECODER_TASK_PRIOR, 
+                                    &jpeg_workers[i].handle, 
+                                    JPEGDECODER_TASK_CORE);
+        }
+        /*注册条带解码源的LVGL图像解码器，后注册的解码器先被查询*/
+        stripe_decoder = lv_image_decoder_create();
+        if(stripe_decoder != NULL){
+            lv_image_decoder_set_info_cb(stripe_decoder, stripe_decoder_info);
+            lv_image_decoder_set_open_cb(stripe_decoder, stripe_decoder_open);
+            lv_image_decoder_set_get_area_cb(stripe_decoder, stripe_decoder_get_area);
+            lv_image_decoder_set_close_cb(stripe_decoder, stripe_decoder_close);
+            stripe_decoder->name = "JpegStripe";
+            stripe_decoder->user_data = this;
+        }
         ESP_LOGI(TAG, "JpegDecoder on create");
     }
 
-    void JpegDecoder::StartJpegDec(int jpeg_index, struct jpeg_output_info_t output)
+    bool JpegDecoder::SetRangeConfig(int start, int end, jpeg_load_mode_t mode, int read_ahead)
+    {
+        if(start < 1 || start > end || end > jpeg_input_info.jpeg_number || range_config_number >= JPEGDECODER_RANGE_CONFIG_MAX)return false;
+        range_config[range_config_number].start = start;
+        range_config[range_config_number].end = end;
+        range_config[range_config_number].mode = mode;
+        range_config[range_config_number].read_ahead = read_ahead;
+        range_config_number++;
+        /*常驻的帧立即读入*/
+        if(mode == JPEG_LOAD_PRELOAD){
+            int64_t start_us = esp_timer_get_time();
+            size_t pinned_bytes = jpeg_input_info.pinned_bytes;
+            xSemaphoreTake(cache_mutex, portMAX_DELAY);
+            for(int i = start - 1; i < end; i++){
+                evict_frame(i);
+                load_frame(i, true);
+            }
+            xSemaphoreGive(cache_mutex);
+            ESP_LOGI(TAG, "preload %d-%d: %dKB in %dms", start, end,
+                    (int)((jpeg_input_info.pinned_bytes - pinned_bytes) / 1024), (int)((esp_timer_get_time() - start_us) / 1000));
+        }
+        return true;
+    }
+
+    bool JpegDecoder::FindJpegAnimation(const char *descpath, const char *target, struct jpeg_anim_info_t* anim)
+    {
+        if(target == NULL || anim == NULL)return false;
+        for(int i = 0; i < pack_anim_number; i++){
+            char name[JPAK_NAME_LEN + 1];
+            memcpy(name, pack_anims[i].name, JPAK_NAME_LEN);
+            name[JPAK_NAME_LEN] = '\0';
+            if(strcasecmp(name, target) != 0)continue;
+            anim->start = pack_anims[i].start;
+            anim->end = pack_anims[i].end;
+            anim->fps = (pack_anims[i].fps != 0) ? pack_anims[i].fps : JPEGDECODER_ANIM_FPS_DEFAULT;
+            anim->loop_mode = (jpeg_loop_mode_t)pack_anims[i].loop_mode;
+            anim->delta = (pack_anims[i].flags & JPAK_ANIM_FLAG_DELTA) != 0;
+            return true;
+        }
+        /*目录模式的描述文件没有播放参数*/
+        if(FindJpegMaterial(descpath, target, &anim->start, &anim->end) != true)return false;
+        anim->fps = JPEGDECODER_ANIM_FPS_DEFAULT;
+        anim->loop_mode = JPEG_LOOP_REPEAT;
+        anim->delta = false;
+        return true;
+    }
+
+    void JpegDecoder::PrintCacheInfo()
+    {
+        ESP_LOGI(TAG, "frame cache: %dKB/%dKB, pinned %dKB, hit %u, miss %u",
+                (int)(jpeg_input_info.cache_bytes / 1024), (int)(JPEGDECODER_CACHE_BYTES / 1024),
+                (int)(jpeg_input_info.pinned_bytes / 1024), (unsigned)jpeg_input_info.cache_hit, (unsigned)jpeg_input_info.cache_miss);
+        for(int i = 0; i < JPEGDECODER_WORKER_NUM; i++){
+            uint32_t count = jpeg_workers[i].dec_count;
+            ESP_LOGI(TAG, "worker %d: %u decodes, avg %uus", i, (unsigned)count, (unsigned)((count != 0) ? (jpeg_workers[i].dec_us / count) : 0));
+        }
+        ESP_LOGI(TAG, "queue: %u waiting", (unsigned)((jpeg_queue != NULL) ? uxQueueMessagesWaiting(jpeg_queue) : 0));
+        if(decoded_cache_budget != 0){
+            ESP_LOGI(TAG, "decoded cache: %dKB/%dKB, hit %u, miss %u", (int)(decoded_cache_bytes / 1024), (int)(decoded_cache_budget / 1024),
+                    (unsigned)decoded_hit, (unsigned)decoded_miss);
+        }
+        if(stripe_block_count != 0){
+            ESP_LOGI(TAG, "stripe: %u blocks, avg %uus, %u restarts", (unsigned)stripe_block_count,
+                    (unsigned)(stripe_block_us / stripe_block_count), (unsigned)stripe_restart_count);
+        }
+        if(delta_frame_count != 0){
+            ESP_LOGI(TAG, "delta: %u frames, %u keyframes, %u lagged, avg %uus, avg redraw %upx", (unsigned)delta_frame_count,
+                    (unsigned)delta_key_count, (unsigned)delta_lag_count, (unsigned)(delta_us / delta_frame_count), (unsigned)(delta_px / delta_frame_count));
+        }
+        for(int i = 0; i < JPEGDECODER_ANIM_PLAYER_MAX; i++){
+            jpeg_anim_player_t* player = anim_players[i];
+            if(player == NULL)continue;
+            ESP_LOGI(TAG, "anim %s: %u.%ufps/%dfps, shown %u, dropped %u", player->name,
+                    (unsigned)(player->fps_x10 / 10), (unsigned)(player->fps_x10 % 10), player->anim.fps,
+                    (unsigned)player->shown_count, (unsigned)player->dropped_count);
+        }
+    }
+
+    void JpegDecoder::DecodeBenchmark(int jpeg_index, int width, int height, int iterations)
+    {
+        if(jpeg_index < 1 || jpeg_index > jpeg_input_info.jpeg_number || iterations <= 0)return;
+        uint8_t* src = acquire_frame(jpeg_index - 1);
+        if(src == NULL)return;
+        int src_len = jpeg_input_info.jpeg_len[jpeg_index - 1];
+        size_t outbuf_size = (size_t)width * height * 3;          /*按每像素最多3字节(RGB888)分配，所有输出格式都够用*/
+        uint8_t* outbuf = (uint8_t*)heap_caps_aligned_alloc(16, outbuf_size, MALLOC_CAP_SPIRAM);
+        if(outbuf == NULL){
+            ESP_LOGE(TAG, "benchmark buffer malloc fialed");
+            release_frame(jpeg_index - 1);
+            return;
+        }
+        /*先各解码一次，解码句柄和输出缓冲区都已就绪后再计时*/
+        uint16_t out_width = 0, out_height = 0;
+        Decode(src, src_len, outbuf, outbuf_size, &out_width, &out_height, width, height, default_format, default_rotate);
+        Decode(src, src_len, width, height, default_format, default_rotate);
+
+        /*每次解码返回、结果还持有时量一次所有堆的空闲字节，和循环前相比即每次解码占用的堆*/
+        int64_t alloc_held = 0;
+        size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        int64_t start_us = esp_timer_get_time();
+        for(int i = 0; i < iterations; i++){
+            DecodeResult result = Decode(src, src_len, width, height, default_format, default_rotate);
+            alloc_held += (int64_t)free_before - (int64_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        }
+        int64_t alloc_us = esp_timer_get_time() - start_us;
+        int leak_bytes = (int)((int64_t)free_before - (int64_t)heap_caps_get_free_size(MALLOC_CAP_8BIT));
+
+        int64_t reuse_held = 0;
+        int fail_count = 0;
+        free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        start_us = esp_timer_get_time();
+        for(int i = 0; i < iterations; i++){
+            if(Decode(src, src_len, outbuf, outbuf_size, &out_width, &out_height, width, height, default_format, default_rotate) != JPEG_DEC_OK)fail_count++;
+            reuse_held += (int64_t)free_before - (int64_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        }
+        int64_t reuse_us = esp_timer_get_time() - start_us;
+        int reuse_leak_bytes = (int)((int64_t)free_before - (int64_t)heap_caps_get_free_size(MALLOC_CAP_8BIT));
+
+        ESP_LOGI(TAG, "decode bench frame %d -> %dx%d, %d iterations", jpeg_index, width, height, iterations);
+        ESP_LOGI(TAG, "allocating: avg %dus, %d heap bytes held per decode, %d bytes not returned",
+                (int)(alloc_us / iterations), (int)(alloc_held / iterations), leak_bytes);
+        ESP_LOGI(TAG, "caller buffer: avg %dus, %d heap bytes held per decode, %d bytes not returned, %d failed",
+                (int)(reuse_us / iterations), (int)(reuse_held / iterations), reuse_leak_bytes, fail_count);
+        heap_caps_free(outbuf);
+        release_frame(jpeg_index - 1);
+    }
+
+    bool JpegDecoder::SubmitJpegDec(const struct jpeg_dec_request_t* req)
+    {
+        if(req == NULL || jpeg_queue == NULL)return false;
+        /*高优先级的请求插到队列头部，不等待队列空位*/
+        BaseType_t ret = (req->priority == JPEG_DEC_PRIORITY_HIGH) ? xQueueSendToFront(jpeg_queue, req, 0) : xQueueSendToBack(jpeg_queue, req, 0);
+        if(ret != pdTRUE){
+            ESP_LOGW(TAG, "decode queue full");
+            return false;
+        }
+        return true;
+    }
+
+    JpegDecoder::jpeg_frame_ring_t* JpegDecoder::CreateFrameRing(int jpeg_len, int slot_number)
+    {
+        if(slot_number < 2 || slot_number > JPEGDECODER_FRAME_RING_MAX || jpeg_len <= 0)return NULL;
+        jpeg_frame_ring_t* ring = (jpeg_frame_ring_t*)heap_caps_calloc(1, sizeof(jpeg_frame_ring_t), MALLOC_CAP_DEFAULT);
+        if(ring == NULL)return NULL;
+        ring->jpeg_len = jpeg_len;
+        ring->slot_number = slot_number;
+        ring->front = -1;
+        ring->back = -1;
+        ring->jpeg_index = -1;
+        ring->done_sem = xSemaphoreCreateBinary();
+        if(ring->done_sem == NULL){
+            heap_caps_free(ring);
+            return NULL;
+        }
+        for(int i = 0; i < slot_number; i++){
+            ring->jpeg_buff[i] = (uint8_t*)heap_caps_aligned_alloc(16, jpeg_len, MALLOC_CAP_SPIRAM);
+            if(ring->jpeg_buff[i] == NULL){
+                ESP_LOGE(TAG, "frame ring slot %d malloc buffer from PSRAM fialed", i);
+                DeleteFrameRing(ring);
+                return NULL;
+            }
+        }
+        return ring;
+    }
+
+    void JpegDecoder::DeleteFrameRing(jpeg_frame_ring_t* ring)
+    {
+        if(ring == NULL)return;
+        /*解码任务可能还在写入该输出环*/
+        if(ring->back >= 0)xSemaphoreTake(ring->done_sem, portMAX_DELAY);
+        for(int i = 0; i < JPEGDECODER_FRAME_RING_MAX; i++){
+            if(ring->jpeg_buff[i] != NULL)heap_caps_free(ring->jpeg_buff[i]);
+        }
+        vSemaphoreDelete(ring->done_sem);
+        heap_caps_free(ring);
+    }
+
+    void JpegDecoder::ring_done_cb(struct jpeg_dec_request_t* req, bool success)
+    {
+        jpeg_frame_ring_t* ring = (jpeg_frame_ring_t*)req->user_data;
+        ring->back_success = success;
+        xSemaphoreGive(ring->done_sem);
+    }
+
+    bool JpegDecoder::StartJpegDec(int jpeg_index, jpeg_frame_ring_t* ring)
+    {
+        /*每个输出环同时只有一个解码，不会写入正在显示的槽位*/
+        if(ring == NULL || ring->back >= 0)return false;
+        /*写入前台之后的槽位，前台槽位保持不变*/
+        ring->back = (ring->front + 1) % ring->slot_number;
+        ring->back_jpeg_index = jpeg_index;
+        ring->back_success = false;
+        struct jpeg_dec_request_t req = {};
+        req.jpeg_index = jpeg_index;
+        req.dst = ring->jpeg_buff[ring->back];
+        req.dst_len = ring->jpeg_len;
+        req.format = default_format;
+        req.rotate = default_rotate;
+        req.priority = JPEG_DEC_PRIORITY_NORMAL;
+        req.cb = ring_done_cb;
+        req.user_data = ring;
+        if(SubmitJpegDec(&req) != true){
+            ring->back = -1;
+            return false;
+        }
+        return true;
+    }
+
+    uint8_t* JpegDecoder::WaitJpegDec(jpeg_frame_ring_t* ring, int* jpeg_index, TickType_t xTicksToWait)
+    {
+        if(ring == NULL || ring->back < 0)return NULL;
+        if(xSemaphoreTake(ring->done_sem, xTicksToWait) != pdTRUE)return NULL;
+        /*只有解码成功才切换前台，失败时前台槽位仍是控件正在显示的缓存*/
+        if(ring->back_success != true){
+            ring->back = -1;
+            return NULL;
+        }
+        ring->front = ring->back;
+        ring->back = -1;
+        ring->jpeg_index = ring->back_jpeg_index;
+        if(jpeg_index != NULL)*jpeg_index = ring->jpeg_index;
+        return ring->jpeg_buff[ring->front];
+    }
+
+    JpegDecoder::jpeg_stripe_src_t* JpegDecoder::CreateStripeSource(int width, int height)
+    {
+        /*块模式不支持缩放和旋转，宽高需要8的倍数*/
+        if(stripe_decoder == NULL || default_rotate != JPEG_ROTATE_0D || default_format != JPEG_PIXEL_FORMAT_RGB565_LE)return NULL;
+        if(width <= 0 || height <= 0 || (width % JPEGDECODER_SCALE_ALIGN) != 0 || (height % JPEGDECODER_SCALE_ALIGN) != 0)return NULL;
+        jpeg_stripe_src_t* stripe = (jpeg_stripe_src_t*)heap_caps_calloc(1, sizeof(jpeg_stripe_src_t), MALLOC_CAP_DEFAULT);
+        if(stripe == NULL)return NULL;
+        stripe->magic = JPEG_STRIPE_MAGIC;
+        stripe->width = width;
+        stripe->height = height;
+        stripe->mutex = xSemaphoreCreateMutex();
+        /*构建时已知所有帧的MCU高度，块缓存一次分配到位，解码中不再重新分配*/
+        if(pack_known){
+            stripe->block_buff = alloc_block_buff(width * JPEG_MATERIALS_MCU_HEIGHT_MAX * 2);
+            stripe->block_len = (stripe->block_buff != NULL) ? width * JPEG_MATERIALS_MCU_HEIGHT_MAX * 2 : 0;
+        }
+        jpeg_dec_config_t config = DEFAULT_JPEG_DEC_CONFIG();
+        config.output_type = default_format;
+        config.block_enable = true;
+        if(stripe->mutex == NULL || jpeg_dec_open(&config, &stripe->jpeg_dec) != JPEG_ERR_OK){
+            ESP_LOGE(TAG, "stripe source create fialed");
+            stripe->jpeg_dec = NULL;
+            DeleteStripeSource(stripe);
+            return NULL;
+        }
+        /*lv_image只认识lv_image_dsc_t，用RAW格式加魔数交给条带解码器*/
+        stripe->img_dsc.header.magic = LV_IMAGE_HEADER_MAGIC;
+        stripe->img_dsc.header.cf = LV_COLOR_FORMAT_RAW;
+        stripe->img_dsc.header.w = width;
+        stripe->img_dsc.header.h = height;
+        stripe->img_dsc.data = (const uint8_t*)stripe;
+        stripe->img_dsc.data_size = sizeof(jpeg_stripe_src_t);
+        return stripe;
+    }
+
+    void JpegDecoder::DeleteStripeSource(jpeg_stripe_src_t* stripe)
+    {
+        if(stripe == NULL)return;
+        if(stripe->mutex != NULL)xSemaphoreTake(stripe->mutex, portMAX_DELAY);
+        stripe_close(stripe);
+        release_decoded(stripe->cached, true);
+        if(stripe->jpeg_dec != NULL)jpeg_dec_close(stripe->jpeg_dec);
+        if(stripe->block_buff != NULL)heap_caps_free(stripe->block_buff);
+        if(stripe->mutex != NULL)vSemaphoreDelete(stripe->mutex);
+        heap_caps_free(stripe);
+    }
+
+    void JpegDecoder::SetStripeFrame(jpeg_stripe_src_t* stripe, int jpeg_index)
+    {
+        if(stripe == NULL || jpeg_index < 1 || jpeg_index > jpeg_input_info.jpeg_number)return;
+        stripe->jpeg_index = jpeg_index;
+        note_played(jpeg_index);
+        /*懒加载的帧先由解码任务读入，避免在渲染中读文件*/
+        struct jpeg_dec_request_t req = {};
+        req.jpeg_index = jpeg_index;
+        req.prefetch = true;
+        SubmitJpegDec(&req);
+    }
+
+    void JpegDecoder::stripe_close(jpeg_stripe_src_t* stripe)
+    {
+        if(stripe->stream_index != 0)release_frame(stripe->stream_index - 1);
+        release_decoded(stripe->filling, false);
+        stripe->filling = NULL;
+        stripe->stream_index = 0;
+        stripe->block_y = 0;
+    }
+
+    bool JpegDecoder::stripe_restart(jpeg_stripe_src_t* stripe)
+    {
+        int jpeg_index = stripe->jpeg_index;
+        stripe_close(stripe);
+        if(jpeg_index < 1 || jpeg_index > jpeg_input_info.jpeg_number)return false;
+        stripe_restart_count++;
+        uint8_t* src = acquire_frame(jpeg_index - 1);
+        if(src == NULL)return false;
+        stripe->stream_index = jpeg_index;
+
+        jpeg_dec_header_info_t info;
+        memset(&stripe->io, 0, sizeof(stripe->io));
+        stripe->io.inbuf = src;
+        stripe->io.inbuf_len = jpeg_input_info.jpeg_len[jpeg_index - 1];
+        /*esp_new_jpeg在这里读入量化表和哈夫曼表，已知的素材也不能省略*/
+        int ret = jpeg_dec_parse_header(stripe->jpeg_dec, &stripe->io, &info);
+        if(ret != JPEG_ERR_OK){
+            ESP_LOGE(TAG, "jpeg_dec_parse_header failed:%d", ret);
+            stripe_close(stripe);
+            return false;
+        }
+        int block_len = 0;
+        const jpeg_material_frame_t* meta = pack_known ? &JPEG_MATERIALS_FRAMES[jpeg_index - 1] : NULL;
+        if(meta != NULL && meta->keyframe && meta->width == stripe->width && meta->height == stripe->height){
+            /*构建时校验过尺寸和抽样，块大小直接由MCU高度得到*/
+            block_len = stripe->width * meta->mcu_height * 2;
+        }else{
+            /*块模式不能缩放，素材尺寸必须和解码源一致*/
+            if(info.width != stripe->width || info.height != stripe->height){
+                ESP_LOGE(TAG, "frame %d is %dx%d, stripe source is %dx%d", jpeg_index, info.width, info.height, stripe->width, stripe->height);
+                stripe_close(stripe);
+                return false;
+            }
+            ret = jpeg_dec_get_outbuf_len(stripe->jpeg_dec, &block_len);
+            if(ret != JPEG_ERR_OK || block_len <= 0){
+                ESP_LOGE(TAG, "jpeg_dec_get_outbuf_len failed:%d", ret);
+                stripe_close(stripe);
+                return false;
+            }
+        }
+        /*MCU高度随素材的色度抽样变化，块缓存按需要重新分配*/
+        if(block_len > stripe->block_len){
+            if(stripe->block_buff != NULL)heap_caps_free(stripe->block_buff);
+            stripe->block_buff = alloc_block_buff(block_len);
+            stripe->block_len = (stripe->block_buff != NULL) ? block_len : 0;
+            if(stripe->block_buff == NULL){
+                ESP_LOGE(TAG, "stripe block buffer malloc fialed");
+                stripe_close(stripe);
+                return false;
+            }
+        }
+        stripe->block_h = block_len / (stripe->width * 2);
+        stripe->block_y = -stripe->block_h;
+        /*从头解码整帧时顺带填充解码结果缓存*/
+        struct jpeg_decoded_entry_t key = {};
+        key.jpeg_index = jpeg_index;
+        key.format = default_format;
+        key.rotate = JPEG_ROTATE_0D;
+        stripe->filling = admit_decoded(&key, stripe->width * stripe->height * 2);
+        return true;
+    }
+
+    uint8_t* JpegDecoder::alloc_block_buff(int len)
     {
-        /*获取jpeg输出缓存信息*/
-        jpeg_output_info = output;
-        jpeg_stream.jpeg_io.outbuf = jpeg_output_info.jpeg_buff;
-        /*设置需要解码的坐标*/
-        jpeg_input_info.jpeg_index = jpeg_index;
-        /*开启解码*/
-        xEventGroupSetBits(xEventGroup, EVENTGROUP_JPEG_DEC_START_BIT);
+        /*块缓存优先放内部RAM*/
+        uint8_t* buff = (uint8_t*)heap_caps_aligned_alloc(16, len, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if(buff == NULL)buff = (uint8_t*)heap_caps_aligned_alloc(16, len, MALLOC_CAP_SPIRAM);
+        return buff;
+    }
+
+    bool JpegDecoder::stripe_next_block(jpeg_stripe_src_t* stripe)
+    {
+        if(stripe->stream_index == 0 || stripe->block_y + stripe->block_h >= stripe->height)return false;
+        int64_t start_us = esp_timer_get_time();
+        int stride = stripe->width * 2;
+        int next_y = stripe->block_y + stripe->block_h;
+        stripe->io.outbuf = stripe->block_buff;
+        int ret = jpeg_dec_process(stripe->jpeg_dec, &stripe->io);
+        if(ret != JPEG_ERR_OK){
+            ESP_LOGE(TAG, "jpeg_dec_process failed:%d", ret);
+            stripe_close(stripe);
+            return false;
+        }
+        /*最后一块可能不满一个MCU行*/
+        stripe->block_y = next_y;
+        if(stripe->io.out_size > 0)stripe->block_h = stripe->io.out_size / stride;
+        if(stripe->block_y + stripe->block_h > stripe->height)stripe->block_h = stripe->height - stripe->block_y;
+        if(stripe->filling != NULL){
+            memcpy(stripe->filling->buff + stripe->block_y * stride, stripe->block_buff, stripe->block_h * stride);
+            if(stripe->block_y + stripe->block_h >= stripe->height){
+                stripe->filling->out_width = stripe->width;
+                stripe->filling->out_height = stripe->height;
+                release_decoded(stripe->filling, true);
+                stripe->filling = NULL;
+            }
+        }
+        stripe_block_us += esp_timer_get_time() - start_us;
+        stripe_block_count++;
+        return true;
     }
 
-    bool JpegDecoder::WaitJpegDec(int* jpeg_index, TickType_t xTicksToWait)
+    lv_result_t JpegDecoder::stripe_decoder_info(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc, lv_image_header_t* header)
     {
-        /*等待解码*/
-        if((xEventGroupWaitBits(xEventGroup,EVENTGROUP_JPEG_DEC_END_BIT,pdFALSE,pdTRUE,xTicksToWait) & 
-                EVENTGROUP_JPEG_DEC_END_BIT) == 
-                EVENTGROUP_JPEG_DEC_END_BIT){
-                    /*手动清除*/
-                    xEventGroupClearBits(xEventGroup, EVENTGROUP_JPEG_DEC_END_BIT);
-                    if(jpeg_index != NULL)*jpeg_index = jpeg_input_info.jpeg_index;
-                    return true;
+        if(dsc->src_type != LV_IMAGE_SRC_VARIABLE)return LV_RESULT_INVALID;
+        const lv_image_dsc_t* img_dsc = (const lv_image_dsc_t*)dsc->src;
+        if(img_dsc->header.cf != LV_COLOR_FORMAT_RAW || img_dsc->data_size != sizeof(jpeg_stripe_src_t))return LV_RESULT_INVALID;
+        const jpeg_stripe_src_t* stripe = (const jpeg_stripe_src_t*)img_dsc->data;
+        if(stripe->magic != JPEG_STRIPE_MAGIC)return LV_RESULT_INVALID;
+        header->magic = LV_IMAGE_HEADER_MAGIC;
+        header->cf = LV_COLOR_FORMAT_RGB565;
+        header->w = stripe->width;
+        header->h = stripe->height;
+        header->stride = stripe->width * 2;
+        return LV_RESULT_OK;
+    }
+
+    lv_result_t JpegDecoder::stripe_decoder_open(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc)
+    {
+        jpeg_stripe_src_t* stripe = (jpeg_stripe_src_t*)((const lv_image_dsc_t*)dsc->src)->data;
+        /*并行的绘制单元不能同时使用同一个解码流*/
+        xSemaphoreTake(stripe->mutex, portMAX_DELAY);
+        dsc->user_data = stripe;
+        /*decoded为NULL时LVGL通过get_area逐块绘制*/
+        dsc->decoded = NULL;
+        return LV_RESULT_OK;
+    }
+
+    lv_result_t JpegDecoder::stripe_decoder_get_area(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc, const lv_area_t* full_area, lv_area_t* decoded_area)
+    {
+        JpegDecoder* app = (JpegDecoder*)decoder->user_data;
+        jpeg_stripe_src_t* stripe = (jpeg_stripe_src_t*)dsc->user_data;
+
+        if(decoded_area->y1 == LV_COORD_MIN){
+            /*整帧在解码结果缓存中时一次交给LVGL*/
+            struct jpeg_decoded_entry_t key = {};
+            key.jpeg_index = stripe->jpeg_index;
+            key.format = app->default_format;
+            key.rotate = JPEG_ROTATE_0D;
+            stripe->cached = app->acquire_decoded(&key);
+            if(stripe->cached != NULL){
+                decoded_area->x1 = 0;
+                decoded_area->x2 = stripe->width - 1;
+                decoded_area->y1 = 0;
+                decoded_area->y2 = stripe->height - 1;
+                lv_draw_buf_t* decoded = &stripe->draw_buf;
+                decoded->header = dsc->header;
+                decoded->header.stride = stripe->width * 2;
+                decoded->data = stripe->cached->buff;
+                decoded->unaligned_data = stripe->cached->buff;
+                decoded->data_size = stripe->cached->len;
+                dsc->decoded = decoded;
+                return LV_RESULT_OK;
+            }
+            /*本次绘制的第一块：换了帧或者需要的行已经解码过去时，从头开始解码*/
+            if(stripe->stream_index != stripe->jpeg_index || full_area->y1 < stripe->block_y){
+                if(app->stripe_restart(stripe) != true)return LV_RESULT_INVALID;
+            }
+        }else{
+            if(stripe->cached != NULL)return LV_RESULT_INVALID;
+            /*需要的区域已经画完，剩下的行留给下一个条带*/
+            if(stripe->block_y + stripe->block_h > full_area->y2)return LV_RESULT_INVALID;
+            if(app->stripe_next_block(stripe) != true)return LV_RESULT_INVALID;
+        }
+        /*跳过需要区域之上的块*/
+        while(stripe->block_y + stripe->block_h <= full_area->y1){
+            if(app->stripe_next_block(stripe) != true)return LV_RESULT_INVALID;
+        }
+
+        decoded_area->x1 = 0;
+        decoded_area->x2 = stripe->width - 1;
+        decoded_area->y1 = stripe->block_y;
+        decoded_area->y2 = stripe->block_y + stripe->block_h - 1;
+
+        lv_draw_buf_t* decoded = &stripe->draw_buf;
+        decoded->header = dsc->header;
+        decoded->header.h = stripe->block_h;
+        decoded->header.stride = stripe->width * 2;
+        decoded->data = stripe->block_buff;
+        decoded->unaligned_data = stripe->block_buff;
+        decoded->data_size = stripe->block_h * decoded->header.stride;
+        dsc->decoded = decoded;
+        return LV_RESULT_OK;
+    }
+
+    void JpegDecoder::stripe_decoder_close(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc)
+    {
+        jpeg_stripe_src_t* stripe = (jpeg_stripe_src_t*)dsc->user_data;
+        JpegDecoder* app = (JpegDecoder*)decoder->user_data;
+        /*draw_buf属于解码源，不释放*/
+        dsc->decoded = NULL;
+        app->release_decoded(stripe->cached, true);
+        stripe->cached = NULL;
+        xSemaphoreGive(stripe->mutex);
+    }
+
+    JpegDecoder::jpeg_delta_src_t* JpegDecoder::CreateDeltaSource(int width, int height)
+    {
+        /*补丁按行拷贝到画布，不支持旋转*/
+        if(default_rotate != JPEG_ROTATE_0D || default_format != JPEG_PIXEL_FORMAT_RGB565_LE)return NULL;
+        if(width <= 0 || height <= 0)return NULL;
+        jpeg_delta_src_t* delta = (jpeg_delta_src_t*)heap_caps_calloc(1, sizeof(jpeg_delta_src_t), MALLOC_CAP_DEFAULT);
+        if(delta == NULL)return NULL;
+        delta->width = width;
+        delta->height = height;
+        delta->canvas = (uint8_t*)heap_caps_aligned_alloc(16, width * height * 2, MALLOC_CAP_SPIRAM);
+        jpeg_dec_config_t config = DEFAULT_JPEG_DEC_CONFIG();
+        config.output_type = default_format;
+        if(delta->canvas == NULL || jpeg_dec_open(&config, &delta->jpeg_dec) != JPEG_ERR_OK){
+            ESP_LOGE(TAG, "delta source create fialed");
+            delta->jpeg_dec = NULL;
+            DeleteDeltaSource(delta);
+            return NULL;
+        }
+        memset(delta->canvas, 0, width * height * 2);
+        /*补丁缓存按构建时统计的最大补丁预先分配，播放中不再重新分配*/
+        if(pack_known && JPEG_MATERIALS_PATCH_BYTES_MAX > 0){
+            delta->patch_buff = (uint8_t*)heap_caps_aligned_alloc(16, JPEG_MATERIALS_PATCH_BYTES_MAX, MALLOC_CAP_SPIRAM);
+            delta->patch_len = (delta->patch_buff != NULL) ? JPEG_MATERIALS_PATCH_BYTES_MAX : 0;
+        }
+        delta->img_dsc.header.magic = LV_IMAGE_HEADER_MAGIC;
+        delta->img_dsc.header.cf = LV_COLOR_FORMAT_RGB565;
+        delta->img_dsc.header.w = width;
+        delta->img_dsc.header.h = height;
+        delta->img_dsc.header.stride = width * 2;
+        delta->img_dsc.data = delta->canvas;
+        delta->img_dsc.data_size = width * height * 2;
+        return delta;
+    }
+
+    void JpegDecoder::DeleteDeltaSource(jpeg_delta_src_t* delta)
+    {
+        if(delta == NULL)return;
+        if(delta->jpeg_dec != NULL)jpeg_dec_close(delta->jpeg_dec);
+        if(delta->canvas != NULL)heap_caps_free(delta->canvas);
+        if(delta->patch_buff != NULL)heap_caps_free(delta->patch_buff);
+        heap_caps_free(delta);
+    }
+
+    bool JpegDecoder::SetDeltaFrame(jpeg_delta_src_t* delta, const struct jpeg_anim_info_t* anim, int jpeg_index)
+    {
+        /*jpeg_index从1开始，换成帧表的下标再检查*/
+        int frame = jpeg_index - 1;
+        if(delta == NULL || anim == NULL || jpeg_index < anim->start || jpeg_index > anim->end || frame < 0 || frame >= jpeg_input_info.jpeg_number)return false;
+        if(jpeg_index == delta->shown_index)return true;
+        int64_t start_us = esp_timer_get_time();
+        /*差分帧只能叠加在上一帧上：从目标帧之前最近的关键帧开始，画布上的帧在这个关键帧之后时接着向后叠加更近*/
+        int next = jpeg_index;
+        if(anim->delta == true){
+            next = delta_seek_key(anim, jpeg_index);
+            if(delta->shown_index >= next && delta->shown_index < jpeg_index)next = delta->shown_index + 1;
+            /*关键帧太稀疏时一次只追一部分，先显示追到的帧，不让LVGL任务卡在整段回放上*/
+            if(jpeg_index - next >= JPEGDECODER_DELTA_CATCHUP_MAX){
+                jpeg_index = next + JPEGDECODER_DELTA_CATCHUP_MAX - 1;
+                delta_lag_count++;
+            }
+        }
+        for(; next <= jpeg_index; next++){
+            if(delta_apply(delta, next) != true){
+                ESP_LOGE(TAG, "delta frame %d apply fialed", next);
+                delta->shown_index = 0;
+                return false;
+            }
+            delta->shown_index = next;
+            delta_frame_count++;
+        }
+        delta_us += esp_timer_get_time() - start_us;
+        /*懒加载的下一帧先由解码任务读入*/
+        if(jpeg_index < anim->end){
+            struct jpeg_dec_request_t req = {};
+            req.jpeg_index = jpeg_index + 1;
+            req.prefetch = true;
+            SubmitJpegDec(&req);
+        }
+        return true;
+    }
+
+    int JpegDecoder::delta_seek_key(const struct jpeg_anim_info_t* anim, int jpeg_index)
+    {
+        /*找不到时(目录模式、v3之前的文件模式容器)只知道第一帧是关键帧*/
+        if(jpeg_input_info.jpeg_key == NULL)return anim->start;
+        for(int i = jpeg_index; i > anim->start; i--){
+            if(jpeg_input_info.jpeg_key[i - 1] != 0)return i;
+        }
+        return anim->start;
+    }
+
+    void JpegDecoder::InvalidateDeltaSource(jpeg_delta_src_t* delta, lv_obj_t* obj)
+    {
+        if(delta == NULL || obj == NULL)return;
+        /*重绘区域从画布坐标换算到屏幕坐标*/
+        lv_area_t coords;
+        lv_obj_get_coords(obj, &coords);
+        for(int i = 0; i < delta->dirty_number; i++){
+            lv_area_t area = delta->dirty[i];
+            lv_area_move(&area, coords.x1, coords.y1);
+            lv_obj_invalidate_area(obj, &area);
+            delta_px += lv_area_get_size(&area);
+        }
+        delta->dirty_number = 0;
+    }
+
+    bool JpegDecoder::delta_decode(jpeg_delta_src_t* delta, const uint8_t* src, int len, int x, int y, int w, int h)
+    {
+        jpeg_dec_io_t io = {};
+        jpeg_dec_header_info_t info;
+        int outbuf_len = 0;
+        int stride = delta->width * 2;
+        io.inbuf = (uint8_t*)src;
+        io.inbuf_len = len;
+        int ret = jpeg_dec_parse_header(delta->jpeg_dec, &io, &info);
+        if(ret != JPEG_ERR_OK){
+            ESP_LOGE(TAG, "jpeg_dec_parse_header failed:%d", ret);
+            return false;
+        }
+        if(info.width != w || info.height != h || x < 0 || y < 0 || x + w > delta->width || y + h > delta->height){
+            ESP_LOGE(TAG, "patch %dx%d at (%d,%d) is out of the canvas", info.width, info.height, x, y);
+            return false;
+        }
+        ret = jpeg_dec_get_outbuf_len(delta->jpeg_dec, &outbuf_len);
+        if(ret != JPEG_ERR_OK || outbuf_len <= 0){
+            ESP_LOGE(TAG, "jpeg_dec_get_outbuf_len failed:%d", ret);
+            return false;
+        }
+        /*整行宽的补丁(包括关键帧)直接解码到画布，其余的解码后按行拷贝*/
+        bool direct = (x == 0 && w == delta->width && outbuf_len <= (delta->height - y) * stride);
+        if(direct != true && outbuf_len > delta->patch_len){
+            if(delta->patch_buff != NULL)heap_caps_free(delta->patch_buff);
+            delta->patch_buff = (uint8_t*)heap_caps_aligned_alloc(16, outbuf_len, MALLOC_CAP_SPIRAM);
+            delta->patch_len = (delta->patch_buff != NULL) ? outbuf_len : 0;
+            if(delta->patch_buff == NULL){
+                ESP_LOGE(TAG, "patch buffer malloc fialed");
+                return false;
+            }
+        }
+        io.outbuf = direct ? (delta->canvas + y * stride) : delta->patch_buff;
+        ret = jpeg_dec_process(delta->jpeg_dec, &io);
+        if(ret != JPEG_ERR_OK){
+            ESP_LOGE(TAG, "jpeg_dec_process failed:%d", ret);
+            return false;
+        }
+        if(direct != true){
+            for(int row = 0; row < h; row++){
+                memcpy(delta->canvas + (y + row) * stride + x * 2, delta->patch_buff + row * w * 2, w * 2);
+            }
+        }
+        return true;
+    }
+
+    bool JpegDecoder::delta_apply(jpeg_delta_src_t* delta, int jpeg_index)
+    {
+        uint8_t* data = acquire_frame(jpeg_index - 1);
+        if(data == NULL)return false;
+        uint32_t len = jpeg_input_info.jpeg_len[jpeg_index - 1];
+        bool success = false;
+        if(len >= 2 && data[0] == 0xFF && data[1] == 0xD8){
+            /*关键帧整帧重绘*/
+            success = delta_decode(delta, data, len, 0, 0, delta->width, delta->height);
+            if(success == true){
+                delta->dirty_number = 0;
+                delta_mark_dirty(delta, 0, 0, delta->width, delta->height);
+                delta_key_count++;
+            }
+        }else if(len >= sizeof(struct jpak_delta_t) && memcmp(data, JPAK_DELTA_MAGIC, 4) == 0 && delta->shown_index != 0){
+            const struct jpak_delta_t* head = (const struct jpak_delta_t*)data;
+            const struct jpak_patch_t* patches = (const struct jpak_patch_t*)(data + sizeof(struct jpak_delta_t));
+            success = (sizeof(struct jpak_delta_t) + head->patch_number * sizeof(struct jpak_patch_t) <= len);
+            for(int i = 0; i < head->patch_number && success == true; i++){
+                const struct jpak_patch_t* patch = &patches[i];
+                if(patch->offset > len || patch->length > len - patch->offset){
+                    success = false;
+                    break;
                 }
-        return false;
+                success = delta_decode(delta, data + patch->offset, patch->length, patch->x, patch->y, patch->w, patch->h);
+                if(success == true)delta_mark_dirty(delta, patch->x, patch->y, patch->w, patch->h);
+            }
+        }
+        release_frame(jpeg_index - 1);
+        return success;
+    }
+
+    void JpegDecoder::delta_mark_dirty(jpeg_delta_src_t* delta, int x, int y, int w, int h)
+    {
+        lv_area_t area;
+        area.x1 = x;
+        area.y1 = y;
+        area.x2 = x + w - 1;
+        area.y2 = y + h - 1;
+        /*超出个数时并入最后一个区域*/
+        if(delta->dirty_number < JPEGDECODER_DELTA_DIRTY_MAX){
+            delta->dirty[delta->dirty_number++] = area;
+        }else{
+            lv_area_join(&delta->dirty[JPEGDECODER_DELTA_DIRTY_MAX - 1], &delta->dirty[JPEGDECODER_DELTA_DIRTY_MAX - 1], &area);
+        }
+    }
+
+    JpegDecoder::jpeg_anim_player_t* JpegDecoder::CreateAnimPlayer(const char* name, const struct jpeg_anim_info_t* anim)
+    {
+        if(anim == NULL || anim->start < 1 || anim->start > anim->end || anim->end > jpeg_input_info.jpeg_number)return NULL;
+        int slot = -1;
+        for(int i = 0; i < JPEGDECODER_ANIM_PLAYER_MAX; i++){
+            if(anim_players[i] == NULL){
+                slot = i;
+                break;
+            }
+        }
+        if(slot < 0)return NULL;
+        jpeg_anim_player_t* player = (jpeg_anim_player_t*)heap_caps_calloc(1, sizeof(jpeg_anim_player_t), MALLOC_CAP_DEFAULT);
+        if(player == NULL)return NULL;
+        player->name = name;
+        player->anim = *anim;
+        if(player->anim.fps <= 0)player->anim.fps = JPEGDECODER_ANIM_FPS_DEFAULT;
+        player->shown_frame = -1;
+        player->pending_frame = -1;
+        anim_players[slot] = player;
+        return player;
+    }
+
+    void JpegDecoder::DeleteAnimPlayer(jpeg_anim_player_t* player)
+    {
+        if(player == NULL)return;
+        for(int i = 0; i < JPEGDECODER_ANIM_PLAYER_MAX; i++){
+            if(anim_players[i] == player)anim_players[i] = NULL;
+        }
+        heap_caps_free(player);
+    }
+
+    int64_t JpegDecoder::AnimPlayerDueFrame(jpeg_anim_player_t* player)
+    {
+        int64_t now_us = esp_timer_get_time();
+        if(player->start_us == 0){
+            player->start_us = now_us;
+            player->fps_window_us = now_us;
+        }
+        int64_t frame = (now_us - player->start_us) * player->anim.fps / 1000000;
+        /*只播放一次的动画停在最后一帧*/
+        int64_t len = player->anim.end - player->anim.start + 1;
+        if(player->anim.loop_mode == JPEG_LOOP_ONCE && frame >= len)frame = len - 1;
+        return frame;
+    }
+
+    int JpegDecoder::AnimPlayerFrameIndex(jpeg_anim_player_t* player, int64_t frame)
+    {
+        int64_t len = player->anim.end - player->anim.start + 1;
+        return player->anim.start + (int)(frame % len);
+    }
+
+    void JpegDecoder::AnimPlayerShown(jpeg_anim_player_t* player, int64_t frame)
+    {
+        int64_t now_us = esp_timer_get_time();
+        /*超过一秒没有显示(应用在后台)时重新同步，不计为丢帧*/
+        if(player->shown_frame >= 0 && frame > player->shown_frame + 1){
+            int64_t skipped = frame - player->shown_frame - 1;
+            if(skipped < player->anim.fps)player->dropped_count += skipped;
+        }
+        player->shown_frame = frame;
+        player->shown_count++;
+        /*每秒统计一次实际帧率，中间停顿过久的窗口丢弃*/
+        if(now_us - player->fps_window_us > 2000000){
+            player->fps_window_us = now_us;
+            player->fps_window_count = 0;
+        }
+        player->fps_window_count++;
+        if(now_us - player->fps_window_us >= 1000000){
+            player->fps_x10 = (uint32_t)((int64_t)player->fps_window_count * 10000000 / (now_us - player->fps_window_us));
+            player->fps_window_us = now_us;
+            player->fps_window_count = 0;
+        }
     }
 
     int JpegDecoder::SafeStrtoi(const char *str, int *value)
@@ -382,102 +1644,91 @@ namespace fml{
         return found;
     }
 
-    /*实现静态解码函数*/
-    JpegDecoder::DecodeResult JpegDecoder::Decode(
-        const uint8_t* jpeg_data, 
-        size_t jpeg_size,
-        int target_width,
-        int target_height,
-        jpeg_pixel_format_t output_format,
-        jpeg_rotate_t rotate
-    ) {
-        DecodeResult result;
-        
-        /*验证JPEG签名*/
-        if (jpeg_size < 2 || jpeg_data[0] != 0xFF || jpeg_data[1] != 0xD8) {
-            result.success = false;
-            result.error_message = "Invalid JPEG signature";
-            return result;
-        }
-        
-        /*配置解码参数*/
+    jpeg_dec_config_t JpegDecoder::make_decode_config(int target_width, int target_height, jpeg_pixel_format_t output_format, jpeg_rotate_t rotate)
+    {
         jpeg_dec_config_t config = DEFAULT_JPEG_DEC_CONFIG();
         config.output_type = output_format;
         config.rotate = rotate;
-        
         /*设置缩放尺寸（如果需要）*/
         if (target_width > 0 && target_height > 0) {
-            config.scale.width = target_width & ~0x7;  /*确保是8的倍数*/
-            config.scale.height = target_height & ~0x7; /*确保是8的倍数*/
+            config.scale.width = target_width & ~(JPEGDECODER_SCALE_ALIGN - 1);  /*确保是8的倍数*/
+            config.scale.height = target_height & ~(JPEGDECODER_SCALE_ALIGN - 1); /*确保是8的倍数*/
             
             /*如果计算后为0，则设置为8*/
             if (config.scale.width == 0) config.scale.width = 8;
             if (config.scale.height == 0) config.scale.height = 8;
         }
-        
-        jpeg_dec_handle_t jpeg_dec = nullptr;
-        jpeg_error_t err = jpeg_dec_open(&config, &jpeg_dec);
-        if (err != JPEG_ERR_OK) {
-            result.success = false;
-            result.error_message = "Failed to open JPEG decoder: " + std::to_string(err);
-            return result;
+        return config;
+    }
+
+    JpegDecoder::jpeg_dec_err_t JpegDecoder::decode_cached(const jpeg_dec_config_t* config, const uint8_t* src, size_t src_len,
+            uint8_t** dst, int* dst_len, uint16_t* out_width, uint16_t* out_height)
+    {
+        xSemaphoreTake(decode_mutex, portMAX_DELAY);
+        /*优先使用配置相同的句柄，没有时替换最久没用的句柄*/
+        struct jpeg_dec_handle_cache_t* slot = &decode_handles[0];
+        for(int i = 0; i < JPEGDECODER_DECODE_HANDLE_MAX; i++){
+            struct jpeg_dec_handle_cache_t* cache = &decode_handles[i];
+            if(cache->jpeg_dec != NULL && cache->config.output_type == config->output_type && cache->config.rotate == config->rotate &&
+                cache->config.scale.width == config->scale.width && cache->config.scale.height == config->scale.height){
+                slot = cache;
+                break;
+            }
+            if(cache->last_use < slot->last_use)slot = cache;
         }
-        
-        jpeg_dec_io_t io = {
-            .inbuf = const_cast<uint8_t*>(jpeg_data), 
-            .inbuf_len = static_cast<int>(jpeg_size),
-            .inbuf_remain = 0,
-            .outbuf = nullptr,
-            .out_size = 0
-        };
-        
-        jpeg_dec_header_info_t info;
-        err = jpeg_dec_parse_header(jpeg_dec, &io, &info);
-        if (err != JPEG_ERR_OK) {
-            jpeg_dec_close(jpeg_dec);
-            result.success = false;
-            result.error_message = "Failed to parse JPEG header: " + std::to_string(err);
-            return result;
+        slot->last_use = ++decode_clock;
+        jpeg_dec_err_t err = decode_with(&slot->jpeg_dec, &slot->config, config, src, src_len, dst, dst_len, out_width, out_height, NULL);
+        xSemaphoreGive(decode_mutex);
+        return err;
+    }
+
+    JpegDecoder::jpeg_dec_err_t JpegDecoder::Decode(const uint8_t* jpeg_data, size_t jpeg_size, uint8_t* outbuf, size_t outbuf_size, uint16_t* out_width, uint16_t* out_height,
+            int target_width, int target_height, jpeg_pixel_format_t output_format, jpeg_rotate_t rotate)
+    {
+        /*调用者的缓冲区不能为空，否则会在内部分配*/
+        if(outbuf == NULL)return JPEG_DEC_ERR_BUFFER_SMALL;
+        jpeg_dec_config_t config = make_decode_config(target_width, target_height, output_format, rotate);
+        int outbuf_len = (int)outbuf_size;
+        return getInstance().decode_cached(&config, jpeg_data, jpeg_size, &outbuf, &outbuf_len, out_width, out_height);
+    }
+
+    const char* JpegDecoder::DecodeErrorName(jpeg_dec_err_t err)
+    {
+        switch(err){
+            case JPEG_DEC_OK:                   return "ok";
+            case JPEG_DEC_ERR_SIGNATURE:        return "invalid JPEG signature";
+            case JPEG_DEC_ERR_OPEN:             return "failed to open JPEG decoder";
+            case JPEG_DEC_ERR_HEADER:           return "failed to parse JPEG header";
+            case JPEG_DEC_ERR_NO_MEM:           return "failed to allocate output buffer";
+            case JPEG_DEC_ERR_BUFFER_SMALL:     return "output buffer too small";
+            case JPEG_DEC_ERR_BUFFER_ALIGN:     return "output buffer not 16-byte aligned";
+            case JPEG_DEC_ERR_PROCESS:          return "JPEG decoding failed";
+            default:                            return "unknown error";
         }
-        
+    }
+
+    /*实现静态解码函数，输出缓冲区由解码分配，所有权交给DecodeResult*/
+    JpegDecoder::DecodeResult JpegDecoder::Decode(
+        const uint8_t* jpeg_data, 
+        size_t jpeg_size,
+        int target_width,
+        int target_height,
+        jpeg_pixel_format_t output_format,
+        jpeg_rotate_t rotate
+    ) {
+        DecodeResult result;
+        uint8_t* outbuf = nullptr;
         int outbuf_size = 0;
-        err = jpeg_dec_get_outbuf_len(jpeg_dec, &outbuf_size);
-        if (err != JPEG_ERR_OK || outbuf_size == 0) {
-            jpeg_dec_close(jpeg_dec);
+        jpeg_dec_config_t config = make_decode_config(target_width, target_height, output_format, rotate);
+        jpeg_dec_err_t err = getInstance().decode_cached(&config, jpeg_data, jpeg_size, &outbuf, &outbuf_size, &result.width, &result.height);
+        if (err != JPEG_DEC_OK) {
             result.success = false;
-            result.error_message = "Failed to get output buffer size: " + std::to_string(err);
+            result.error_message = DecodeErrorName(err);
             return result;
         }
-        
-        /*分配输出缓冲区 (16字节对齐)*/
-        uint8_t* outbuf = (uint8_t*)heap_caps_aligned_alloc(16, outbuf_size, MALLOC_CAP_SPIRAM);
-        if (!outbuf) {
-            jpeg_dec_close(jpeg_dec);
-            result.success = false;
-            result.error_message = "Failed to allocate output buffer";
-            return result;
-        }
-        
-        io.outbuf = outbuf;
-        io.out_size = outbuf_size;
-        
-        err = jpeg_dec_process(jpeg_dec, &io);
-        jpeg_dec_close(jpeg_dec);
-        
-        if (err != JPEG_ERR_OK) {
-            free(outbuf);
-            result.success = false;
-            result.error_message = "JPEG decoding failed: " + std::to_string(err);
-            return result;
-        }
-        
-        /*设置结果*/
-        result.width = config.scale.width > 0 ? config.scale.width : info.width;
-        result.height = config.scale.height > 0 ? config.scale.height : info.height;
-        result.data = std::unique_ptr<uint8_t[]>(outbuf); /*转移所有权*/
+        result.data = std::unique_ptr<uint8_t[], HeapCapsDeleter>(outbuf); /*转移所有权*/
         result.data_size = outbuf_size;
         result.success = true;
-        
         return result;
     }
 
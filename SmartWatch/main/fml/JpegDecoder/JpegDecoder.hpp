@@ -14,52 +14,289 @@
 #include <dirent.h>
 #include <esp_log.h>
 #include "esp_heap_caps.h"
+#include <esp_timer.h>
 #include "esp_jpeg_dec.h"
 #include <sys/stat.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <freertos/event_groups.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
 #include <string>
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <ctype.h>
+#include "lvgl.h"
+#include "lvgl_private.h"
+#include "JpegFrameIndex.hpp"
+#include "JpegCachePolicy.hpp"
 
 namespace fml{
 
     class JpegDecoder
     {
-        #define EVENTGROUP_JPEG_DEC_START_BIT          (1<<0)
-        #define EVENTGROUP_JPEG_DEC_END_BIT            (1<<1)
         #define JPEGDECODER_TASK_PRIOR                 (2)
         #define JPEGDECODER_TASK_CORE                  (1)
+        #define JPEGDECODER_TASK_STACK                 (4096)
+        #define JPEGDECODER_WORKER_NUM                 (2)             /*解码任务个数，都绑定在JPEGDECODER_TASK_CORE上*/
+        #define JPEGDECODER_QUEUE_LEN                  (8)
+        #define JPEGDECODER_FRAME_RING_MAX             (4)
+        #define JPEGDECODER_FRAME_RING_DEFAULT         (2)
+        #define JPEGDECODER_RANGE_CONFIG_MAX           (8)
+        #define JPEGDECODER_CACHE_BYTES                (160*1024)      /*懒加载压缩帧缓存上限，常驻帧不计入*/
+        #define JPEGDECODER_READ_AHEAD_DEFAULT         (3)
+        #define JPEGDECODER_LOAD_MODE_DEFAULT          (JPEG_LOAD_LAZY)
+        #define JPEGDECODER_ANIM_FPS_DEFAULT           (15)
+        #define JPEGDECODER_ANIM_PLAYER_MAX            (4)
+        #define JPEGDECODER_DECODED_CACHE_MAX          (16)            /*解码结果缓存的最大项数，字节上限由SetDecodedCacheBytes设置*/
+        #define JPAK_MAGIC                             "JPAK"
+        #define JPAK_VERSION                           (3)             /*v2增加差分动画，v3增加关键帧表，v1、v2的容器仍然可以读取*/
+        #define JPAK_NAME_LEN                          (24)
+        #define JPAK_ANIM_FLAG_DELTA                   (1<<0)          /*除第一帧外的帧可以是相对上一帧的差分记录*/
+        #define JPAK_DELTA_MAGIC                       "JPDL"
+        #define JPEGDECODER_DELTA_DIRTY_MAX            (8)             /*差分解码源记录的重绘区域个数，超出时合并*/
+        #define JPEGDECODER_DELTA_CATCHUP_MAX          (6)             /*SetDeltaFrame一次最多叠加的帧数，超出时先显示追到的帧，下次调用继续*/
+        #define JPEGDECODER_DECODE_HANDLE_MAX          (2)             /*Decode按配置缓存的解码句柄个数*/
+        #define JPEG_STRIPE_MAGIC                      (0x4A535450)    /*"JSTP"，用于LVGL解码器识别条带解码源*/
+        #define JPEGDECODER_SCALE_ALIGN                (8)             /*缩放和块模式要求宽高是它的倍数*/
 
-        struct jpeg_stream {
-            jpeg_dec_config_t       config;
+        /*解码任务，配置相同的请求复用同一个解码句柄*/
+        struct jpeg_worker_t {
+            class JpegDecoder*      app;
+            TaskHandle_t            handle;
             jpeg_dec_handle_t       jpeg_dec;
-            jpeg_dec_io_t           jpeg_io;
-            jpeg_dec_header_info_t  out_info;
-            jpeg_pixel_format_t     output_type;
+            jpeg_dec_config_t       config;
+            uint32_t                dec_count;
+            uint64_t                dec_us;
         };
 
         struct jpeg_input_info_t{
-            uint8_t** jpeg_buff;
+            uint8_t** jpeg_buff;            /*压缩帧数据，NULL表示还没有读入*/
             int* jpeg_len;
+            char** jpeg_path;               /*目录模式：帧文件路径，懒加载时按需读取*/
+            uint32_t* jpeg_offset;          /*容器模式：帧数据在容器文件中的偏移*/
+            uint8_t* jpeg_key;              /*容器模式：整帧JPEG的关键帧，差分动画跳转时从最近的关键帧开始叠加*/
+            uint32_t* jpeg_last_use;        /*最近使用时间，用于LRU淘汰*/
+            uint8_t* jpeg_pinned;           /*常驻的帧，不参与淘汰*/
+            uint8_t* jpeg_busy;             /*正在被解码任务使用的帧，不参与淘汰*/
             int jpeg_number;
-            int jpeg_index;
+            uint32_t use_clock;
+            size_t cache_bytes;             /*可淘汰帧占用的字节数*/
+            size_t pinned_bytes;            /*常驻帧占用的字节数*/
+            uint32_t cache_hit;
+            uint32_t cache_miss;
+        };
+
+        /*解码结果缓存的一项，按(帧, 缩放, 格式, 旋转)区分*/
+        struct jpeg_decoded_entry_t{
+            int jpeg_index;                 /*0表示空闲*/
+            uint16_t scale_width;
+            uint16_t scale_height;
+            jpeg_pixel_format_t format;
+            jpeg_rotate_t rotate;
+            uint16_t out_width;
+            uint16_t out_height;
+            uint8_t* buff;
+            int len;
+            bool valid;                     /*false表示正在填充*/
+            int busy;                       /*正在读取或填充，不参与淘汰*/
+        };
+
+        /*Decode缓存的解码句柄，配置相同的解码复用*/
+        struct jpeg_dec_handle_cache_t{
+            jpeg_dec_handle_t       jpeg_dec;
+            jpeg_dec_config_t       config;
+            uint32_t                last_use;
         };
 
         typedef void (* JpegDecoderInputInfoCallBack_t)(void* input_info_user_data, int Number, int index);
 
         public:
-            struct jpeg_output_info_t{
-                uint8_t* jpeg_buff;
+            /*素材加载模式：启动时全部读入常驻，或者解码时按需读取并预读后续几帧*/
+            enum jpeg_load_mode_t{
+                JPEG_LOAD_PRELOAD = 0,
+                JPEG_LOAD_LAZY,
+            };
+
+            /*一段素材(坐标从1开始，闭区间)的加载策略*/
+            struct jpeg_range_config_t{
+                int start;
+                int end;
+                jpeg_load_mode_t mode;
+                int read_ahead;
+            };
+
+            /*动画循环方式*/
+            enum jpeg_loop_mode_t{
+                JPEG_LOOP_REPEAT = 0,
+                JPEG_LOOP_ONCE,
+            };
+
+            /*一个动画的帧范围(坐标从1开始，闭区间)和播放参数*/
+            struct jpeg_anim_info_t{
+                int start;
+                int end;
+                int fps;
+                jpeg_loop_mode_t loop_mode;
+                bool delta;                     /*差分编码的动画，用差分解码源播放*/
+            };
+
+            /*JPAK容器格式(小端)：头部、动画表、帧表，之后是对齐到4字节的JPEG数据，由pack_jpeg_materials.py生成*/
+            struct __attribute__((packed)) jpak_header_t{
+                char     magic[4];
+                uint16_t version;
+                uint16_t anim_number;
+                uint32_t frame_number;
+                uint32_t anim_table_offset;
+                uint32_t frame_table_offset;
+                uint32_t data_offset;
+                uint32_t pack_id;           /*v2起为容器的CRC32，与构建时生成的JpegMaterials.h对应*/
+                uint32_t key_table_offset;  /*v3起为关键帧表的偏移，每帧一个字节，非0为关键帧*/
+            };
+            struct __attribute__((packed)) jpak_anim_t{
+                char     name[JPAK_NAME_LEN];
+                uint32_t start;
+                uint32_t end;
+                uint16_t fps;
+                uint8_t  loop_mode;
+                uint8_t  flags;             /*JPAK_ANIM_FLAG_**/
+                uint8_t  reserved[4];
+            };
+            struct __attribute__((packed)) jpak_frame_t{
+                uint32_t offset;            /*相对文件开头*/
+                uint32_t length;
+            };
+            /*差分动画的帧数据：以JPEG的SOI开头的是关键帧，否则是差分记录：
+              jpak_delta_t、jpak_patch_t[patch_number]，之后是各个补丁的JPEG数据*/
+            struct __attribute__((packed)) jpak_delta_t{
+                char     magic[4];
+                uint16_t patch_number;
+                uint16_t reserved;
+            };
+            struct __attribute__((packed)) jpak_patch_t{
+                uint16_t x;                 /*补丁在帧中的位置和尺寸*/
+                uint16_t y;
+                uint16_t w;
+                uint16_t h;
+                uint32_t offset;            /*相对差分记录开头*/
+                uint32_t length;
+            };
+
+            /*解码错误码*/
+            enum jpeg_dec_err_t{
+                JPEG_DEC_OK = 0,
+                JPEG_DEC_ERR_SIGNATURE,         /*不是JPEG数据*/
+                JPEG_DEC_ERR_OPEN,              /*解码句柄创建失败*/
+                JPEG_DEC_ERR_HEADER,            /*头部解析失败*/
+                JPEG_DEC_ERR_NO_MEM,            /*输出缓冲区分配失败*/
+                JPEG_DEC_ERR_BUFFER_SMALL,      /*调用者的输出缓冲区不够大*/
+                JPEG_DEC_ERR_BUFFER_ALIGN,      /*调用者的输出缓冲区没有16字节对齐*/
+                JPEG_DEC_ERR_PROCESS,           /*解码失败*/
+            };
+
+            /*解码请求优先级，高优先级插到队列头部*/
+            enum jpeg_dec_priority_t{
+                JPEG_DEC_PRIORITY_NORMAL = 0,
+                JPEG_DEC_PRIORITY_HIGH,
+            };
+
+            struct jpeg_dec_request_t;
+            typedef void (* JpegDecDoneCallBack_t)(struct jpeg_dec_request_t* req, bool success);
+
+            /*解码请求：输入为素材帧或内存中的JPEG，dst为NULL时按输出大小从PSRAM分配(16字节对齐)，
+              结果的所有权交给回调；内存中的JPEG带dst时由Decode解码到dst，不分配内存。回调在解码任务中执行，不能直接操作LVGL*/
+            struct jpeg_dec_request_t{
+                int jpeg_index;                 /*素材帧坐标(从1开始)，为0时使用src*/
+                const uint8_t* src;
+                int src_len;
+                uint8_t* dst;
+                int dst_len;
+                int width;                      /*缩放尺寸，需要8的倍数，0为不缩放*/
+                int height;
+                jpeg_pixel_format_t format;
+                jpeg_rotate_t rotate;
+                jpeg_dec_priority_t priority;
+                JpegDecDoneCallBack_t cb;
+                void* user_data;
+                bool prefetch;                  /*只把素材帧及其预读窗口读入缓存，不解码*/
+                uint16_t out_width;             /*解码结果尺寸*/
+                uint16_t out_height;
+            };
+
+            /*解码输出环：解码只写入后台槽位，完成后才切换为前台，前台槽位始终是完整的一帧*/
+            struct jpeg_frame_ring_t{
+                uint8_t* jpeg_buff[JPEGDECODER_FRAME_RING_MAX];
                 int jpeg_len;
+                int slot_number;
+                int front;              /*前台(正在显示)槽位，-1表示还没有完成的帧*/
+                int back;               /*正在解码的槽位，-1表示没有进行中的解码*/
+                int jpeg_index;         /*前台槽位对应的jpeg坐标*/
+                int back_jpeg_index;    /*后台槽位对应的jpeg坐标*/
+                volatile bool back_success;
+                SemaphoreHandle_t done_sem;
+            };
+
+            /*条带解码源：作为lv_image的src，渲染时以块模式逐MCU行解码，直接交给LVGL在条带缓冲区中绘制，不需要整帧缓存。
+              解码流在多次绘制之间保持，局部渲染自上而下的各个条带只解码一遍*/
+            struct jpeg_stripe_src_t{
+                lv_image_dsc_t img_dsc;         /*必须是第一个成员，data指向本结构体*/
+                uint32_t magic;
+                int width;
+                int height;
+                volatile int jpeg_index;        /*要显示的帧*/
+                int stream_index;               /*解码流对应的帧，0表示没有打开的解码流*/
+                jpeg_dec_handle_t jpeg_dec;
+                jpeg_dec_io_t io;
+                uint8_t* block_buff;            /*一个MCU行的输出，优先放内部RAM*/
+                int block_len;
+                int block_h;
+                int block_y;                    /*block_buff中的块的起始行*/
+                lv_draw_buf_t draw_buf;
+                SemaphoreHandle_t mutex;        /*LVGL打开图像期间持有*/
+                struct jpeg_decoded_entry_t* cached;    /*本次绘制直接使用的解码结果缓存*/
+                struct jpeg_decoded_entry_t* filling;   /*解码流顺带填充的解码结果缓存*/
+            };
+
+            /*差分解码源：RGB565画布作为lv_image的src，关键帧整帧解码到画布，差分帧只解码变化的补丁，
+              只重绘变化的区域。画布上的帧只能向后叠加差分，回绕或者跳回时从目标帧之前最近的关键帧开始*/
+            struct jpeg_delta_src_t{
+                lv_image_dsc_t img_dsc;
+                int width;
+                int height;
+                int shown_index;                /*画布上的帧，0表示画布还没有内容；追赶受限时落后于请求的帧*/
+                jpeg_dec_handle_t jpeg_dec;
+                uint8_t* canvas;
+                uint8_t* patch_buff;            /*宽度小于画布的补丁先解码到这里*/
+                int patch_len;
+                lv_area_t dirty[JPEGDECODER_DELTA_DIRTY_MAX];   /*相对画布，InvalidateDeltaSource后清空*/
+                int dirty_number;
+            };
+
+            /*动画播放时钟：按动画的帧率计算当前应显示的帧，落后时跳过中间的帧。
+              帧号从播放开始计数，不随循环回绕，素材坐标由AnimPlayerFrameIndex换算*/
+            struct jpeg_anim_player_t{
+                const char* name;
+                struct jpeg_anim_info_t anim;
+                int64_t start_us;               /*播放起点，0表示第一次查询时开始*/
+                int64_t shown_frame;            /*最近显示的帧号，-1表示还没有显示*/
+                int64_t pending_frame;          /*正在解码的帧号，-1表示没有*/
+                uint32_t shown_count;
+                uint32_t dropped_count;
+                int64_t fps_window_us;          /*实际帧率统计窗口的起点*/
+                uint32_t fps_window_count;
+                uint32_t fps_x10;               /*最近统计窗口的实际帧率×10*/
+            };
+
+            /*Decode分配的输出缓冲区来自heap_caps，不能用delete[]或free释放*/
+            struct HeapCapsDeleter {
+                void operator()(uint8_t* p) const {heap_caps_free(p);}
             };
 
             struct DecodeResult {
                 bool success;
                 uint16_t width;
                 uint16_t height;
-                std::unique_ptr<uint8_t[]> data; 
+                std::unique_ptr<uint8_t[], HeapCapsDeleter> data; 
                 size_t data_size;
                 std::string error_message;
             };
@@ -70,22 +307,123 @@ namespace fml{
                 return instance;
             }
             
-            void Init(const char* dirpath, jpeg_pixel_format_t format, jpeg_rotate_t rotate, JpegDecoderInputInfoCallBack_t cb, void* input_info_user_data);
-            void StartJpegDec(int jpeg_index, struct jpeg_output_info_t output);
-            bool WaitJpegDec(int* jpeg_index, TickType_t xTicksToWait);
+            bool SetRangeConfig(int start, int end, jpeg_load_mode_t mode, int read_ahead);/*在Init之后、开始解码之前调用*/
+            void SetDecodedCacheBytes(size_t bytes);/*解码结果缓存的字节上限，0为关闭*/
+            void PrintCacheInfo();
+            /*两个Decode重载的对比：同一帧各解码iterations次，输出平均耗时和每次解码返回时实测占用的堆字节*/
+            void DecodeBenchmark(int jpeg_index, int width, int height, int iterations);
+            bool FindJpegAnimation(const char *descpath, const char *target, struct jpeg_anim_info_t* anim);/*容器中没有时查找描述文件*/
+            /*返回是否找到素材；失败时解码任务照常启动*/
+            bool Init(const char* path, jpeg_pixel_format_t format, jpeg_rotate_t rotate, JpegDecoderInputInfoCallBack_t cb, void* input_info_user_data);
+            /*pack为已经映射到内存的JPAK容器(如AssetPartition中的素材)，帧直接在映射的内存上解码，整个运行期间必须有效；
+              容器无效时返回false，不启动解码任务，可以再用文件路径Init*/
+            bool Init(const uint8_t* pack, size_t pack_len, jpeg_pixel_format_t format, jpeg_rotate_t rotate, JpegDecoderInputInfoCallBack_t cb, void* input_info_user_data);
+            bool SubmitJpegDec(const struct jpeg_dec_request_t* req);
+            /*输出环相关，同一个输出环只能在同一个任务中使用，不同输出环互不等待*/
+            jpeg_frame_ring_t* CreateFrameRing(int jpeg_len, int slot_number = JPEGDECODER_FRAME_RING_DEFAULT);
+            void DeleteFrameRing(jpeg_frame_ring_t* ring);
+            bool StartJpegDec(int jpeg_index, jpeg_frame_ring_t* ring);
+            uint8_t* WaitJpegDec(jpeg_frame_ring_t* ring, int* jpeg_index, TickType_t xTicksToWait);
+            /*条带解码源相关，只能在LVGL任务中调用；旋转或非RGB565输出时不支持，返回NULL*/
+            jpeg_stripe_src_t* CreateStripeSource(int width, int height);
+            void DeleteStripeSource(jpeg_stripe_src_t* stripe);
+            void SetStripeFrame(jpeg_stripe_src_t* stripe, int jpeg_index);
+            /*差分解码源相关，只能在LVGL任务中调用；旋转或非RGB565输出时不支持，返回NULL*/
+            jpeg_delta_src_t* CreateDeltaSource(int width, int height);
+            void DeleteDeltaSource(jpeg_delta_src_t* delta);
+            bool SetDeltaFrame(jpeg_delta_src_t* delta, const struct jpeg_anim_info_t* anim, int jpeg_index);
+            void InvalidateDeltaSource(jpeg_delta_src_t* delta, lv_obj_t* obj);
+            /*动画播放时钟相关，PrintCacheInfo输出各个播放器的实际帧率和丢帧数*/
+            jpeg_anim_player_t* CreateAnimPlayer(const char* name, const struct jpeg_anim_info_t* anim);
+            void DeleteAnimPlayer(jpeg_anim_player_t* player);
+            int64_t AnimPlayerDueFrame(jpeg_anim_player_t* player);
+            int AnimPlayerFrameIndex(jpeg_anim_player_t* player, int64_t frame);
+            void AnimPlayerShown(jpeg_anim_player_t* player, int64_t frame);
             static int SafeStrtoi(const char *str, int *value);/*自定义安全字符串转整数函数*/
             static bool FindJpegMaterial(const char *path, const char *target, int* start, int* end);
             static DecodeResult Decode(const uint8_t* jpeg_data, size_t jpeg_size,int target_width = 0,int target_height = 0,jpeg_pixel_format_t output_format = JPEG_PIXEL_FORMAT_RGB565_LE,jpeg_rotate_t rotate = JPEG_ROTATE_0D);
+            /*解码到调用者提供的16字节对齐的缓冲区，不分配内存；解码句柄按配置缓存复用，同一时间只有一个调用者在解码*/
+            static jpeg_dec_err_t Decode(const uint8_t* jpeg_data, size_t jpeg_size, uint8_t* outbuf, size_t outbuf_size, uint16_t* out_width, uint16_t* out_height,
+                                         int target_width = 0, int target_height = 0, jpeg_pixel_format_t output_format = JPEG_PIXEL_FORMAT_RGB565_LE, jpeg_rotate_t rotate = JPEG_ROTATE_0D);
+            static const char* DecodeErrorName(jpeg_dec_err_t err);
         private:
             const char* TAG = "JpegDecoder";
-            EventGroupHandle_t xEventGroup;
+            QueueHandle_t jpeg_queue;
+            struct jpeg_worker_t jpeg_workers[JPEGDECODER_WORKER_NUM];
+            SemaphoreHandle_t cache_mutex;              /*保护压缩帧缓存和容器文件*/
             struct jpeg_input_info_t  jpeg_input_info;
-            struct jpeg_output_info_t jpeg_output_info;
-            struct jpeg_stream jpeg_stream;
-            TaskHandle_t JpegDecTask_handle; 
-            static long get_dir_number(const char *filepath);
-            static bool get_nth_file(const char *path, int n, char* filename, int filename_len);
-            static void get_jpeg_input_info(void* input_info_user_data, JpegDecoderInputInfoCallBack_t cb, const char* TAG, const char *dirpath, struct jpeg_input_info_t* jpeg_input_info);
+            jpeg_pixel_format_t default_format;         /*输出环使用的解码配置*/
+            jpeg_rotate_t default_rotate;
+            struct jpeg_range_config_t range_config[JPEGDECODER_RANGE_CONFIG_MAX];
+            int range_config_number;
+            FILE* pack_file;                            /*容器模式下一直打开，持有cache_mutex时读取*/
+            const uint8_t* pack_map;                    /*映射模式：容器在内存中，帧缓存直接指向它，不读入也不淘汰*/
+            bool pack_known;                            /*容器就是构建时校验过的那个，帧信息直接取JPEG_MATERIALS_FRAMES*/
+            struct jpak_anim_t* pack_anims;
+            int pack_anim_number;
+            lv_image_decoder_t* stripe_decoder;
+            uint32_t stripe_block_count;                /*条带解码统计*/
+            uint64_t stripe_block_us;
+            uint32_t stripe_restart_count;
+            uint32_t delta_frame_count;                 /*差分解码统计*/
+            uint32_t delta_key_count;
+            uint32_t delta_lag_count;                   /*叠加帧数超过JPEGDECODER_DELTA_CATCHUP_MAX、先显示了落后帧的次数*/
+            uint64_t delta_us;
+            uint64_t delta_px;
+            jpeg_anim_player_t* anim_players[JPEGDECODER_ANIM_PLAYER_MAX];
+            SemaphoreHandle_t decoded_mutex;
+            struct jpeg_decoded_entry_t decoded_cache[JPEGDECODER_DECODED_CACHE_MAX];
+            size_t decoded_cache_budget;
+            size_t decoded_cache_bytes;
+            uint32_t decoded_hit;
+            uint32_t decoded_miss;
+            int range_last_index[JPEGDECODER_RANGE_CONFIG_MAX + 1];  /*各段素材最近播放的帧，最后一项为未配置的帧*/
+            SemaphoreHandle_t decode_mutex;             /*Decode不依赖Init，在构造时创建*/
+            struct jpeg_dec_handle_cache_t decode_handles[JPEGDECODER_DECODE_HANDLE_MAX];
+            uint32_t decode_clock;
+            bool get_jpeg_input_info(void* input_info_user_data, JpegDecoderInputInfoCallBack_t cb, const char *dirpath);
+            bool get_jpeg_pack_info(void* input_info_user_data, JpegDecoderInputInfoCallBack_t cb, const char *packpath);
+            bool get_jpeg_pack_map(void* input_info_user_data, JpegDecoderInputInfoCallBack_t cb, const uint8_t* pack, size_t pack_len);
+            static bool is_known_pack(const struct jpak_header_t* header);
+            void free_input_info();/*释放帧索引和动画表并复位，Init失败和析构时调用*/
+            static uint8_t* alloc_block_buff(int len);
+            void start(jpeg_pixel_format_t format, jpeg_rotate_t rotate, int64_t start_us, size_t psram_free);
+            /*压缩帧缓存，acquire_frame/release_frame/read_ahead内部加锁，其余在持有cache_mutex时调用*/
+            struct jpeg_range_config_t get_range_config(int jpeg_index);
+            bool load_frame(int i, bool pinned);
+            void evict_frame(int i);
+            bool evict_for(size_t need, uint32_t keep_clock);
+            uint8_t* acquire_frame(int i);
+            void release_frame(int i);
+            void read_ahead(int jpeg_index);
+            /*解码结果缓存，内部加锁。淘汰循环播放中离下一次使用最远的帧*/
+            int get_range_slot(int jpeg_index);
+            void note_played(int jpeg_index);
+            int decoded_distance(int jpeg_index);
+            struct jpeg_decoded_entry_t* acquire_decoded(const struct jpeg_decoded_entry_t* key);
+            struct jpeg_decoded_entry_t* admit_decoded(const struct jpeg_decoded_entry_t* key, int len);
+            void release_decoded(struct jpeg_decoded_entry_t* entry, bool filled);
+            /*用给定的解码句柄解码，配置变化时才重新创建句柄。*dst为NULL时按输出大小从PSRAM分配(16字节对齐)，失败时释放*/
+            static jpeg_dec_err_t decode_with(jpeg_dec_handle_t* jpeg_dec, jpeg_dec_config_t* handle_config, const jpeg_dec_config_t* config,
+                                              const uint8_t* src, size_t src_len, uint8_t** dst, int* dst_len, uint16_t* out_width, uint16_t* out_height, int* out_len);
+            static jpeg_dec_config_t make_decode_config(int target_width, int target_height, jpeg_pixel_format_t output_format, jpeg_rotate_t rotate);
+            jpeg_dec_err_t decode_cached(const jpeg_dec_config_t* config, const uint8_t* src, size_t src_len, uint8_t** dst, int* dst_len, uint16_t* out_width, uint16_t* out_height);
+            bool decode(struct jpeg_worker_t* worker, struct jpeg_dec_request_t* req);
+            static void ring_done_cb(struct jpeg_dec_request_t* req, bool success);
+            /*条带解码流，持有stripe->mutex时调用*/
+            bool stripe_restart(jpeg_stripe_src_t* stripe);
+            bool stripe_next_block(jpeg_stripe_src_t* stripe);
+            void stripe_close(jpeg_stripe_src_t* stripe);
+            /*差分解码源*/
+            bool delta_decode(jpeg_delta_src_t* delta, const uint8_t* src, int len, int x, int y, int w, int h);
+            bool delta_apply(jpeg_delta_src_t* delta, int jpeg_index);
+            int delta_seek_key(const struct jpeg_anim_info_t* anim, int jpeg_index);
+            void delta_mark_dirty(jpeg_delta_src_t* delta, int x, int y, int w, int h);
+            /*LVGL图像解码器回调*/
+            static lv_result_t stripe_decoder_info(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc, lv_image_header_t* header);
+            static lv_result_t stripe_decoder_open(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc);
+            static lv_result_t stripe_decoder_get_area(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc, const lv_area_t* full_area, lv_area_t* decoded_area);
+            static void stripe_decoder_close(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc);
             static void JpegDecTask(void * arg);
             /*私有构造函数，禁止外部直接实例化*/
             JpegDecoder();
@@ -0,0 +1,63 @@
+/**
+ * @file JpegFrameIndex.hpp
+ * @author 李威延
+ * @brief 帧目录的文件排序：只依赖POSIX目录接口，主机测试(host_test/frame_index)直接包含
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace fml{
+
+    namespace jpeg_frame_index{
+
+        /*取文件名(不含扩展名)中最后一段数字作为帧序号*/
+        inline bool get_frame_number(const char *filename, long* value)
+        {
+            const char* end = strrchr(filename, '.');
+            if(end == NULL)end = filename + strlen(filename);
+            const char* p = end;
+            while(p > filename && isdigit((unsigned char)p[-1]))p--;
+            if(p == end)return false;
+            *value = strtol(p, NULL, 10);
+            return true;
+        }
+
+        /*有序号的文件按序号排在前面，其余按字典序，帧顺序与readdir返回的顺序无关*/
+        inline bool frame_name_less(const std::string& a, const std::string& b)
+        {
+            long na, nb;
+            bool ha = get_frame_number(a.c_str(), &na);
+            bool hb = get_frame_number(b.c_str(), &nb);
+            if(ha != hb)return ha;
+            if(ha && na != nb)return na < nb;
+            return a < b;
+        }
+
+        /*只遍历一次目录，不进入子目录，结果按frame_name_less排序*/
+        inline bool scan_dir(const char *path, std::vector<std::string>& filenames)
+        {
+            DIR *dir = opendir(path);
+            if(dir == NULL)return false;
+            struct dirent *entry;
+            while((entry = readdir(dir)) != NULL){
+                if(entry->d_type == DT_DIR)continue;
+                if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)continue;
+                filenames.push_back(entry->d_name);
+            }
+            closedir(dir);
+            std::sort(filenames.begin(), filenames.end(), frame_name_less);
+            return true;
+        }
+    }
+}
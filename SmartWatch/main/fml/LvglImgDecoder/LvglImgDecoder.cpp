@@ -0,0 +1,228 @@
+/**
+ * @file LvglImgDecoder.cpp
+ * @author 李威延
+ * @brief
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "LvglImgDecoder.hpp"
+
+namespace fml{
+
+    LvglImgDecoder::LvglImgDecoder()
+    {
+        decoder = NULL;
+        mutex = xSemaphoreCreateMutex();
+        memset(entries, 0, sizeof(entries));
+        cache_bytes = 0;
+        cache_budget = 0;
+        use_clock = 0;
+        hit_count = 0;
+        miss_count = 0;
+        expand_count = 0;
+        expand_us = 0;
+        expand_max_us = 0;
+    }
+
+    LvglImgDecoder::~LvglImgDecoder()
+    {
+        if(decoder != NULL)lv_image_decoder_delete(decoder);
+        for(int i = 0; i < LVGLIMGDECODER_CACHE_MAX; i++){
+            if(entries[i].buff != NULL)heap_caps_free(entries[i].buff);
+        }
+        if(mutex != NULL)vSemaphoreDelete(mutex);
+    }
+
+    void LvglImgDecoder::Init(size_t cache_bytes)
+    {
+        cache_budget = cache_bytes;
+        if(decoder != NULL)return;
+        /*后注册的解码器先被查询，压缩图片不会再交给LVGL自带的bin解码器*/
+        decoder = lv_image_decoder_create();
+        if(decoder == NULL){
+            ESP_LOGE(TAG, "decoder create fialed");
+            return;
+        }
+        lv_image_decoder_set_info_cb(decoder, decoder_info);
+        lv_image_decoder_set_open_cb(decoder, decoder_open);
+        lv_image_decoder_set_close_cb(decoder, decoder_close);
+        decoder->name = "LvglImgRle";
+        decoder->user_data = this;
+        ESP_LOGI(TAG, "LvglImgDecoder on create, cache %dKB", (int)(cache_budget / 1024));
+    }
+
+    void LvglImgDecoder::PrintCacheInfo()
+    {
+        if(expand_count == 0)return;
+        ESP_LOGI(TAG, "cache: %dKB/%dKB, hit %u, miss %u, expand avg %uus, max %uus",
+                (int)(cache_bytes / 1024), (int)(cache_budget / 1024), (unsigned)hit_count, (unsigned)miss_count,
+                (unsigned)(expand_us / expand_count), (unsigned)expand_max_us);
+    }
+
+    bool LvglImgDecoder::rle_expand(const uint8_t* in, uint32_t in_len, uint8_t* out, uint32_t out_len, uint32_t blk_size)
+    {
+        /*与lv_rle_decompress相同的格式，LVGL没有打开LV_USE_RLE*/
+        const uint8_t* in_end = in + in_len;
+        uint8_t* out_end = out + out_len;
+        while(in < in_end){
+            uint8_t ctrl = *in++;
+            if(ctrl & 0x80){
+                uint32_t n = (ctrl & 0x7f) * blk_size;
+                if(n > (uint32_t)(in_end - in) || n > (uint32_t)(out_end - out))return false;
+                memcpy(out, in, n);
+                in += n;
+                out += n;
+            }else{
+                if(blk_size > (uint32_t)(in_end - in) || ctrl * blk_size > (uint32_t)(out_end - out))return false;
+                if(blk_size == 2){
+                    /*RGB565按像素填充*/
+                    uint16_t px;
+                    memcpy(&px, in, 2);
+                    for(uint32_t i = 0; i < ctrl; i++, out += 2)memcpy(out, &px, 2);
+                }else{
+                    for(uint32_t i = 0; i < ctrl; i++, out += blk_size)memcpy(out, in, blk_size);
+                }
+                in += blk_size;
+            }
+        }
+        return out == out_end;
+    }
+
+    void LvglImgDecoder::evict(size_t need)
+    {
+        /*淘汰最久没有使用且没有被引用的项，直到放得下need字节*/
+        while(cache_bytes + need > cache_budget){
+            img_cache_entry_t* victim = NULL;
+            for(int i = 0; i < LVGLIMGDECODER_CACHE_MAX; i++){
+                img_cache_entry_t* entry = &entries[i];
+                if(entry->src == NULL || entry->ref != 0)continue;
+                if(victim == NULL || (int32_t)(entry->last_use - victim->last_use) < 0)victim = entry;
+            }
+            if(victim == NULL)return;
+            cache_bytes -= victim->len;
+            heap_caps_free(victim->buff);
+            memset(victim, 0, sizeof(img_cache_entry_t));
+        }
+    }
+
+    LvglImgDecoder::img_cache_entry_t* LvglImgDecoder::acquire(const lv_image_dsc_t* src)
+    {
+        img_cache_entry_t* entry = NULL;
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        for(int i = 0; i < LVGLIMGDECODER_CACHE_MAX; i++){
+            if(entries[i].src == src){
+                entry = &entries[i];
+                break;
+            }
+        }
+        if(entry != NULL){
+            hit_count++;
+            entry->ref++;
+            entry->last_use = ++use_clock;
+            xSemaphoreGive(mutex);
+            return entry;
+        }
+        miss_count++;
+
+        img_compressed_header_t head;
+        memcpy(&head, src->data, LVGLIMGDECODER_HEADER_LEN);
+        uint32_t len = head.decompressed_size;
+        /*超出预算时仍然解压，正在绘制的图片必须有像素可用，下一次淘汰时再回到预算内*/
+        evict(len);
+        for(int i = 0; i < LVGLIMGDECODER_CACHE_MAX; i++){
+            if(entries[i].src == NULL){
+                entry = &entries[i];
+                break;
+            }
+        }
+        if(entry == NULL){
+            xSemaphoreGive(mutex);
+            ESP_LOGW(TAG, "cache entries full");
+            return NULL;
+        }
+        uint8_t* buff = (uint8_t*)heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, len, MALLOC_CAP_SPIRAM);
+        if(buff == NULL){
+            xSemaphoreGive(mutex);
+            ESP_LOGE(TAG, "expand buffer alloc fialed, %u bytes", (unsigned)len);
+            return NULL;
+        }
+        int64_t start_us = esp_timer_get_time();
+        uint32_t blk_size = (lv_color_format_get_bpp((lv_color_format_t)src->header.cf) + 7) >> 3;
+        if(rle_expand(src->data + LVGLIMGDECODER_HEADER_LEN, head.compressed_size, buff, len, blk_size) != true){
+            xSemaphoreGive(mutex);
+            heap_caps_free(buff);
+            ESP_LOGE(TAG, "rle expand fialed");
+            return NULL;
+        }
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start_us);
+        expand_count++;
+        expand_us += us;
+        if(us > expand_max_us)expand_max_us = us;
+
+        entry->src = src;
+        entry->buff = buff;
+        entry->len = len;
+        entry->ref = 1;
+        entry->last_use = ++use_clock;
+        /*解压后的像素作为普通的未压缩图片交给LVGL*/
+        lv_draw_buf_t* decoded = &entry->draw_buf;
+        decoded->header = src->header;
+        decoded->header.flags &= ~LV_IMAGE_FLAGS_COMPRESSED;
+        decoded->data = buff;
+        decoded->unaligned_data = buff;
+        decoded->data_size = len;
+        cache_bytes += len;
+        xSemaphoreGive(mutex);
+        ESP_LOGI(TAG, "expand %ux%u: %u -> %u bytes in %uus", (unsigned)src->header.w, (unsigned)src->header.h,
+                (unsigned)src->data_size, (unsigned)len, (unsigned)us);
+        return entry;
+    }
+
+    void LvglImgDecoder::release(img_cache_entry_t* entry)
+    {
+        if(entry == NULL)return;
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        if(entry->ref > 0)entry->ref--;
+        xSemaphoreGive(mutex);
+    }
+
+    lv_result_t LvglImgDecoder::decoder_info(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc, lv_image_header_t* header)
+    {
+        if(dsc->src_type != LV_IMAGE_SRC_VARIABLE)return LV_RESULT_INVALID;
+        const lv_image_dsc_t* img_dsc = (const lv_image_dsc_t*)dsc->src;
+        if((img_dsc->header.flags & LV_IMAGE_FLAGS_COMPRESSED) == 0)return LV_RESULT_INVALID;
+        /*带调色板的格式交给bin解码器*/
+        if(LV_COLOR_FORMAT_IS_INDEXED(img_dsc->header.cf))return LV_RESULT_INVALID;
+        if(img_dsc->data_size <= LVGLIMGDECODER_HEADER_LEN)return LV_RESULT_INVALID;
+        img_compressed_header_t head;
+        memcpy(&head, img_dsc->data, LVGLIMGDECODER_HEADER_LEN);
+        if((head.method & 0xf) != LV_IMAGE_COMPRESS_RLE)return LV_RESULT_INVALID;
+        if(head.compressed_size != img_dsc->data_size - LVGLIMGDECODER_HEADER_LEN)return LV_RESULT_INVALID;
+        if(head.decompressed_size != (uint32_t)img_dsc->header.stride * img_dsc->header.h)return LV_RESULT_INVALID;
+        *header = img_dsc->header;
+        return LV_RESULT_OK;
+    }
+
+    lv_result_t LvglImgDecoder::decoder_open(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc)
+    {
+        LvglImgDecoder* app = (LvglImgDecoder*)decoder->user_data;
+        img_cache_entry_t* entry = app->acquire((const lv_image_dsc_t*)dsc->src);
+        if(entry == NULL)return LV_RESULT_INVALID;
+        /*缓存项中的draw_buf只读，可以被并行的绘制单元同时使用*/
+        dsc->user_data = entry;
+        dsc->decoded = &entry->draw_buf;
+        return LV_RESULT_OK;
+    }
+
+    void LvglImgDecoder::decoder_close(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc)
+    {
+        LvglImgDecoder* app = (LvglImgDecoder*)decoder->user_data;
+        /*draw_buf属于缓存项，不释放*/
+        dsc->decoded = NULL;
+        app->release((img_cache_entry_t*)dsc->user_data);
+        dsc->user_data = NULL;
+    }
+}
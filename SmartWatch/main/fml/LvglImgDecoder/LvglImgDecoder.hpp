@@ -0,0 +1,86 @@
+/**
+ * @file LvglImgDecoder.hpp
+ * @author 李威延
+ * @brief 压缩的LVGL C数组图片解码器：第一次绘制时解压到PSRAM，之后直接使用缓存的像素
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#include <string.h>
+#include <esp_log.h>
+#include "esp_heap_caps.h"
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "lvgl.h"
+#include "lvgl_private.h"
+
+namespace fml{
+
+    class LvglImgDecoder
+    {
+        #define LVGLIMGDECODER_CACHE_MAX               (8)             /*解压结果缓存的最大项数，字节上限由Init设置*/
+        #define LVGLIMGDECODER_HEADER_LEN              (12)            /*压缩数据前面的lv_image_compressed_t头*/
+
+        /*与LVGL的lv_image_compressed_t布局一致，由process_lvgl_img/compress_lvgl_img.py生成*/
+        struct img_compressed_header_t{
+            uint32_t method;                /*低4位为压缩方式*/
+            uint32_t compressed_size;
+            uint32_t decompressed_size;
+        };
+
+        /*一张图片解压后的像素，绘制期间被引用的项不参与淘汰*/
+        struct img_cache_entry_t{
+            const lv_image_dsc_t* src;
+            uint8_t* buff;
+            uint32_t len;
+            lv_draw_buf_t draw_buf;
+            uint32_t ref;
+            uint32_t last_use;
+        };
+
+        private:
+            const char* TAG = "LvglImgDecoder";
+            lv_image_decoder_t* decoder;
+            SemaphoreHandle_t mutex;
+            img_cache_entry_t entries[LVGLIMGDECODER_CACHE_MAX];
+            size_t cache_bytes;
+            size_t cache_budget;
+            uint32_t use_clock;
+            uint32_t hit_count;
+            uint32_t miss_count;
+            uint32_t expand_count;
+            uint64_t expand_us;
+            uint32_t expand_max_us;
+
+            /*私有构造函数，禁止外部直接实例化*/
+            LvglImgDecoder();
+            ~LvglImgDecoder();
+            /*禁止拷贝构造和赋值操作*/
+            LvglImgDecoder(const LvglImgDecoder&) = delete;
+            LvglImgDecoder& operator = (const LvglImgDecoder&) = delete;
+
+            static bool rle_expand(const uint8_t* in, uint32_t in_len, uint8_t* out, uint32_t out_len, uint32_t blk_size);
+            img_cache_entry_t* acquire(const lv_image_dsc_t* src);
+            void release(img_cache_entry_t* entry);
+            void evict(size_t need);
+
+            static lv_result_t decoder_info(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc, lv_image_header_t* header);
+            static lv_result_t decoder_open(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc);
+            static void decoder_close(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc);
+
+        public:
+            /*获取单例实例的静态方法*/
+            inline static LvglImgDecoder& getInstance() {
+                static LvglImgDecoder instance;
+                return instance;
+            }
+
+            /*在LVGL初始化之后、持有LVGL锁时调用，cache_bytes为解压结果占用PSRAM的上限*/
+            void Init(size_t cache_bytes);
+            void PrintCacheInfo();
+    };
+}
@@ -14,5 +14,8 @@
 #include "SpeechRecongnition.hpp"
 #include "TextToSpeech.hpp"
 #include "BigModel.hpp"
+#include "LvglImgDecoder.hpp"
+#include "GlyphFont.hpp"
+#include "AssetPartition.hpp"
 
 
@@ -11,7 +11,12 @@
 #pragma once
 #define LGFX_USE_V1
 #include <LovyanGFX.hpp>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
+#include <esp_log.h>
 #include "hdl_config.hpp"
+#include "te_window.hpp"
 
 namespace hdl{
 
@@ -36,7 +41,7 @@ namespace hdl{
                     /*随着ESP-IDF版本的升级，vspi_host， hspi_host的描述将不再推荐，所以如果出现错误，请用spi2_host，请使用spi3_host。SPI模式（0~3）*/
                     cfg.spi_mode = 3;
                     /*发射时SPI时钟（高达80mhz，舍入80mhz除以整数）*/
-                    cfg.freq_write = 80 * 1000 * 1000;
+                    cfg.freq_write = DISPLAY_SPI_WRITE_FREQ;
                     /*接收SPI时钟*/
                     cfg.freq_read  = 16000000;
                     /*如果通过MOSI引脚接收，则设置true*/
@@ -152,13 +157,119 @@ namespace hdl{
             /*禁止拷贝构造和赋值操作*/
             disp(const disp&) = delete;
             disp& operator = (const disp&) = delete;
+
+#if DISPLAY_TE_SYNC_ENABLE
+            inline static SemaphoreHandle_t _te_sem = NULL;         /*每个TE上升沿(消隐期开始)释放一次*/
+            inline static volatile int64_t _te_last_us = 0;         /*最近一次TE上升沿的时间*/
+            inline static SemaphoreHandle_t _te_wait_sem = NULL;    /*小区域避让光栅时由单次定时器释放*/
+            inline static esp_timer_handle_t _te_wait_timer = NULL;
+
+            inline static void IRAM_ATTR _te_isr(void* arg)
+            {
+                BaseType_t woken = pdFALSE;
+                _te_last_us = esp_timer_get_time();
+                xSemaphoreGiveFromISR(_te_sem, &woken);
+                if(woken == pdTRUE)portYIELD_FROM_ISR();
+            }
+
+            inline static void _te_wait_cb(void* arg)
+            {
+                xSemaphoreGive(_te_wait_sem);
+            }
+
+            /*等待下一次消隐期开始*/
+            inline static void _te_wait_blank()
+            {
+                xSemaphoreTake(_te_sem, 0);
+                xSemaphoreTake(_te_sem, pdMS_TO_TICKS(DISPLAY_TE_PERIOD_US * 2 / 1000) + 1);
+            }
+#endif
         public:
             lgfx::touch_point_t     _tpp;
 
+            /*显示方向(顺时针)*/
+            enum orientation_t{
+                ORIENTATION_0 = 0,
+                ORIENTATION_90,
+                ORIENTATION_180,
+                ORIENTATION_270,
+            };
+
             /*获取单例实例的静态方法*/
             inline static disp& getInstance() {
                 static disp instance;
                 return instance;
             }
+
+            /**
+             * @brief 设置显示方向，通过面板MADCTL寄存器改变GRAM的写入方向，不做逐像素处理
+             * @param rotation 旋转方向
+             * @param mirror true:在旋转的基础上上下镜像
+             */
+            inline void set_orientation(orientation_t rotation, bool mirror = false)
+            {
+                setRotation((uint_fast8_t)rotation | (mirror ? 4 : 0));
+            }
+
+#if DISPLAY_TE_SYNC_ENABLE
+            /*打开面板TE输出并开始跟踪消隐期，面板每次重新初始化后都要调用*/
+            inline void te_init()
+            {
+                if(_te_sem == NULL){
+                    _te_sem = xSemaphoreCreateBinary();
+                    _te_wait_sem = xSemaphoreCreateBinary();
+                    gpio_config_t io_conf = {};
+                    io_conf.pin_bit_mask = 1ULL << DISPLAY_TE;
+                    io_conf.mode = GPIO_MODE_INPUT;
+                    io_conf.intr_type = GPIO_INTR_POSEDGE;
+                    gpio_config(&io_conf);
+                    /*其他模块可能已安装ISR服务*/
+                    esp_err_t err = gpio_install_isr_service(0);
+                    if((err != ESP_OK) && (err != ESP_ERR_INVALID_STATE))ESP_LOGE("disp", "install isr service fialed:%d", err);
+                    gpio_isr_handler_add(DISPLAY_TE, _te_isr, NULL);
+                    /*FreeRTOS节拍是10ms，不到一帧的等待用单次定时器唤醒*/
+                    const esp_timer_create_args_t te_wait_timer_args = {
+                            .callback = &_te_wait_cb,
+                            .arg = NULL,
+                            .dispatch_method = ESP_TIMER_TASK,
+                            .name = "disp_te_wait",
+                            .skip_unhandled_events = true
+                        };
+                    ESP_ERROR_CHECK(esp_timer_create(&te_wait_timer_args, &_te_wait_timer));
+                }
+                /*TEON(0x35)，参数0：只在垂直消隐期输出TE*/
+                startWrite();
+                writeCommand(0x35);
+                writeData(0x00);
+                endWrite();
+            }
+
+            /**
+             * @brief 写入面板区域前调用，保证写入不会跨越正在扫描的行，等待期间让出CPU
+             *        大区域等待下一次消隐期开始再写，写入速度快于扫描，始终领先光栅；
+             *        小区域只在光栅不会扫过该区域时写入，否则等光栅扫过区域末行
+             * @param y1,y2 区域起止行(显示坐标)
+             * @param w 区域宽度
+             */
+            inline void te_sync(int32_t y1, int32_t y2, int32_t w)
+            {
+                int32_t lines = y2 - y1 + 1;
+                /*扫描行估算只适用于默认方向，其他方向一律等待消隐期*/
+                if((lines > DISPLAY_TE_SMALL_AREA_LINES) || (getRotation() != 0)){
+                    _te_wait_blank();
+                    return;
+                }
+                int line = te_window::scanline(esp_timer_get_time() - _te_last_us, DISPLAY_TE_PERIOD_US, DISPLAY_TE_SCAN_LINES);
+                int write_lines = te_window::write_lines(w, lines, DISPLAY_SPI_WRITE_FREQ, DISPLAY_TE_PERIOD_US, DISPLAY_TE_SCAN_LINES);
+                int64_t wait_us = te_window::wait_us(line, y1 + DISPLAY_OFFSET_Y, y2 + DISPLAY_OFFSET_Y, write_lines, DISPLAY_TE_PERIOD_US, DISPLAY_TE_SCAN_LINES);
+                if(wait_us < 0){
+                    _te_wait_blank();
+                }else if(wait_us > 0){
+                    xSemaphoreTake(_te_wait_sem, 0);
+                    esp_timer_start_once(_te_wait_timer, wait_us);
+                    if(xSemaphoreTake(_te_wait_sem, pdMS_TO_TICKS(DISPLAY_TE_PERIOD_US * 2 / 1000) + 1) != pdTRUE)esp_timer_stop(_te_wait_timer);
+                }
+            }
+#endif
     };
 }
\ No newline at end of file
@@ -0,0 +1,48 @@
+/**
+ * @file te_window.hpp
+ * @author 李威延
+ * @brief TE同步的写入窗口计算：只由时间和行号计算，不访问硬件，主机测试(host_test/te_window)直接包含
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#include <stdint.h>
+
+namespace hdl{
+
+    namespace te_window{
+
+        /*距上次TE上升沿elapsed_us时面板扫描到的行，TE上升沿时为第0行*/
+        inline int scanline(int64_t elapsed_us, int period_us, int scan_lines)
+        {
+            if(elapsed_us < 0)elapsed_us = 0;
+            return (int)((elapsed_us % period_us) * scan_lines / period_us);
+        }
+
+        /*写入w*lines个像素(每像素16bit)期间光栅走过的行数，多算一行作为余量*/
+        inline int write_lines(int32_t w, int32_t lines, int64_t write_freq, int period_us, int scan_lines)
+        {
+            int64_t write_us = (int64_t)w * lines * 16 * 1000000 / write_freq;
+            return (int)(write_us * scan_lines / period_us) + 1;
+        }
+
+        /**
+         * @brief 光栅在line时，写入面板行[y1,y2]前还要等待多久
+         *        光栅在区域前方且写完前到不了y1，或光栅已扫过区域且写完前不会绕回y1时立即写入；
+         *        否则等光栅扫过区域末行y2
+         * @return 等待的微秒数，0为立即写入；-1表示区域太大，一帧内没有安全的窗口，应等待消隐期
+         */
+        inline int64_t wait_us(int line, int y1, int y2, int write_lines, int period_us, int scan_lines)
+        {
+            if(write_lines + (y2 - y1 + 1) >= scan_lines)return -1;
+            if((line + write_lines < y1) || ((line > y2) && (line + write_lines < scan_lines + y1)))return 0;
+            int wait_lines = (y2 + 1 - line + scan_lines) % scan_lines;
+            if(wait_lines == 0)wait_lines = scan_lines;
+            /*向上取整，醒来时光栅一定已经离开区域*/
+            return ((int64_t)wait_lines * period_us + scan_lines - 1) / scan_lines;
+        }
+    }
+}
@@ -21,6 +21,7 @@
 #include "audio.hpp"
 #include "flash.hpp"
 #include "imu.hpp"
+#include "telemetry.hpp"
 
 namespace hdl{
 
@@ -125,6 +126,19 @@ namespace hdl{
             }
 
             inline static void update(){lvgl::getInstance().update();}
+            /*LVGL锁相关*/
+            inline static void LvglLock(){lvgl::getInstance().lock();}
+            inline static void LvglUnlock(){lvgl::getInstance().unlock();}
+            inline static lv_result_t LvglAsyncCall(lv_async_cb_t async_xcb, void *user_data){return lvgl::getInstance().async_call(async_xcb, user_data);}
+            /*LVGL刷新相关*/
+            inline static uint32_t LvglTimeUntilNext(){return lvgl::getInstance().time_until_next();}
+            inline static uint32_t LvglRefrPeriod(){return lvgl::getInstance().refr_period();}
+            inline static uint32_t LvglFps(){return lvgl::getInstance().fps();}
+            /*性能遥测相关*/
+            inline static void TelemetryAppBegin(){telemetry::getInstance().app_begin();}
+            inline static void TelemetryAppEnd(){telemetry::getInstance().app_end();}
+            inline static void TelemetryCommit(){telemetry::getInstance().commit();}
+            inline static void TelemetryPrintSummary(){telemetry::getInstance().print_summary();}
             inline void isSleeping(bool sleep) { _isSleeping = sleep; }
             inline bool isSleeping(void) { return _isSleeping; } 
             /*内存相关*/
@@ -178,10 +192,24 @@ namespace hdl{
             inline static bool isCharging(){return power::getInstance().isCharging();}
             inline static void HardReset(){power::getInstance().powerReset();}
             /*屏幕相关*/
-            inline static void resetDisp(){disp::getInstance().init();}
+            inline static void resetDisp()
+            {
+                lvgl::getInstance().wait_flush();
+                disp::getInstance().init();
+#if DISPLAY_TE_SYNC_ENABLE
+                disp::getInstance().te_init();
+#endif
+            }
             inline static void setBrightness(uint8_t brightness){disp::getInstance().setBrightness(brightness);}
-            inline static void DispSleep(){disp::getInstance().sleep();}
+            inline static void DispSleep(){lvgl::getInstance().wait_flush();disp::getInstance().sleep();}
             inline static void DispWakeUp(){disp::getInstance().wakeup();}
+            inline static void setDispOrientation(disp::orientation_t rotation, bool mirror = false){lvgl::getInstance().set_orientation(rotation, mirror);}
+            /*佩戴手：同时切换IMU手势方向和显示方向，默认左手对应0度*/
+            inline static void setLeftHanded(bool left)
+            {
+                imu::getInstance().set_left_handed(left);
+                lvgl::getInstance().set_orientation(left ? disp::ORIENTATION_0 : disp::ORIENTATION_180);
+            }
             /*按键相关*/
             inline static bool isPowerKeyPressed(){return power::getInstance().isKeyPressed();}
             inline static bool isButtonKeyPressed(){return button::getInstance().pressed();}
@@ -58,6 +58,13 @@
 #define DISPLAY_BACKLIGHT_CHANNEL   0
 #define DISPLAY_BACKLIGHT_FREQ      44100
 #define DISPLAY_COLORDEPTH          (16 | 0x0100)
+#define DISPLAY_SPI_WRITE_FREQ      (80 * 1000 * 1000)  /*SPI写时钟*/
+#define DISPLAY_TE_PIN              (-1)        /*面板TE(撕裂效应)引脚号，-1为未接线；#if中不能比较GPIO_NUM_xx枚举，所以用数字*/
+#define DISPLAY_TE                  ((gpio_num_t)DISPLAY_TE_PIN)
+#define DISPLAY_TE_SYNC_ENABLE      (DISPLAY_TE_PIN >= 0)   /*接了TE引脚时刷屏与面板扫描同步；没有真实TE信号时无从知道扫描位置，不同步*/
+#define DISPLAY_TE_PERIOD_US        (16667)     /*面板帧周期(约60Hz)，用于估算扫描行*/
+#define DISPLAY_TE_SCAN_LINES       (320)       /*ST7789一帧扫描的行数(GRAM高度)*/
+#define DISPLAY_TE_SMALL_AREA_LINES (60)        /*不超过该行数的区域按扫描行避让写入，否则等待消隐期开始*/
 
 /**< Display P169H002-CTP-Touch */
 #define DISPLAY_TOUCH_AS_LISTEN_BUTTON 1
@@ -70,6 +77,27 @@
 
 /**< LVGL */
 #define LGVL_COLORDEPTH             (LV_COLOR_FORMAT_RGB565)
+#define LVGL_FLUSH_DMA_ENABLE       1           /*1:刷屏启动DMA后立即返回，传输与下一帧渲染并行; 0:同步刷屏*/
+#define LVGL_FLUSH_PRESWAP          1           /*1:刷屏前按整字批量交换字节序，以原始字节直接DMA; 0:LovyanGFX逐像素交换*/
+#define LVGL_RENDER_MODE_PARTIAL    1           /*1:局部渲染，只重绘并传输脏区域(内部RAM条带缓冲区); 0:全屏渲染(PSRAM全屏缓冲区)*/
+#define LVGL_PARTIAL_BUF_LINES      (40)        /*局部渲染时条带缓冲区的行数*/
+#define LVGL_PARTIAL_BUF_MIN_LINES  (10)        /*自动放置时内部RAM不足可缩减到的最少行数*/
+#define LVGL_BUF_PLACE_PSRAM        0           /*两个条带缓冲区都放PSRAM*/
+#define LVGL_BUF_PLACE_SRAM_SINGLE  1           /*一个放可DMA的内部RAM，另一个放PSRAM*/
+#define LVGL_BUF_PLACE_SRAM_DOUBLE  2           /*两个都放可DMA的内部RAM*/
+#define LVGL_BUF_PLACE_AUTO         3           /*按启动时内部RAM空闲量自动选择*/
+#define LVGL_BUF_PLACEMENT          LVGL_BUF_PLACE_AUTO     /*局部渲染条带缓冲区的放置策略*/
+#define LVGL_BUF_SRAM_RESERVE       (80*1024)   /*自动放置时给WiFi/音频等保留的内部RAM*/
+#define LVGL_ADAPTIVE_REFR_ENABLE   1           /*1:自适应刷新，有动画/滑动/按下时全速，静态时降到低频，有新的无效区域立即恢复全速*/
+#define LVGL_REFR_PERIOD_ACTIVE_MS  (LV_DEF_REFR_PERIOD)    /*全速时的刷新周期*/
+#define LVGL_REFR_PERIOD_IDLE_MS    (1000)      /*静态时的刷新周期*/
+#define LVGL_INDEV_PERIOD_IDLE_MS   (50)        /*静态时触摸的读取周期*/
+#define LVGL_REFR_IDLE_DELAY_MS     (500)       /*最后一次活动后保持全速的时间*/
+#define LVGL_LOOP_MAX_SLEEP_MS      (50)        /*主循环等待LVGL下一次截止时间的上限，保证按键/语音等的轮询*/
+
+/**< Telemetry */
+#define TELEMETRY_ENABLE            1           /*1:记录每次主循环的渲染/刷屏/应用耗时，串口输入telemetry输出CSV; 0:编译时移除*/
+#define TELEMETRY_RING_SIZE         (256)       /*环形缓冲区记录条数*/
 
 /**< PMIC */
 #define AXP2101_I2C_ADDR            (0x34)
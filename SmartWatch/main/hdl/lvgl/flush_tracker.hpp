@@ -0,0 +1,55 @@
+/**
+ * @file flush_tracker.hpp
+ * @author 李威延
+ * @brief 刷屏的总线占用记录：同步/DMA刷屏时startWrite、setWindow、waitDMA、endWrite的先后顺序，
+ *        Bus为disp或主机测试(host_test/flush_bus)的桩总线
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#include <stdint.h>
+
+namespace hdl{
+
+    template<class Bus>
+    class flush_tracker
+    {
+        private:
+            bool _pending = false;          /*DMA传输进行中，总线尚未释放*/
+
+        public:
+            inline bool pending() const { return _pending; }
+
+            /*占用总线并设置窗口，之后写入像素*/
+            inline void begin(Bus& bus, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+            {
+                bus.startWrite();
+                bus.setWindow(x1, y1, x2, y2);
+            }
+
+            /*同步写入已经结束，立即释放总线*/
+            inline void end(Bus& bus)
+            {
+                bus.endWrite();
+            }
+
+            /*DMA传输已经启动，总线保持占用，由wait释放*/
+            inline void end_dma()
+            {
+                _pending = true;
+            }
+
+            /*等待DMA传输完成并释放总线，没有进行中的传输时直接返回false*/
+            inline bool wait(Bus& bus)
+            {
+                if(!_pending)return false;
+                bus.waitDMA();
+                bus.endWrite();
+                _pending = false;
+                return true;
+            }
+    };
+}
@@ -12,19 +12,54 @@
 #include <esp_log.h>
 #include <lvgl.h>
 #include "disp.hpp"
+#include "telemetry.hpp"
+#include "flush_tracker.hpp"
 #include "esp_timer.h"
+#include "esp_memory_utils.h"
+#include <algorithm>
 
 namespace hdl{
 
     class lvgl
     {
         private:
+            inline static flush_tracker<disp> _flush_bus;       /*DMA传输进行中时总线尚未释放*/
+            inline static lv_indev_t *_indev = NULL;
+            inline static uint32_t _refr_period = LV_DEF_REFR_PERIOD;   /*当前刷新周期(ms)*/
+            inline static int64_t _last_active_us = 0;                  /*最后一次活动的时间*/
+            inline static uint32_t _fps = 0;
+            inline static uint32_t _fps_frames = 0;
+            inline static int64_t _fps_start_us = 0;
+
             /*私有构造函数，禁止外部直接实例化*/
             lvgl(){}
             /*禁止拷贝构造和赋值操作*/
             lvgl(const lvgl&) = delete;
             lvgl& operator = (const lvgl&) = delete;
 
+            /*把一块像素写到已设置好的窗口。
+             *LVGL按小端RGB565渲染，面板需要大端字节序：
+             *LVGL_FLUSH_PRESWAP时按32位整字批量交换后以原始字节发送(可直接DMA)，
+             *否则由LovyanGFX逐像素转换。*/
+            inline static void _disp_write_pixels(uint8_t *px_map, uint32_t len, bool use_dma)
+            {
+#if LVGL_FLUSH_PRESWAP
+                lv_draw_sw_rgb565_swap(px_map, len);
+                /*PSRAM中的缓冲区不能直接作为SPI DMA源*/
+                if(use_dma && esp_ptr_dma_capable(px_map)){
+                    disp::getInstance().writePixelsDMA((uint16_t*)px_map, len, false);
+                }else{
+                    disp::getInstance().writePixels((uint16_t*)px_map, len, false);
+                }
+#else
+                if(use_dma){
+                    disp::getInstance().writePixelsDMA((uint16_t*)px_map, len, true);
+                }else{
+                    disp::getInstance().writePixels((uint16_t*)px_map, len, true);
+                }
+#endif
+            }
+
             /*Flush the content of the internal buffer the specific area on the display
              *You can use DMA or any hardware acceleration to do this operation in the background but
              *'lv_disp_flush_ready()' has to be called when finished.*/
@@ -33,20 +68,55 @@ namespace hdl{
                 uint32_t w = (area->x2 - area->x1 + 1);
                 uint32_t h = (area->y2 - area->y1 + 1); 
 
-                disp::getInstance().startWrite();
-                disp::getInstance().setWindow(area->x1, area->y1, area->x2, area->y2);
-                disp::getInstance().pushPixels((uint16_t*)px_map, w * h, true);
-                disp::getInstance().endWrite();
+                telemetry::flush_begin();
+#if DISPLAY_TE_SYNC_ENABLE
+                disp::getInstance().te_sync(area->y1, area->y2, w);
+#endif
+                _flush_bus.begin(disp::getInstance(), area->x1, area->y1, area->x2, area->y2);
+                _disp_write_pixels(px_map, w * h, false);
+                _flush_bus.end(disp::getInstance());
+                telemetry::flush_end();
 
                 /*IMPORTANT!!!
                 *Inform the graphics library that you are ready with the flushing*/
                 lv_disp_flush_ready(drv);
             }
 
+            /*DMA刷屏：设置窗口并启动DMA传输后立即返回，不等待传输结束。
+             *双缓冲下LVGL可以在传输期间渲染下一帧到另一个缓冲区。
+             *总线在传输结束前保持占用，由_disp_flush_wait释放。*/
+            inline static void _disp_flush_dma(lv_disp_t *drv, const lv_area_t *area, uint8_t *px_map)
+            {
+                uint32_t w = (area->x2 - area->x1 + 1);
+                uint32_t h = (area->y2 - area->y1 + 1); 
+
+                telemetry::flush_begin();
+#if DISPLAY_TE_SYNC_ENABLE
+                disp::getInstance().te_sync(area->y1, area->y2, w);
+#endif
+                _flush_bus.begin(disp::getInstance(), area->x1, area->y1, area->x2, area->y2);
+                _disp_write_pixels(px_map, w * h, true);
+                _flush_bus.end_dma();
+                telemetry::flush_end();
+            }
+
+            /*LVGL需要复用正在传输的缓冲区(或刷新结束)时调用：
+             *等待DMA传输完成，释放总线，再通知LVGL刷屏完成。
+             *没有进行中的传输时直接返回，不通知LVGL，避免LVGL正在刷新时被误认为已经刷完*/
+            inline static void _disp_flush_wait(lv_disp_t *drv)
+            {
+                if(!_flush_bus.pending())return;
+                telemetry::flush_begin();
+                _flush_bus.wait(disp::getInstance());
+                telemetry::flush_end();
+                lv_disp_flush_ready(drv);
+            }
+
             /*Will be called by the library to read the touchpad*/
             inline static void _touchpad_read(lv_indev_t *indev_drv, lv_indev_data_t *data)
             {
-                if(disp::getInstance().getTouchRaw(&disp::getInstance()._tpp)){
+                /*getTouch按当前显示方向变换坐标*/
+                if(disp::getInstance().getTouch(&disp::getInstance()._tpp)){
                     data->point.x = disp::getInstance()._tpp.x;
                     data->point.y = disp::getInstance()._tpp.y;
                     data->state = LV_INDEV_STATE_PR;
@@ -75,34 +145,142 @@ namespace hdl{
                 ESP_ERROR_CHECK(esp_timer_start_periodic(lvgl_tick_timer, 1 * 1000)); //创建定时器，更新LVGL的内部时钟基准 
             }
 
+#if LVGL_RENDER_MODE_PARTIAL
+            /*按放置策略分配两个条带缓冲区，返回单个缓冲区的字节数*/
+            inline static uint32_t _alloc_stripe_buf(uint32_t line_size, void** buf1, void** buf2)
+            {
+                uint32_t lines = LVGL_PARTIAL_BUF_LINES;
+                int sram_cnt = 0;
+#if LVGL_BUF_PLACEMENT == LVGL_BUF_PLACE_SRAM_DOUBLE
+                sram_cnt = 2;
+#elif LVGL_BUF_PLACEMENT == LVGL_BUF_PLACE_SRAM_SINGLE
+                sram_cnt = 1;
+#elif LVGL_BUF_PLACEMENT == LVGL_BUF_PLACE_AUTO
+                /*以启动时可DMA内部RAM的空闲量为预算，预留LVGL_BUF_SRAM_RESERVE给其他模块*/
+                size_t free_internal = heap_caps_get_free_size(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+                size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+                size_t budget = (free_internal > LVGL_BUF_SRAM_RESERVE) ? (free_internal - LVGL_BUF_SRAM_RESERVE) : 0;
+                uint32_t fit_lines = std::min(budget / 2, largest) / line_size;
+                if(fit_lines >= LVGL_PARTIAL_BUF_MIN_LINES){
+                    /*优先双缓冲，空间不够时缩减行数*/
+                    sram_cnt = 2;
+                    lines = std::min(fit_lines, (uint32_t)LVGL_PARTIAL_BUF_LINES);
+                }else if(std::min(budget, largest) >= line_size * lines){
+                    sram_cnt = 1;
+                }
+#endif
+                uint32_t buf_size = line_size * lines;
+                void** bufs[2] = {buf1, buf2};
+                for(int i = 0; i < 2; i++){
+                    *bufs[i] = NULL;
+                    if(i < sram_cnt){
+                        *bufs[i] = heap_caps_malloc(buf_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+                        if(*bufs[i] == NULL)ESP_LOGW(getInstance().TAG, "malloc stripe buffer %d from internal RAM fialed, fall back to PSRAM", i);
+                    }
+                    /*内部RAM不足，退回PSRAM*/
+                    if(*bufs[i] == NULL)*bufs[i] = heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM);
+                }
+                ESP_LOGI(getInstance().TAG, "stripe buffer layout: policy=%d, lines=%d, size=%d, buf1=%s, buf2=%s",
+                            (int)LVGL_BUF_PLACEMENT, (int)lines, (int)buf_size,
+                            esp_ptr_internal(*buf1) ? "SRAM" : "PSRAM", esp_ptr_internal(*buf2) ? "SRAM" : "PSRAM");
+                return buf_size;
+            }
+#endif
+
             inline static void _lv_port_disp_init(uint16_t depth_size)
             {
                 static lv_display_t *disp = lv_display_create(disp::getInstance().width(),disp::getInstance().height());
                 void *buf1 = NULL;
                 void *buf2 = NULL;
 
+#if LVGL_RENDER_MODE_PARTIAL
+                /*局部渲染：LVGL合并无效区域后只传输脏区域，条带缓冲区按放置策略分配*/
+                lv_display_render_mode_t render_mode = LV_DISPLAY_RENDER_MODE_PARTIAL;
+                uint32_t buf_size = _alloc_stripe_buf(disp::getInstance().width() * depth_size, &buf1, &buf2);
+#else
+                uint32_t buf_size = disp::getInstance().width() * disp::getInstance().height() * depth_size;
+                lv_display_render_mode_t render_mode = LV_DISPLAY_RENDER_MODE_FULL;
                 //分配内存
-                buf1 = heap_caps_malloc(disp::getInstance().width() * disp::getInstance().height() * depth_size, MALLOC_CAP_SPIRAM);
-                buf2 = heap_caps_malloc(disp::getInstance().width() * disp::getInstance().height() * depth_size, MALLOC_CAP_SPIRAM);
+                buf1 = heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM);
+                buf2 = heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM);
+#endif
                 /* If failed */
                 if ((buf1 == NULL) || (buf2 == NULL)) {
-                    ESP_LOGE(getInstance().TAG, "malloc buffer from PSRAM fialed:%d,%d,%d", (int)disp::getInstance().width(), (int)disp::getInstance().height(), (int)depth_size);
+                    ESP_LOGE(getInstance().TAG, "malloc buffer fialed:%d,%d,%d", (int)disp::getInstance().width(), (int)(buf_size / disp::getInstance().width() / depth_size), (int)depth_size);
                     abort();
                 } else {
-                    ESP_LOGI(getInstance().TAG, "malloc buffer from PSRAM successful:%d,%d,%d", (int)disp::getInstance().width(), (int)disp::getInstance().height(), (int)depth_size);
-                    ESP_LOGI(getInstance().TAG, "free PSRAM: %d\r\n", heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+                    ESP_LOGI(getInstance().TAG, "malloc buffer successful:%d,%d,%d", (int)disp::getInstance().width(), (int)(buf_size / disp::getInstance().width() / depth_size), (int)depth_size);
+                    ESP_LOGI(getInstance().TAG, "free PSRAM: %d, free internal: %d\r\n", heap_caps_get_free_size(MALLOC_CAP_SPIRAM), heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
                 }
 
                 //注册
+#if LVGL_FLUSH_DMA_ENABLE
+                lv_display_set_flush_cb(disp, _disp_flush_dma);
+                lv_display_set_flush_wait_cb(disp, _disp_flush_wait);
+#else
                 lv_display_set_flush_cb(disp, _disp_flush);
-                lv_display_set_buffers(disp, buf1, buf2, disp::getInstance().width() * disp::getInstance().height() * depth_size, LV_DISPLAY_RENDER_MODE_FULL);
+#endif
+                lv_display_set_buffers(disp, buf1, buf2, buf_size, render_mode);
+                lv_display_add_event_cb(disp, _refr_ctrl_event_cb, LV_EVENT_RENDER_READY, NULL);
+#if LVGL_ADAPTIVE_REFR_ENABLE
+                lv_display_add_event_cb(disp, _refr_ctrl_event_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+#endif
+                telemetry::init(disp);
             }
 
             inline static void _lv_port_indev_init()
             {
-                static lv_indev_t *indev = lv_indev_create();
-                lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
-                lv_indev_set_read_cb(indev, _touchpad_read);
+                _indev = lv_indev_create();
+                lv_indev_set_type(_indev, LV_INDEV_TYPE_POINTER);
+                lv_indev_set_read_cb(_indev, _touchpad_read);
+            }
+
+            /*刷新控制：统计实际渲染帧率，自适应时根据活动情况切换刷新周期*/
+            inline static void _refr_ctrl_event_cb(lv_event_t *e)
+            {
+                lv_event_code_t code = lv_event_get_code(e);
+                if(code == LV_EVENT_RENDER_READY){
+                    _fps_frames++;
+                }
+#if LVGL_ADAPTIVE_REFR_ENABLE
+                else if(code == LV_EVENT_INVALIDATE_AREA){
+                    /*静态时出现新的无效区域，立即恢复全速并尽快重绘*/
+                    _last_active_us = esp_timer_get_time();
+                    if(_refr_period != LVGL_REFR_PERIOD_ACTIVE_MS){
+                        _set_refr_period(LVGL_REFR_PERIOD_ACTIVE_MS);
+                        lv_timer_ready(lv_display_get_refr_timer((lv_display_t *)lv_event_get_current_target(e)));
+                    }
+                }
+#endif
+            }
+
+#if LVGL_ADAPTIVE_REFR_ENABLE
+            inline static void _set_refr_period(uint32_t period)
+            {
+                if(period == _refr_period)return;
+                _refr_period = period;
+                lv_timer_set_period(lv_display_get_refr_timer(lv_display_get_default()), period);
+                lv_timer_set_period(lv_indev_get_read_timer(_indev), (period == LVGL_REFR_PERIOD_ACTIVE_MS) ? LVGL_REFR_PERIOD_ACTIVE_MS : LVGL_INDEV_PERIOD_IDLE_MS);
+            }
+#endif
+
+            inline static void _refr_ctrl_update()
+            {
+                int64_t now = esp_timer_get_time();
+#if LVGL_ADAPTIVE_REFR_ENABLE
+                /*动画(含tileview切换/滚动惯性)、触摸按下或正在滚动时视为活动*/
+                if((lv_anim_count_running() > 0) ||
+                   (lv_indev_get_state(_indev) == LV_INDEV_STATE_PRESSED) ||
+                   (lv_indev_get_scroll_obj(_indev) != NULL)){
+                    _last_active_us = now;
+                }
+                _set_refr_period(((now - _last_active_us) < (LVGL_REFR_IDLE_DELAY_MS * 1000)) ? LVGL_REFR_PERIOD_ACTIVE_MS : LVGL_REFR_PERIOD_IDLE_MS);
+#endif
+                if((now - _fps_start_us) >= 1000000){
+                    _fps = (uint32_t)((int64_t)_fps_frames * 1000000 / (now - _fps_start_us));
+                    _fps_frames = 0;
+                    _fps_start_us = now;
+                }
             }
         public:
             const char* TAG = "lvgl";
@@ -118,13 +296,59 @@ namespace hdl{
                 /* Display + IIC */
                 disp::getInstance().init();
                 disp::getInstance().setBrightness(200);
+#if DISPLAY_TE_SYNC_ENABLE
+                disp::getInstance().te_init();
+#endif
                 
+                /*LV_OS_FREERTOS下lv_init创建CONFIG_LV_DRAW_SW_DRAW_UNIT_CNT个"swdraw"绘制线程。ESP-IDF的xTaskCreate不绑定核心(tskNO_AFFINITY)，
+                  两个绘制线程由调度器放到空闲的核心上并行渲染，不需要修改LVGL源码。效果用telemetry的avg render对比DRAW_UNIT_CNT为1和2*/
                 lv_init();
                 _lv_port_disp_init(depth_size);
                 _lv_port_indev_init();
                 _lv_tick_init();
             }
 
-            inline static void update(){ lv_timer_handler();}
+            inline static void update()
+            {
+                telemetry::timer_begin();
+                lv_timer_handler();
+                telemetry::timer_end();
+                lv_lock();
+                _refr_ctrl_update();
+                lv_unlock();
+            }
+            /*距离LVGL下一个定时器到期的时间(ms)，主循环据此休眠*/
+            inline static uint32_t time_until_next()
+            {
+                lv_lock();
+                uint32_t ms = lv_timer_get_time_until_next();
+                lv_unlock();
+                return ms;
+            }
+            /*当前刷新周期(ms)和最近1秒实际渲染的帧率*/
+            inline static uint32_t refr_period(){ return _refr_period;}
+            inline static uint32_t fps(){ return _fps;}
+            /*LVGL锁：LV_OS_NONE时为空操作，启用OS后LVGL对象只能在持锁时访问*/
+            inline static void lock(){ lv_lock();}
+            inline static void unlock(){ lv_unlock();}
+            /*供非LVGL任务使用：持锁后把回调投递到LVGL任务中执行*/
+            inline static lv_result_t async_call(lv_async_cb_t async_xcb, void *user_data)
+            {
+                lv_lock();
+                lv_result_t res = lv_async_call(async_xcb, user_data);
+                lv_unlock();
+                return res;
+            }
+            /*设置显示方向：面板硬件旋转后LVGL按新的分辨率重新布局并整屏重绘，触摸坐标随之变换*/
+            inline static void set_orientation(disp::orientation_t rotation, bool mirror = false)
+            {
+                /*只在DMA传输进行中时等待它结束，由传输结束的路径通知LVGL*/
+                if(_flush_bus.pending())_disp_flush_wait(lv_display_get_default());
+                disp::getInstance().set_orientation(rotation, mirror);
+                lv_display_set_resolution(lv_display_get_default(), disp::getInstance().width(), disp::getInstance().height());
+                lv_obj_invalidate(lv_screen_active());
+            }
+            /*等待最后一帧DMA传输完成并释放总线，在休眠/复位屏幕等直接操作面板之前调用*/
+            inline static void wait_flush(){ _disp_flush_wait(lv_display_get_default());}
     };
 }
\ No newline at end of file
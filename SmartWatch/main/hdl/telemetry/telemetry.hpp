@@ -0,0 +1,223 @@
+/**
+ * @file telemetry.hpp
+ * @author 李威延
+ * @brief 渲染性能遥测：每次主循环记录一条，存入无锁环形缓冲区，串口输入"telemetry"回车后以CSV输出
+ * @version 0.1
+ * @date 2025-08-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "lvgl.h"
+#include "lvgl_private.h"
+#include "hdl_config.hpp"
+
+namespace hdl{
+
+#if TELEMETRY_ENABLE
+    class telemetry
+    {
+        public:
+            /*一次主循环的记录，没有重绘的循环帧相关字段为0*/
+            struct record_t{
+                uint32_t time_ms;           /*记录时间*/
+                uint32_t timer_us;          /*lv_timer_handler耗时(含渲染和刷屏)*/
+                uint32_t app_us;            /*mc.update耗时*/
+                uint32_t render_us;         /*渲染耗时(刷新耗时减去刷屏耗时)*/
+                uint32_t flush_us;          /*刷屏耗时(flush_cb和等待DMA)*/
+                uint32_t inv_px;            /*合并后的无效区域像素数*/
+                uint16_t inv_areas;         /*合并后的无效区域个数*/
+                uint16_t draw_tasks;        /*本帧创建的绘制任务数*/
+            };
+
+        private:
+            /*只有LVGL任务(主循环)写入，控制台任务读取*/
+            inline static record_t _ring[TELEMETRY_RING_SIZE];
+            inline static std::atomic<uint32_t> _head{0};           /*已写入的记录总数*/
+            inline static record_t _cur = {};                       /*正在统计的记录*/
+            inline static int64_t _refr_start_us = 0;
+            inline static int64_t _flush_start_us = 0;
+            inline static int64_t _timer_start_us = 0;
+            inline static int64_t _app_start_us = 0;
+
+            /*私有构造函数，禁止外部直接实例化*/
+            telemetry(){}
+            /*禁止拷贝构造和赋值操作*/
+            telemetry(const telemetry&) = delete;
+            telemetry& operator = (const telemetry&) = delete;
+
+            /*只统计不领取任务的绘制单元，用于计数每帧的绘制任务*/
+            inline static int32_t _draw_unit_evaluate_cb(lv_draw_unit_t *draw_unit, lv_draw_task_t *task)
+            {
+                _cur.draw_tasks++;
+                return 0;
+            }
+            inline static int32_t _draw_unit_dispatch_cb(lv_draw_unit_t *draw_unit, lv_layer_t *layer)
+            {
+                return LV_DRAW_UNIT_IDLE;
+            }
+
+            inline static void _disp_event_cb(lv_event_t *e)
+            {
+                switch(lv_event_get_code(e)){
+                    case LV_EVENT_REFR_START:
+                        _refr_start_us = esp_timer_get_time();
+                    break;
+
+                    case LV_EVENT_RENDER_START:{
+                        /*无效区域此时已经合并*/
+                        lv_display_t *disp = (lv_display_t *)lv_event_get_current_target(e);
+                        for(uint32_t i = 0; i < disp->inv_p; i++){
+                            if(disp->inv_area_joined[i])continue;
+                            _cur.inv_areas++;
+                            _cur.inv_px += lv_area_get_size(&disp->inv_areas[i]);
+                        }
+                    }break;
+
+                    case LV_EVENT_REFR_READY:
+                        if(_cur.inv_areas != 0){
+                            int64_t refr_us = esp_timer_get_time() - _refr_start_us;
+                            _cur.render_us += (refr_us > _cur.flush_us) ? (uint32_t)(refr_us - _cur.flush_us) : 0;
+                        }
+                    break;
+
+                    default:
+                    break;
+                }
+            }
+
+            /*控制台任务：读取串口命令并输出CSV*/
+            inline static void _console_task(void *arg)
+            {
+                char line[16];
+                int len = 0;
+                while(1){
+                    int c = fgetc(stdin);
+                    if(c == EOF){
+                        /*非阻塞的控制台没有数据时返回EOF并置位文件结束标志，不清除的话之后的读取都直接返回EOF*/
+                        clearerr(stdin);
+                        vTaskDelay(pdMS_TO_TICKS(100));
+                        continue;
+                    }
+                    if((c == '\r') || (c == '\n')){
+                        line[len] = '\0';
+                        if(strcmp(line, "telemetry") == 0)dump_csv();
+                        len = 0;
+                    }else if(len < (int)sizeof(line) - 1){
+                        line[len++] = (char)c;
+                    }
+                }
+            }
+
+        public:
+            const char* TAG = "telemetry";
+
+            /*获取单例实例的静态方法*/
+            inline static telemetry& getInstance() {
+                static telemetry instance;
+                return instance;
+            }
+
+            /*在lv_init和显示器创建之后调用*/
+            inline static void init(lv_display_t *disp)
+            {
+                lv_draw_unit_t *unit = (lv_draw_unit_t *)lv_draw_create_unit(sizeof(lv_draw_unit_t));
+                unit->evaluate_cb = _draw_unit_evaluate_cb;
+                unit->dispatch_cb = _draw_unit_dispatch_cb;
+                unit->name = "telemetry";
+                lv_display_add_event_cb(disp, _disp_event_cb, LV_EVENT_REFR_START, NULL);
+                lv_display_add_event_cb(disp, _disp_event_cb, LV_EVENT_RENDER_START, NULL);
+                lv_display_add_event_cb(disp, _disp_event_cb, LV_EVENT_REFR_READY, NULL);
+                xTaskCreatePinnedToCore(_console_task, "telemetry", 3 * 1024, NULL, 1, NULL, 0);
+            }
+
+            /*主循环各阶段计时*/
+            inline static void timer_begin(){ _timer_start_us = esp_timer_get_time();}
+            inline static void timer_end(){ _cur.timer_us += (uint32_t)(esp_timer_get_time() - _timer_start_us);}
+            inline static void app_begin(){ _app_start_us = esp_timer_get_time();}
+            inline static void app_end(){ _cur.app_us += (uint32_t)(esp_timer_get_time() - _app_start_us);}
+            inline static void flush_begin(){ _flush_start_us = esp_timer_get_time();}
+            inline static void flush_end(){ _cur.flush_us += (uint32_t)(esp_timer_get_time() - _flush_start_us);}
+
+            /*主循环结束时写入一条记录*/
+            inline static void commit()
+            {
+                uint32_t head = _head.load(std::memory_order_relaxed);
+                _cur.time_ms = (uint32_t)(esp_timer_get_time() / 1000);
+                _ring[head % TELEMETRY_RING_SIZE] = _cur;
+                _head.store(head + 1, std::memory_order_release);
+                _cur = {};
+            }
+
+            /*以CSV输出环形缓冲区中的全部记录，读取期间被覆盖的记录丢弃*/
+            inline static void dump_csv()
+            {
+                uint32_t head = _head.load(std::memory_order_acquire);
+                uint32_t start = (head > TELEMETRY_RING_SIZE) ? (head - TELEMETRY_RING_SIZE) : 0;
+                printf("seq,time_ms,timer_us,app_us,render_us,flush_us,inv_px,inv_areas,draw_tasks\n");
+                for(uint32_t seq = start; seq < head; seq++){
+                    record_t r = _ring[seq % TELEMETRY_RING_SIZE];
+                    /*拷贝期间写入方可能正在覆盖该槽位*/
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if(_head.load(std::memory_order_relaxed) - seq >= TELEMETRY_RING_SIZE)continue;
+                    printf("%u,%u,%u,%u,%u,%u,%u,%u,%u\n", (unsigned)seq, (unsigned)r.time_ms, (unsigned)r.timer_us, (unsigned)r.app_us,
+                            (unsigned)r.render_us, (unsigned)r.flush_us, (unsigned)r.inv_px, (unsigned)r.inv_areas, (unsigned)r.draw_tasks);
+                }
+            }
+
+            /*打印最近记录中有重绘的帧的平均值*/
+            inline static void print_summary()
+            {
+                uint32_t head = _head.load(std::memory_order_acquire);
+                uint32_t start = (head > TELEMETRY_RING_SIZE) ? (head - TELEMETRY_RING_SIZE) : 0;
+                uint32_t frames = 0;
+                uint64_t render_us = 0, flush_us = 0, inv_px = 0, draw_tasks = 0, timer_us = 0, app_us = 0;
+                for(uint32_t seq = start; seq < head; seq++){
+                    const record_t &r = _ring[seq % TELEMETRY_RING_SIZE];
+                    timer_us += r.timer_us;
+                    app_us += r.app_us;
+                    if(r.inv_areas == 0)continue;
+                    frames++;
+                    render_us += r.render_us;
+                    flush_us += r.flush_us;
+                    inv_px += r.inv_px;
+                    draw_tasks += r.draw_tasks;
+                }
+                if((frames == 0) || (head == start))return;
+                ESP_LOGI(getInstance().TAG, "loops:%u, frames:%u, avg render:%uus, avg flush:%uus, avg inv px:%u, avg draw tasks:%u, avg timer:%uus, avg app:%uus",
+                        (unsigned)(head - start), (unsigned)frames,
+                        (unsigned)(render_us / frames), (unsigned)(flush_us / frames),
+                        (unsigned)(inv_px / frames), (unsigned)(draw_tasks / frames),
+                        (unsigned)(timer_us / (head - start)), (unsigned)(app_us / (head - start)));
+            }
+    };
+#else
+    /*关闭遥测时所有接口为空操作，由编译器完全移除*/
+    class telemetry
+    {
+        public:
+            inline static telemetry& getInstance() {
+                static telemetry instance;
+                return instance;
+            }
+            inline static void init(lv_display_t *disp){}
+            inline static void timer_begin(){}
+            inline static void timer_end(){}
+            inline static void app_begin(){}
+            inline static void app_end(){}
+            inline static void flush_begin(){}
+            inline static void flush_end(){}
+            inline static void commit(){}
+            inline static void dump_csv(){}
+            inline static void print_summary(){}
+    };
+#endif
+}
@@ -96,19 +96,30 @@ extern "C" void app_main(void)
     /*初始化驱动层*/
     fml::HdlManager::getInstance().init();
     /*初始化应用层*/
+    fml::HdlManager::getInstance().lvgl_lock();
     apl::apl::getInstance().init();
+    fml::HdlManager::getInstance().lvgl_unlock();
     
     while (1) {
+        /*LVGL锁只在访问LVGL的地方持有(lv_timer_handler自己加锁)，按键、电源、语音结果和休眠都不占用它，
+          其他任务通过lvgl_async_call把界面操作投递到这里执行*/
         fml::HdlManager::getInstance().update();
         apl::apl::getInstance().update();
-        vTaskDelay(pdMS_TO_TICKS(10));
+        /*休眠到LVGL下一次截止时间，上限LVGL_LOOP_MAX_SLEEP_MS*/
+        uint32_t sleep_ms = std::min(fml::HdlManager::getInstance().lvgl_time_until_next(), (uint32_t)LVGL_LOOP_MAX_SLEEP_MS);
+        fml::HdlManager::getInstance().telemetry_commit();
+        vTaskDelay(std::max(pdMS_TO_TICKS(sleep_ms), (TickType_t)1));
 
         /*打印信息*/
-        static int count = 0;
-        count++;
-        if(count >= 500){
-            count = 0;
+        static int64_t print_us = 0;
+        if((esp_timer_get_time() - print_us) >= 5000000){
+            print_us = esp_timer_get_time();
             CPU_PrintInfo();
+            fml::HdlManager::getInstance().telemetry_print_summary();
+            fml::JpegDecoder::getInstance().PrintCacheInfo();
+            fml::LvglImgDecoder::getInstance().PrintCacheInfo();
+            fml::GlyphFont::getInstance().PrintCacheInfo();
+            ESP_LOGI("app_main","lvgl refr period=%dms, fps=%d", (int)fml::HdlManager::getInstance().lvgl_refr_period(), (int)fml::HdlManager::getInstance().lvgl_fps());
         }
         
     }
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+把assets目录下的只读素材打包成ASTP分区镜像，在构建时由main/CMakeLists.txt调用并烧录到assets分区。
+运行时fml::AssetPartition把整个分区esp_partition_mmap进地址空间，素材直接在flash映射的内存上使用，
+不经过文件系统，也不在PSRAM中复制一份。
+
+用法:
+    python3 pack_assets.py [--max-size 1048576] [--file 名称=路径] ../assets assets.bin
+    python3 pack_assets.py --list assets.bin
+
+ASTP格式(小端，与AssetPartition.hpp中的astp_*结构体一致):
+    astp_header_t                  16字节
+    astp_entry_t[entry_number]     每个48字节，按名称升序，offset为相对镜像开头的偏移
+    素材数据                        每个按ASTP_ALIGN对齐
+素材名称是相对assets目录的路径，统一用"/"分隔。文件顺序只由名称决定，同样的输入生成的镜像逐字节相同。
+--file加入构建时生成的素材(如JpegMaterials.jpak)，与assets目录中同名的文件冲突时以它为准。
+"""
+import argparse
+import os
+import struct
+import sys
+
+ASTP_MAGIC = b"ASTP"
+ASTP_VERSION = 1
+ASTP_ALIGN = 16
+ASTP_NAME_LEN = 40
+
+HEADER = struct.Struct("<4sHHII")
+ENTRY = struct.Struct("<%dsII" % ASTP_NAME_LEN)
+
+
+def check_name(name):
+    if len(name.encode("utf-8")) >= ASTP_NAME_LEN:
+        raise ValueError("%s: name longer than %d bytes" % (name, ASTP_NAME_LEN - 1))
+
+
+def collect(root, extra):
+    files = {}
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for filename in filenames:
+            if filename.startswith("."):
+                continue
+            path = os.path.join(dirpath, filename)
+            name = os.path.relpath(path, root).replace(os.sep, "/")
+            check_name(name)
+            files[name] = path
+    for item in extra:
+        name, sep, path = item.partition("=")
+        if not sep or not name:
+            raise ValueError("--file expects name=path: %s" % item)
+        check_name(name)
+        files[name] = path
+    return sorted(files.items())
+
+
+def align(n):
+    return (n + ASTP_ALIGN - 1) // ASTP_ALIGN * ASTP_ALIGN
+
+
+def pack(root, output_path, max_size, extra):
+    files = collect(root, extra)
+    offset = align(HEADER.size + ENTRY.size * len(files))
+    table = bytearray()
+    data = bytearray(offset)
+    for name, path in files:
+        with open(path, "rb") as f:
+            content = f.read()
+        table += ENTRY.pack(name.encode("utf-8"), len(data), len(content))
+        data += content
+        data += bytes(align(len(data)) - len(data))
+    data[:HEADER.size] = HEADER.pack(ASTP_MAGIC, ASTP_VERSION, len(files), len(data), 0)
+    data[HEADER.size:HEADER.size + len(table)] = table
+    if max_size and len(data) > max_size:
+        sys.exit("assets: %d bytes do not fit in the %d byte partition" % (len(data), max_size))
+    os.makedirs(os.path.dirname(os.path.abspath(output_path)), exist_ok=True)
+    with open(output_path, "wb") as f:
+        f.write(data)
+    print("%s: %d assets, %d bytes" % (os.path.basename(output_path), len(files), len(data)))
+
+
+def dump(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, version, number, total_size, _ = HEADER.unpack_from(data, 0)
+    if magic != ASTP_MAGIC or version != ASTP_VERSION:
+        sys.exit("%s: not an ASTP v%d image" % (path, ASTP_VERSION))
+    if total_size != len(data):
+        sys.exit("%s: truncated" % path)
+    last = b""
+    for i in range(number):
+        name, offset, size = ENTRY.unpack_from(data, HEADER.size + i * ENTRY.size)
+        name = name.rstrip(b"\0")
+        if name <= last:
+            sys.exit("%s: %s out of order" % (path, name.decode("utf-8")))
+        if offset % ASTP_ALIGN != 0 or offset + size > total_size:
+            sys.exit("%s: %s out of range" % (path, name.decode("utf-8")))
+        last = name
+        print("%8d %8d  %s" % (offset, size, name.decode("utf-8")))
+    print("%s: %d assets, %d bytes" % (path, number, total_size))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack read-only assets into a memory-mappable ASTP partition image")
+    parser.add_argument("--list", action="store_true", help="print and verify an existing image")
+    parser.add_argument("--max-size", type=lambda v: int(v, 0), default=0, help="partition size in bytes")
+    parser.add_argument("--file", action="append", default=[], help="add a generated file as name=path")
+    parser.add_argument("paths", nargs="+", help="assets_dir output.bin | image.bin")
+    args = parser.parse_args()
+
+    if args.list:
+        for path in args.paths:
+            dump(path)
+        return
+    if len(args.paths) != 2:
+        parser.error("expected assets_dir output.bin")
+    pack(args.paths[0], args.paths[1], args.max_size, args.file)
+
+
+if __name__ == "__main__":
+    main()
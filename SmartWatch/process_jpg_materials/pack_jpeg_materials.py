@@ -0,0 +1,623 @@
+#!/usr/bin/env python3
+"""
+把壁纸动画的JPEG帧打包成一个JPAK容器文件，替代原来的RenameJpgFiles/OffsetRename/FixJpgSorting三个脚本。
+
+构建时由main/CMakeLists.txt调用，生成的容器放进assets分区；只需要Python3和Pillow，不依赖PowerShell。
+
+用法:
+    python3 pack_jpeg_materials.py [--cache 缓存目录] [--header JpegMaterials.h] materials.json JpegMaterials.jpak
+    python3 pack_jpeg_materials.py --list JpegMaterials.jpak
+    python3 pack_jpeg_materials.py --extract gif/4/c.gif gif/4/c_30p [--size 240x280] [--quality 90] [--step 1]
+
+materials.json:
+    {"animations": [{"name": "WatchDial", "frames": "gif/4/c_30p", "fps": 15, "loop": "repeat", "delta": true}, ...]}
+    frames目录下的*.jpg按文件名中的数字排序，帧顺序不再依赖文件系统的目录顺序。
+    也可以用"gif": "gif/4/c.gif"直接从GIF取帧(按"size"居中裁剪缩放)，"step"隔几帧取一帧，
+    不是差分动画时每帧按quality(默认GIF_QUALITY)编码成JPEG。动画在容器中的帧范围、帧率和循环方式
+    都由materials.json生成，不再手写JpegMaterialsDesc.txt。
+
+增量构建(--cache):
+    每个动画的编码结果按内容哈希缓存，哈希覆盖本脚本、materials.json中该动画的参数和全部来源文件的内容。
+    只改了一个动画的素材时其余动画直接用缓存，文件时间变化但内容没变时也不重新编码。
+
+校验和规整:
+    设备上的esp_new_jpeg只支持基线JPEG，块模式要求宽高是8的倍数，4:2:0抽样的色度数据最少、解码最快。
+    打包前检查每一帧和每个补丁：渐进式、不是4:2:0或者尺寸与动画的"size"(默认FRAME_SIZE)不一致的
+    来源帧重新编码成基线4:2:0；编码后的数据仍然不符合时打包失败。
+
+生成的头文件(--header):
+    JPEG_MATERIALS_PACK_ID与容器头部的pack_id相同，JpegDecoder据此判断设备上的容器是不是这次构建的，
+    是的话直接使用头文件中每帧的尺寸和MCU高度，不再查询和校验，块缓存按JPEG_MATERIALS_MCU_HEIGHT_MAX预先分配。
+
+取帧(--extract):
+    把GIF的帧居中裁剪缩放后存成000.jpg、001.jpg……，目录里原有的数字编号的jpg会先删除。
+
+差分动画("delta": true，需要Pillow):
+    帧按DELTA_TILE的方块与上一帧比较，只把变化的区域编码成小JPEG补丁。变化面积超过keyframe_ratio、
+    距上一个关键帧超过keyframe_interval帧或者第一帧时输出整帧的关键帧。比较的对象是设备上解码出来的
+    上一帧(补丁解码后贴回)，JPEG的误差不会在差分之间累积。JPEG帧作为来源时沿用它的量化表，
+    GIF作为来源时用quality。可选参数quality、threshold、keyframe_interval、keyframe_ratio。
+
+容器格式(小端，与JpegDecoder.hpp中的jpak_*结构体一致):
+    jpak_header_t                  32字节
+    jpak_anim_t[anim_number]       每个40字节，start/end为帧坐标(从1开始，闭区间)，flags的bit0为差分动画
+    jpak_frame_t[frame_number]     每个8字节，offset为相对文件开头的偏移
+    关键帧表(v3)                    每帧一个字节，整帧JPEG为1，差分记录为0；头部的key_table_offset指向它
+    帧数据                          每帧按JPAK_ALIGN对齐，JPEG或者差分记录
+差分记录:
+    jpak_delta_t                   8字节，"JPDL"和补丁个数
+    jpak_patch_t[patch_number]     每个16字节，x/y/w/h和相对差分记录开头的offset/length
+    补丁的JPEG数据                  按JPAK_ALIGN对齐
+"""
+import argparse
+import hashlib
+import io
+import json
+import os
+import re
+import struct
+import sys
+import zlib
+
+JPAK_MAGIC = b"JPAK"
+JPAK_VERSION = 3
+JPAK_ALIGN = 4
+JPAK_NAME_LEN = 24
+JPAK_LOOP_MODES = {"repeat": 0, "once": 1}
+JPAK_ANIM_FLAG_DELTA = 1 << 0
+JPAK_DELTA_MAGIC = b"JPDL"
+
+DELTA_TILE = 16             # 与4:2:0的MCU对齐
+DELTA_QUALITY = 90
+DELTA_THRESHOLD = 20        # 方块内任一像素任一通道的差超过它才算变化，低于它的多是JPEG噪声
+DELTA_KEYFRAME_INTERVAL = 30
+DELTA_KEYFRAME_RATIO = 0.5
+DELTA_GAP_TILES = 8         # 同一行中间隔不超过这么多方块的变化区域合并成一个补丁，省掉JPEG头
+
+FRAME_SIZE = (240, 280)     # 与屏幕一致
+GIF_QUALITY = 90
+CACHE_VERSION = 2
+BLOCK_ALIGN = 8             # 块模式和缩放要求宽高是8的倍数
+
+HEADER = struct.Struct("<4sHHIIIIII")
+ANIM = struct.Struct("<%dsIIHBB4x" % JPAK_NAME_LEN)
+FRAME = struct.Struct("<II")
+DELTA = struct.Struct("<4sHH")
+PATCH = struct.Struct("<HHHHII")
+
+
+def numeric_key(filename):
+    digits = re.findall(r"\d+", os.path.splitext(filename)[0])
+    if not digits:
+        raise ValueError("frame file name has no number: %s" % filename)
+    return (int(digits[-1]), filename)
+
+
+def list_frames(frames_dir):
+    names = [n for n in os.listdir(frames_dir) if n.lower().endswith((".jpg", ".jpeg"))]
+    if not names:
+        raise ValueError("no jpeg frames in %s" % frames_dir)
+    return [os.path.join(frames_dir, n) for n in sorted(names, key=numeric_key)]
+
+
+def check_jpeg(path, data):
+    if len(data) < 4 or data[0:2] != b"\xff\xd8":
+        raise ValueError("not a jpeg file: %s" % path)
+
+
+def jpeg_info(data):
+    """解析到第一个SOF，返回(SOF标记, 宽, 高, [(水平抽样, 垂直抽样), ...])"""
+    if data[0:2] != b"\xff\xd8":
+        raise ValueError("missing SOI")
+    i = 2
+    while i + 4 <= len(data):
+        if data[i] != 0xFF:
+            raise ValueError("bad marker at %d" % i)
+        marker = data[i + 1]
+        if marker == 0xFF:
+            i += 1
+            continue
+        if marker == 0x01 or 0xD0 <= marker <= 0xD7:
+            i += 2
+            continue
+        length = struct.unpack_from(">H", data, i + 2)[0]
+        if 0xC0 <= marker <= 0xCF and marker not in (0xC4, 0xC8, 0xCC):
+            precision, height, width, number = struct.unpack_from(">BHHB", data, i + 4)
+            if precision != 8:
+                raise ValueError("%d-bit samples" % precision)
+            sampling = [(data[i + 11 + 3 * k] >> 4, data[i + 11 + 3 * k] & 0xF) for k in range(number)]
+            return marker, width, height, sampling
+        if marker == 0xDA:
+            break
+        i += 2 + length
+    raise ValueError("no SOF marker")
+
+
+def jpeg_problem(data, size):
+    """不符合设备解码要求时返回原因，符合时返回None"""
+    try:
+        marker, width, height, sampling = jpeg_info(data)
+    except (ValueError, struct.error, IndexError) as e:
+        return "unreadable (%s)" % e
+    if marker == 0xC2:
+        return "progressive"
+    if marker != 0xC0:
+        return "SOF%d is not baseline" % (marker - 0xC0)
+    if sampling != [(2, 2), (1, 1), (1, 1)]:
+        return "subsampling %s is not 4:2:0" % sampling
+    if (width, height) != tuple(size):
+        return "%dx%d instead of %dx%d" % (width, height, size[0], size[1])
+    return None
+
+
+def mcu_height(data):
+    return 8 * max(v for _, v in jpeg_info(data)[3])
+
+
+def align(value):
+    return (value + JPAK_ALIGN - 1) & ~(JPAK_ALIGN - 1)
+
+
+def pad(data):
+    data += b"\0" * (align(len(data)) - len(data))
+
+
+def load_pillow():
+    try:
+        from PIL import Image, ImageChops, ImageOps, ImageSequence
+    except ImportError:
+        raise ValueError("delta animations need Pillow: pip install pillow")
+    return Image, ImageChops, ImageOps, ImageSequence
+
+
+def load_gif(path, size, step):
+    Image, _, ImageOps, ImageSequence = load_pillow()
+    if step < 1:
+        raise ValueError("step must be at least 1: %s" % path)
+    with Image.open(path) as gif:
+        frames = [ImageOps.fit(frame.convert("RGB"), size) for frame in ImageSequence.Iterator(gif)]
+    if not frames:
+        raise ValueError("no frames in %s" % path)
+    return frames[::step]
+
+
+def load_images(base, anim):
+    """返回RGB帧和来源JPEG的量化表(GIF来源时为None)"""
+    Image = load_pillow()[0]
+    if "gif" in anim:
+        return load_gif(os.path.join(base, anim["gif"]), tuple(anim.get("size", FRAME_SIZE)), int(anim.get("step", 1))), None
+    ImageOps = load_pillow()[2]
+    size = tuple(anim.get("size", FRAME_SIZE))
+    images = []
+    qtables = None
+    for path in list_frames(os.path.join(base, anim["frames"])):
+        with Image.open(path) as image:
+            if qtables is None:
+                qtables = image.quantization
+            image = image.convert("RGB")
+        if image.size != size:
+            print("%s: %dx%d fitted to %dx%d" % (path, image.size[0], image.size[1], size[0], size[1]))
+            image = ImageOps.fit(image, size)
+        images.append(image)
+    return images, qtables
+
+
+def encode_jpeg(image, quality, qtables):
+    out = io.BytesIO()
+    if qtables is not None:
+        image.save(out, "JPEG", qtables=qtables, subsampling="4:2:0", optimize=True)
+    else:
+        image.save(out, "JPEG", quality=quality, subsampling="4:2:0", optimize=True)
+    return out.getvalue()
+
+
+def decode_jpeg(data):
+    Image = load_pillow()[0]
+    with Image.open(io.BytesIO(data)) as image:
+        return image.convert("RGB")
+
+
+def dirty_rects(image, recon, threshold):
+    """按方块比较两帧，返回合并后的变化区域(x, y, w, h)和变化的像素数"""
+    ImageChops = load_pillow()[1]
+    r, g, b = ImageChops.difference(image, recon).split()
+    mask = ImageChops.lighter(ImageChops.lighter(r, g), b).point(lambda v: 255 if v > threshold else 0)
+    width, height = image.size
+    spans = []
+    for y in range(0, height, DELTA_TILE):
+        h = min(DELTA_TILE, height - y)
+        tiles = [mask.crop((x, y, min(x + DELTA_TILE, width), y + h)).getbbox() is not None for x in range(0, width, DELTA_TILE)]
+        row = []
+        for i, dirty in enumerate(tiles):
+            if not dirty:
+                continue
+            if row and i - row[-1][1] <= DELTA_GAP_TILES + 1:
+                row[-1][1] = i
+            else:
+                row.append([i, i])
+        for first, last in row:
+            x = first * DELTA_TILE
+            w = min((last + 1) * DELTA_TILE, width) - x
+            # 与上一行宽度相同的区域纵向合并
+            prev = spans[-1] if spans else None
+            if prev and prev[0] == x and prev[2] == w and prev[1] + prev[3] == y:
+                prev[3] += h
+            else:
+                spans.append([x, y, w, h])
+    return [tuple(s) for s in spans], sum(w * h for _, _, w, h in spans)
+
+
+def encode_delta_anim(base, anim):
+    """闭环编码差分动画，返回各帧的数据和统计"""
+    quality = int(anim.get("quality", DELTA_QUALITY))
+    threshold = int(anim.get("threshold", DELTA_THRESHOLD))
+    interval = int(anim.get("keyframe_interval", DELTA_KEYFRAME_INTERVAL))
+    ratio = float(anim.get("keyframe_ratio", DELTA_KEYFRAME_RATIO))
+    images, qtables = load_images(base, anim)
+    if "quality" in anim:
+        qtables = None
+    if not images:
+        raise ValueError("no frames in %s" % anim["name"])
+    size = images[0].size
+    area = size[0] * size[1]
+    frames = []
+    recon = None
+    since_key = 0
+    keyframes = 0
+    dirty_total = 0
+    for image in images:
+        if image.size != size:
+            raise ValueError("frame size changes inside %s" % anim["name"])
+        rects, dirty = (None, area) if recon is None else dirty_rects(image, recon, threshold)
+        if recon is None or since_key >= interval or dirty > area * ratio:
+            data = encode_jpeg(image, quality, qtables)
+            recon = decode_jpeg(data)
+            frames.append(data)
+            since_key = 1
+            keyframes += 1
+            dirty_total += area
+            continue
+        record = bytearray(DELTA.pack(JPAK_DELTA_MAGIC, len(rects), 0))
+        record += b"\0" * (PATCH.size * len(rects))
+        pad(record)
+        for i, (x, y, w, h) in enumerate(rects):
+            data = encode_jpeg(image.crop((x, y, x + w, y + h)), quality, qtables)
+            recon.paste(decode_jpeg(data), (x, y))
+            PATCH.pack_into(record, DELTA.size + i * PATCH.size, x, y, w, h, len(record), len(data))
+            record += data
+            pad(record)
+        frames.append(bytes(record))
+        since_key += 1
+        dirty_total += dirty
+    print("%s: %d frames, %d keyframes, avg dirty %d%%, %d bytes" % (anim["name"], len(frames), keyframes,
+          dirty_total * 100 // (area * len(frames)), sum(len(f) for f in frames)))
+    return frames
+
+
+def encode_plain_anim(base, anim):
+    """非差分动画：JPEG帧原样放入，GIF帧逐帧编码"""
+    if "gif" in anim:
+        quality = int(anim.get("quality", GIF_QUALITY))
+        images = load_gif(os.path.join(base, anim["gif"]), tuple(anim.get("size", FRAME_SIZE)), int(anim.get("step", 1)))
+        return [encode_jpeg(image, quality, None) for image in images]
+    size = tuple(anim.get("size", FRAME_SIZE))
+    frames = []
+    for path in list_frames(os.path.join(base, anim["frames"])):
+        with open(path, "rb") as f:
+            data = f.read()
+        check_jpeg(path, data)
+        problem = jpeg_problem(data, size)
+        if problem is not None:
+            # 沿用来源的量化表重新编码成基线4:2:0
+            Image, _, ImageOps, _ = load_pillow()
+            with Image.open(io.BytesIO(data)) as image:
+                qtables = image.quantization
+                image = ImageOps.fit(image.convert("RGB"), size)
+            print("%s: %s, re-encoded" % (path, problem))
+            data = encode_jpeg(image, GIF_QUALITY, qtables)
+        frames.append(data)
+    return frames
+
+
+def source_files(base, anim):
+    if "gif" in anim:
+        return [os.path.join(base, anim["gif"])]
+    return list_frames(os.path.join(base, anim["frames"]))
+
+
+def anim_hash(base, anim):
+    """编码结果只取决于脚本、动画参数和来源文件的内容"""
+    h = hashlib.sha256()
+    with open(os.path.abspath(__file__), "rb") as f:
+        h.update(f.read())
+    h.update(json.dumps(anim, sort_keys=True).encode("utf-8"))
+    for path in source_files(base, anim):
+        h.update(os.path.basename(path).encode("utf-8"))
+        with open(path, "rb") as f:
+            h.update(hashlib.sha256(f.read()).digest())
+    return h.hexdigest()[:16]
+
+
+def cache_load(path):
+    try:
+        with open(path, "rb") as f:
+            data = f.read()
+    except OSError:
+        return None
+    version, number = struct.unpack_from("<II", data, 0)
+    if version != CACHE_VERSION:
+        return None
+    lengths = struct.unpack_from("<%dI" % number, data, 8)
+    frames = []
+    offset = 8 + 4 * number
+    for length in lengths:
+        frames.append(data[offset:offset + length])
+        offset += length
+    return frames
+
+
+def cache_store(cache_dir, name, path, frames):
+    os.makedirs(cache_dir, exist_ok=True)
+    # 同名动画的旧缓存不会再命中
+    for old in os.listdir(cache_dir):
+        if old.startswith(name + "-") and os.path.join(cache_dir, old) != path:
+            os.remove(os.path.join(cache_dir, old))
+    with open(path + ".tmp", "wb") as f:
+        f.write(struct.pack("<II", CACHE_VERSION, len(frames)))
+        f.write(struct.pack("<%dI" % len(frames), *[len(data) for data in frames]))
+        for data in frames:
+            f.write(data)
+    os.replace(path + ".tmp", path)
+
+
+def encode_anim(base, anim, cache_dir):
+    encode = encode_delta_anim if anim.get("delta", False) else encode_plain_anim
+    if cache_dir is None:
+        return encode(base, anim)
+    path = os.path.join(cache_dir, "%s-%s.bin" % (anim["name"], anim_hash(base, anim)))
+    frames = cache_load(path)
+    if frames is not None:
+        print("%s: %d frames from cache" % (anim["name"], len(frames)))
+        return frames
+    frames = encode(base, anim)
+    cache_store(cache_dir, anim["name"], path, frames)
+    return frames
+
+
+def validate_anim(anim, frames, start):
+    """检查打包的每一帧，返回每帧的(宽, 高, MCU高度, 是否关键帧, 补丁个数)和需要单独解码的补丁的最大字节数"""
+    size = tuple(anim.get("size", FRAME_SIZE))
+    if size[0] % BLOCK_ALIGN or size[1] % BLOCK_ALIGN:
+        raise ValueError("%s: %dx%d is not a multiple of %d" % (anim["name"], size[0], size[1], BLOCK_ALIGN))
+    infos = []
+    patch_bytes = 0
+    for i, data in enumerate(frames):
+        index = start + i
+        if data[0:2] == b"\xff\xd8":
+            problem = jpeg_problem(data, size)
+            if problem is not None:
+                raise ValueError("%s frame %d: %s" % (anim["name"], index, problem))
+            infos.append((size[0], size[1], mcu_height(data), 1, 0))
+            continue
+        if not anim.get("delta", False) or i == 0:
+            raise ValueError("%s frame %d is not a jpeg" % (anim["name"], index))
+        _, patch_number, _ = DELTA.unpack_from(data, 0)
+        mcu_h = 0
+        for k in range(patch_number):
+            x, y, w, h, offset, length = PATCH.unpack_from(data, DELTA.size + k * PATCH.size)
+            patch = data[offset:offset + length]
+            problem = jpeg_problem(patch, (w, h))
+            if problem is not None or x + w > size[0] or y + h > size[1]:
+                raise ValueError("%s frame %d patch %d: %s" % (anim["name"], index, k, problem or "out of the frame"))
+            mcu_h = max(mcu_h, mcu_height(patch))
+            # 整行宽的补丁直接解码到画布
+            if x != 0 or w != size[0]:
+                patch_bytes = max(patch_bytes, w * h * 2)
+        infos.append((size[0], size[1], mcu_h, 0, patch_number))
+    return infos, patch_bytes
+
+
+def write_header(path, pack_id, anims, infos, patch_bytes):
+    """生成JpegDecoder使用的素材信息头文件"""
+    lines = [
+        "/*由process_jpg_materials/pack_jpeg_materials.py生成，不要手动修改*/",
+        "#pragma once",
+        "#include <stdint.h>",
+        "",
+        "#define JPEG_MATERIALS_PACK_ID                 (0x%08xu)      /*与JPAK头部的pack_id相同时下面的信息才适用*/" % pack_id,
+        "#define JPEG_MATERIALS_FRAME_NUMBER            (%d)" % len(infos),
+        "#define JPEG_MATERIALS_ANIM_NUMBER             (%d)" % len(anims),
+        "#define JPEG_MATERIALS_MCU_HEIGHT_MAX          (%d)           /*块模式一块的最大行数*/" % max(info[2] for info in infos),
+        "#define JPEG_MATERIALS_PATCH_BYTES_MAX         (%d)        /*宽度小于画布的补丁解码后的最大字节数(RGB565)*/" % patch_bytes,
+        "",
+    ]
+    for name, first, last, fps, _, flags in anims:
+        macro = re.sub(r"\W", "_", name.decode("utf-8")).upper()
+        lines.append("#define JPEG_MATERIALS_%s_START%s(%d)" % (macro, " " * max(1, 24 - len(macro)), first))
+        lines.append("#define JPEG_MATERIALS_%s_END%s(%d)" % (macro, " " * max(1, 26 - len(macro)), last))
+    lines += [
+        "",
+        "/*每帧的尺寸、块模式的MCU高度，差分帧的MCU高度取补丁中最大的*/",
+        "typedef struct{",
+        "    uint16_t width;",
+        "    uint16_t height;",
+        "    uint8_t mcu_height;",
+        "    uint8_t keyframe;",
+        "    uint16_t patch_number;",
+        "}jpeg_material_frame_t;",
+        "",
+        "static const jpeg_material_frame_t JPEG_MATERIALS_FRAMES[JPEG_MATERIALS_FRAME_NUMBER] = {",
+    ]
+    for i in range(0, len(infos), 6):
+        lines.append("    " + " ".join("{%d, %d, %d, %d, %d}," % info for info in infos[i:i + 6]))
+    lines += ["};", ""]
+    text = "\n".join(lines)
+    # 内容不变时不改写，避免包含它的源文件重新编译
+    try:
+        with open(path, "r", encoding="utf-8") as f:
+            if f.read() == text:
+                return
+    except OSError:
+        pass
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    with open(path, "w", encoding="utf-8", newline="\n") as f:
+        f.write(text)
+
+
+def pack(manifest_path, output_path, cache_dir=None, header_path=None):
+    base = os.path.dirname(os.path.abspath(manifest_path))
+    with open(manifest_path, "r", encoding="utf-8") as f:
+        manifest = json.load(f)
+
+    anims = []
+    frames = []
+    infos = []
+    patch_bytes = 0
+    for anim in manifest["animations"]:
+        name = anim["name"].encode("utf-8")
+        if len(name) >= JPAK_NAME_LEN:
+            raise ValueError("animation name too long: %s" % anim["name"])
+        loop = anim.get("loop", "repeat")
+        if loop not in JPAK_LOOP_MODES:
+            raise ValueError("unknown loop mode: %s" % loop)
+        if "frames" not in anim and "gif" not in anim:
+            raise ValueError("animation needs frames or gif: %s" % anim["name"])
+        start = len(frames) + 1
+        flags = JPAK_ANIM_FLAG_DELTA if anim.get("delta", False) else 0
+        encoded = encode_anim(base, anim, cache_dir)
+        anim_infos, anim_patch_bytes = validate_anim(anim, encoded, start)
+        infos += anim_infos
+        patch_bytes = max(patch_bytes, anim_patch_bytes)
+        frames += encoded
+        anims.append((name, start, len(frames), int(anim.get("fps", 15)), JPAK_LOOP_MODES[loop], flags))
+
+    anim_table_offset = HEADER.size
+    frame_table_offset = anim_table_offset + ANIM.size * len(anims)
+    key_table_offset = frame_table_offset + FRAME.size * len(frames)
+    data_offset = align(key_table_offset + len(frames))
+
+    table = []
+    payload = bytearray()
+    for data in frames:
+        table.append((data_offset + len(payload), len(data)))
+        payload += data
+        payload += b"\0" * (align(len(payload)) - len(payload))
+
+    out = bytearray()
+    out += HEADER.pack(JPAK_MAGIC, JPAK_VERSION, len(anims), len(frames),
+                       anim_table_offset, frame_table_offset, data_offset, 0, key_table_offset)
+    for anim in anims:
+        out += ANIM.pack(*anim)
+    for entry in table:
+        out += FRAME.pack(*entry)
+    # 差分动画跳转时设备从目标帧之前最近的关键帧开始叠加
+    out += bytes(info[3] for info in infos)
+    out += b"\0" * (data_offset - len(out))
+    out += payload
+    # pack_id为pack_id填0时整个容器的CRC32，设备据此对应生成的头文件
+    pack_id = zlib.crc32(out) & 0xFFFFFFFF
+    out[0:HEADER.size] = HEADER.pack(JPAK_MAGIC, JPAK_VERSION, len(anims), len(frames),
+                                     anim_table_offset, frame_table_offset, data_offset, pack_id, key_table_offset)
+
+    os.makedirs(os.path.dirname(os.path.abspath(output_path)), exist_ok=True)
+    with open(output_path, "wb") as f:
+        f.write(out)
+    if header_path is not None:
+        write_header(header_path, pack_id, anims, infos, patch_bytes)
+    print("packed %d animations, %d frames, %d bytes, id %08x -> %s" % (len(anims), len(frames), len(out), pack_id, output_path))
+
+
+def extract(gif_path, out_dir, size, quality, step):
+    """GIF取帧存成按数字编号的JPEG，替代手工导出"""
+    images = load_gif(gif_path, size, step)
+    os.makedirs(out_dir, exist_ok=True)
+    for name in os.listdir(out_dir):
+        if re.fullmatch(r"\d+\.jpe?g", name, re.I):
+            os.remove(os.path.join(out_dir, name))
+    digits = max(3, len(str(len(images) - 1)))
+    for i, image in enumerate(images):
+        with open(os.path.join(out_dir, "%0*d.jpg" % (digits, i)), "wb") as f:
+            f.write(encode_jpeg(image, quality, None))
+    print("extracted %d frames %dx%d from %s -> %s" % (len(images), size[0], size[1], gif_path, out_dir))
+
+
+def parse_size(value):
+    w, _, h = value.lower().partition("x")
+    return (int(w), int(h))
+
+
+def check_delta(data, offset, length):
+    """校验差分记录，返回补丁个数，损坏时返回-1"""
+    if length < DELTA.size or data[offset:offset + 4] != JPAK_DELTA_MAGIC:
+        return -1
+    _, patch_number, _ = DELTA.unpack_from(data, offset)
+    if DELTA.size + PATCH.size * patch_number > length:
+        return -1
+    for i in range(patch_number):
+        _, _, _, _, patch_offset, patch_length = PATCH.unpack_from(data, offset + DELTA.size + i * PATCH.size)
+        if patch_offset + patch_length > length or data[offset + patch_offset:offset + patch_offset + 2] != b"\xff\xd8":
+            return -1
+    return patch_number
+
+
+def dump(pack_path):
+    with open(pack_path, "rb") as f:
+        data = f.read()
+    magic, version, anim_number, frame_number, anim_table_offset, frame_table_offset, data_offset, pack_id, key_table_offset = \
+        HEADER.unpack_from(data, 0)
+    if magic != JPAK_MAGIC or version < 1 or version > JPAK_VERSION:
+        raise ValueError("not a JPAK v1-v%d file: %s" % (JPAK_VERSION, pack_path))
+    print("version %d, %d animations, %d frames, data at %d, id %08x" % (version, anim_number, frame_number, data_offset, pack_id))
+    loop_names = {v: k for k, v in JPAK_LOOP_MODES.items()}
+    delta_frames = set()
+    for i in range(anim_number):
+        name, start, end, fps, loop, flags = ANIM.unpack_from(data, anim_table_offset + i * ANIM.size)
+        delta = (flags & JPAK_ANIM_FLAG_DELTA) != 0
+        print("  %s: %d-%d, %dfps, %s%s" % (name.rstrip(b"\0").decode("utf-8"), start, end, fps, loop_names.get(loop, loop),
+                                            ", delta" if delta else ""))
+        if delta:
+            delta_frames.update(range(start + 1, end + 1))
+    for i in range(frame_number):
+        offset, length = FRAME.unpack_from(data, frame_table_offset + i * FRAME.size)
+        if offset + length > len(data):
+            raise ValueError("frame %d is corrupt" % (i + 1))
+        keyframe = data[offset:offset + 2] == b"\xff\xd8"
+        if version >= 3 and (key_table_offset + frame_number > len(data) or (data[key_table_offset + i] != 0) != keyframe):
+            raise ValueError("frame %d does not match the keyframe table" % (i + 1))
+        if keyframe:
+            marker = jpeg_info(data[offset:offset + length])[0]
+            if marker != 0xC0:
+                raise ValueError("frame %d is not a baseline jpeg" % (i + 1))
+            continue
+        # 差分动画的第一帧必须是关键帧
+        if (i + 1) not in delta_frames or check_delta(data, offset, length) < 0:
+            raise ValueError("frame %d is corrupt" % (i + 1))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack wallpaper JPEG frames into a JPAK container")
+    parser.add_argument("--list", action="store_true", help="print and verify an existing pack")
+    parser.add_argument("--extract", action="store_true", help="extract GIF frames into numbered JPEG files")
+    parser.add_argument("--cache", help="directory for content-hash keyed encoding results")
+    parser.add_argument("--header", help="also write the per-frame metadata header for JpegDecoder")
+    parser.add_argument("--size", type=parse_size, default=FRAME_SIZE, help="extract: frame size, e.g. 240x280")
+    parser.add_argument("--quality", type=int, default=GIF_QUALITY, help="extract: JPEG quality")
+    parser.add_argument("--step", type=int, default=1, help="extract: keep every Nth GIF frame")
+    parser.add_argument("paths", nargs="+", help="manifest.json output.jpak | pack.jpak | input.gif output_dir")
+    args = parser.parse_args()
+    if args.list:
+        dump(args.paths[0])
+    elif args.extract and len(args.paths) == 2:
+        extract(args.paths[0], args.paths[1], args.size, args.quality, args.step)
+    elif len(args.paths) == 2:
+        pack(args.paths[0], args.paths[1], args.cache, args.header)
+    else:
+        parser.error("expected a manifest and an output path")
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except (OSError, ValueError, KeyError, struct.error) as e:
+        print("error: %s" % e, file=sys.stderr)
+        sys.exit(1)
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+把lv_font_conv生成的LVGL C字库转换成LVGF字库文件，放进littlefs由fml::GlyphFont按需读取字形。
+可以只保留实际用到的字符，字形位图不再编译进固件。
+
+用法:
+    python3 pack_lvgl_font.py [--chars 字符] [--range 0x4e00-0x9fff] [--scan 源码目录] font.c output.lvgf
+    python3 pack_lvgl_font.py --list output.lvgf
+    --chars/--range/--scan可以重复，都不给时保留全部字形；--scan收集目录下C/C++源码字符串常量中的全部字符
+
+LVGF格式(小端，与GlyphFont.hpp中的lvgf_*结构体一致):
+    lvgf_header_t                  32字节
+    lvgf_glyph_t[glyph_number]     每个16字节，按unicode升序，offset为相对位图区开头的偏移
+    位图                            与lv_font_fmt_txt的PLAIN格式相同，行与行之间不按字节对齐
+只支持未压缩(bitmap_format = 0)的字库，字距调整(kern)会被丢弃。
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+
+LVGF_MAGIC = b"LVGF"
+LVGF_VERSION = 1
+
+HEADER = struct.Struct("<4sHBBhhbbHIIII")
+GLYPH = struct.Struct("<IIHBBbbH")
+
+SOURCE_EXTS = (".c", ".cpp", ".h", ".hpp")
+STRING_RE = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+
+
+def c_array(text, name):
+    m = re.search(r"\b%s\s*\[\s*\]\s*=\s*\{(.*?)\};" % re.escape(name), text, re.S)
+    if m is None:
+        raise ValueError("array %s not found" % name)
+    body = re.sub(r"/\*.*?\*/", "", m.group(1), flags=re.S)
+    return [int(v, 0) for v in re.findall(r"-?(?:0x[0-9a-fA-F]+|\d+)", body)]
+
+
+def c_field(text, name):
+    m = re.search(r"\.%s\s*=\s*(-?\w+)" % name, text)
+    if m is None:
+        raise ValueError("field .%s not found" % name)
+    return int(m.group(1), 0)
+
+
+def parse_font(path):
+    """返回(参数, {unicode: (adv_w, box_w, box_h, ofs_x, ofs_y, bitmap)})"""
+    with open(path, "r", encoding="utf-8") as f:
+        text = f.read()
+    bpp = c_field(text, "bpp")
+    if c_field(text, "bitmap_format") != 0:
+        raise ValueError("%s: only plain (uncompressed) bitmaps are supported" % path)
+    if re.search(r"\.kern_dsc\s*=\s*NULL", text) is None:
+        print("%s: kerning is dropped" % path, file=sys.stderr)
+    params = {
+        "bpp": bpp,
+        "line_height": c_field(text, "line_height"),
+        "base_line": c_field(text, "base_line"),
+        "underline_position": c_field(text, "underline_position"),
+        "underline_thickness": c_field(text, "underline_thickness"),
+    }
+
+    bitmap = bytes(c_array(text, "glyph_bitmap"))
+    dsc_body = re.search(r"glyph_dsc\s*\[\s*\]\s*=\s*\{(.*?)\};", text, re.S).group(1)
+    dscs = []
+    for m in re.finditer(r"\{([^{}]*)\}", dsc_body):
+        fields = dict((k, int(v)) for k, v in re.findall(r"\.(\w+)\s*=\s*(-?\d+)", m.group(1)))
+        dscs.append(fields)
+
+    glyphs = {}
+    cmap_body = re.search(r"cmaps\s*\[\s*\]\s*=\s*\{(.*?)\n\};", text, re.S).group(1)
+    for m in re.finditer(r"\{([^{}]*)\}", cmap_body):
+        c = m.group(1)
+        start = int(re.search(r"\.range_start\s*=\s*(\d+)", c).group(1))
+        length = int(re.search(r"\.range_length\s*=\s*(\d+)", c).group(1))
+        gid_start = int(re.search(r"\.glyph_id_start\s*=\s*(\d+)", c).group(1))
+        list_length = int(re.search(r"\.list_length\s*=\s*(\d+)", c).group(1))
+        cmap_type = re.search(r"\.type\s*=\s*(\w+)", c).group(1)
+        unicode_name = re.search(r"\.unicode_list\s*=\s*(\w+)", c).group(1)
+        ofs_name = re.search(r"\.glyph_id_ofs_list\s*=\s*(\w+)", c).group(1)
+        unicode_list = c_array(text, unicode_name) if unicode_name != "NULL" else None
+        ofs_list = c_array(text, ofs_name) if ofs_name != "NULL" else None
+        if cmap_type.endswith("FORMAT0_TINY"):
+            pairs = [(start + i, gid_start + i) for i in range(length)]
+        elif cmap_type.endswith("FORMAT0_FULL"):
+            pairs = [(start + i, gid_start + ofs_list[i]) for i in range(length)]
+        elif cmap_type.endswith("SPARSE_TINY"):
+            pairs = [(start + unicode_list[i], gid_start + i) for i in range(list_length)]
+        elif cmap_type.endswith("SPARSE_FULL"):
+            pairs = [(start + unicode_list[i], gid_start + ofs_list[i]) for i in range(list_length)]
+        else:
+            raise ValueError("%s: unknown cmap type %s" % (path, cmap_type))
+        for code, gid in pairs:
+            d = dscs[gid]
+            size = (d["box_w"] * d["box_h"] * bpp + 7) // 8
+            glyphs[code] = (d["adv_w"], d["box_w"], d["box_h"], d["ofs_x"], d["ofs_y"],
+                            bitmap[d["bitmap_index"]:d["bitmap_index"] + size])
+    # C字库编进固件的部分：位图和每个字形8字节的描述
+    params["c_bytes"] = len(bitmap) + 8 * len(dscs)
+    return params, glyphs
+
+
+def scan_chars(root):
+    chars = set()
+    for dirpath, _, filenames in os.walk(root):
+        for name in sorted(filenames):
+            if not name.endswith(SOURCE_EXTS):
+                continue
+            with open(os.path.join(dirpath, name), "r", encoding="utf-8", errors="ignore") as f:
+                for literal in STRING_RE.findall(f.read()):
+                    chars.update(ord(ch) for ch in literal if ch.isprintable())
+    return chars
+
+
+def parse_range(value):
+    lo, _, hi = value.partition("-")
+    return range(int(lo, 0), int(hi or lo, 0) + 1)
+
+
+def pack(font_path, output_path, wanted):
+    params, glyphs = parse_font(font_path)
+    codes = sorted(c for c in glyphs if wanted is None or c in wanted)
+    if wanted is not None:
+        missing = sorted(c for c in wanted if c not in glyphs and c >= 0x20)
+        if missing:
+            print("%d chars not in font: %s" % (len(missing), "".join(chr(c) for c in missing[:32])), file=sys.stderr)
+    index = bytearray()
+    data = bytearray()
+    offsets = {}
+    for code in codes:
+        adv_w, box_w, box_h, ofs_x, ofs_y, bitmap = glyphs[code]
+        # 同一个字形被多个码位引用时只存一份位图
+        if bitmap not in offsets:
+            offsets[bitmap] = len(data)
+            data += bitmap
+        index += GLYPH.pack(code, offsets[bitmap], adv_w, box_w, box_h, ofs_x, ofs_y, len(bitmap))
+    index_offset = HEADER.size
+    bitmap_offset = index_offset + len(index)
+    header = HEADER.pack(LVGF_MAGIC, LVGF_VERSION, params["bpp"], 0, params["line_height"], params["base_line"],
+                         params["underline_position"], params["underline_thickness"], 0,
+                         len(codes), index_offset, bitmap_offset, len(data))
+    os.makedirs(os.path.dirname(os.path.abspath(output_path)), exist_ok=True)
+    with open(output_path, "wb") as f:
+        f.write(header + index + data)
+    print("%s: %d/%d glyphs, %d bytes in littlefs, C font was %d bytes in flash" % (
+        os.path.basename(output_path), len(codes), len(glyphs), len(header) + len(index) + len(data), params["c_bytes"]))
+
+
+def dump(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    (magic, version, bpp, _, line_height, base_line, _, _, _,
+     number, index_offset, bitmap_offset, bitmap_size) = HEADER.unpack_from(data, 0)
+    if magic != LVGF_MAGIC or version != LVGF_VERSION:
+        sys.exit("%s: not a LVGF v%d file" % (path, LVGF_VERSION))
+    if bitmap_offset + bitmap_size != len(data) or index_offset + number * GLYPH.size != bitmap_offset:
+        sys.exit("%s: truncated" % path)
+    print("%s: bpp %d, line height %d, base line %d, %d glyphs, %d bitmap bytes" % (
+        path, bpp, line_height, base_line, number, bitmap_size))
+    last = -1
+    chars = []
+    for i in range(number):
+        code, offset, adv_w, box_w, box_h, ofs_x, ofs_y, length = GLYPH.unpack_from(data, index_offset + i * GLYPH.size)
+        if code <= last:
+            sys.exit("%s: glyph U+%04X out of order" % (path, code))
+        if offset + length > bitmap_size or length != (box_w * box_h * bpp + 7) // 8:
+            sys.exit("%s: glyph U+%04X bitmap out of range" % (path, code))
+        last = code
+        chars.append(chr(code))
+    print("".join(ch for ch in chars if ch.isprintable()))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert an LVGL C font into an on-demand LVGF glyph file")
+    parser.add_argument("--list", action="store_true", help="print and verify an existing LVGF file")
+    parser.add_argument("--chars", action="append", default=[], help="characters to keep")
+    parser.add_argument("--range", action="append", default=[], help="code point range to keep, e.g. 0x4e00-0x9fff")
+    parser.add_argument("--scan", action="append", default=[], help="keep characters used in string literals under this directory")
+    parser.add_argument("paths", nargs="+", help="font.c output.lvgf | file.lvgf")
+    args = parser.parse_args()
+
+    if args.list:
+        for path in args.paths:
+            dump(path)
+        return
+    if len(args.paths) != 2:
+        parser.error("expected font.c output.lvgf")
+    wanted = None
+    if args.chars or args.range or args.scan:
+        wanted = set()
+        for chars in args.chars:
+            wanted.update(ord(ch) for ch in chars)
+        for value in args.range:
+            wanted.update(parse_range(value))
+        for root in args.scan:
+            wanted.update(scan_chars(root))
+    pack(args.paths[0], args.paths[1], wanted)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+把LVGL转换器导出的RGB565 C数组压缩成LVGL的RLE格式，在构建时由main/CMakeLists.txt调用
+
+输出的C文件保持原来的符号名，数据布局与LVGL的lv_image_compressed_t一致：
+    uint32_t method(低4位)       LV_IMAGE_COMPRESS_RLE = 1
+    uint32_t compressed_size     RLE数据长度
+    uint32_t decompressed_size   解压后的像素数据长度
+    uint8_t  data[]              RLE数据，块大小为一个像素(2字节)
+RLE控制字节最高位为1时后面跟(ctrl & 0x7f)个原样的块，否则后面的一个块重复ctrl次
+
+用法：
+    python3 compress_lvgl_img.py input.c output.c
+    python3 compress_lvgl_img.py --check input.c        只打印压缩率并校验解压结果
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+
+LV_IMAGE_COMPRESS_RLE = 1
+LV_IMAGE_FLAGS_COMPRESSED = 0x0008
+RLE_BLK_SIZE = 2
+RLE_MAX_RUN = 127
+COMPRESSED_HEADER = "<III"
+
+MAP_RE = re.compile(r"uint8_t\s+(\w+)_map\s*\[\s*\]\s*=\s*\{(.*?)\};", re.S)
+FIELD_RE = re.compile(r"\.header\.(\w+)\s*=\s*(\w+)")
+
+
+def parse_c_array(path):
+    with open(path, "r", encoding="utf-8") as f:
+        text = f.read()
+    m = MAP_RE.search(text)
+    if m is None:
+        raise ValueError("%s: no uint8_t <name>_map[] found" % path)
+    name = m.group(1)
+    data = bytes(int(v, 16) for v in re.findall(r"0x([0-9a-fA-F]{2})", m.group(2)))
+    fields = dict(FIELD_RE.findall(text[m.end():]))
+    if fields.get("cf") != "LV_COLOR_FORMAT_RGB565":
+        raise ValueError("%s: only LV_COLOR_FORMAT_RGB565 is supported" % path)
+    w, h, stride = int(fields["w"]), int(fields["h"]), int(fields["stride"])
+    if stride != w * 2 or len(data) != stride * h:
+        raise ValueError("%s: %d bytes do not match %dx%d stride %d" % (path, len(data), w, h, stride))
+    return name, w, h, stride, data
+
+
+def rle_compress(data, blk):
+    """与lv_rle_decompress配对的编码：重复至少3个块才单独成段"""
+    blocks = [data[i:i + blk] for i in range(0, len(data), blk)]
+    out = bytearray()
+    i = 0
+    n = len(blocks)
+    while i < n:
+        run = 1
+        while i + run < n and run < RLE_MAX_RUN and blocks[i + run] == blocks[i]:
+            run += 1
+        if run >= 3:
+            out.append(run)
+            out += blocks[i]
+            i += run
+            continue
+        start = i
+        while i < n and i - start < RLE_MAX_RUN:
+            if i + 2 < n and blocks[i] == blocks[i + 1] == blocks[i + 2]:
+                break
+            i += 1
+        out.append(0x80 | (i - start))
+        for b in blocks[start:i]:
+            out += b
+    return bytes(out)
+
+
+def rle_decompress(data, blk):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        ctrl = data[i]
+        i += 1
+        if ctrl & 0x80:
+            n = (ctrl & 0x7f) * blk
+            out += data[i:i + n]
+            i += n
+        else:
+            out += data[i:i + blk] * ctrl
+            i += blk
+    return bytes(out)
+
+
+def write_c_array(path, name, w, h, stride, payload):
+    lines = []
+    for i in range(0, len(payload), 20):
+        lines.append("  " + ", ".join("0x%02x" % b for b in payload[i:i + 20]) + ",")
+    attr = "LV_ATTRIBUTE_IMAGE_" + name.upper()
+    text = """/*由process_lvgl_img/compress_lvgl_img.py生成，不要手动修改*/
+#include "lvgl.h"
+
+#ifndef LV_ATTRIBUTE_MEM_ALIGN
+#define LV_ATTRIBUTE_MEM_ALIGN
+#endif
+
+#ifndef {attr}
+#define {attr}
+#endif
+
+const LV_ATTRIBUTE_MEM_ALIGN LV_ATTRIBUTE_LARGE_CONST {attr} uint8_t {name}_map[] = {{
+{body}
+}};
+
+const lv_image_dsc_t {name} = {{
+  .header.magic = LV_IMAGE_HEADER_MAGIC,
+  .header.cf = LV_COLOR_FORMAT_RGB565,
+  .header.flags = LV_IMAGE_FLAGS_COMPRESSED,
+  .header.stride = {stride},
+  .header.w = {w},
+  .header.h = {h},
+  .data_size = sizeof({name}_map),
+  .data = {name}_map,
+}};
+""".format(attr=attr, name=name, body="\n".join(lines), stride=stride, w=w, h=h)
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    with open(path, "w", encoding="utf-8", newline="\n") as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="compress LVGL RGB565 C arrays with LVGL RLE")
+    parser.add_argument("--check", action="store_true", help="print ratio and verify only")
+    parser.add_argument("input")
+    parser.add_argument("output", nargs="?")
+    args = parser.parse_args()
+    if not args.check and args.output is None:
+        parser.error("output is required")
+
+    name, w, h, stride, data = parse_c_array(args.input)
+    rle = rle_compress(data, RLE_BLK_SIZE)
+    if rle_decompress(rle, RLE_BLK_SIZE) != data:
+        sys.exit("%s: RLE round trip failed" % args.input)
+    payload = struct.pack(COMPRESSED_HEADER, LV_IMAGE_COMPRESS_RLE, len(rle), len(data)) + rle
+    print("%s: %d -> %d bytes (%.1f%%)" % (name, len(data), len(payload), 100.0 * len(payload) / len(data)))
+    if not args.check:
+        write_c_array(args.output, name, w, h, stride, payload)
+
+
+if __name__ == "__main__":
+    main()